@@ -0,0 +1,242 @@
+/**
+ * @file bench.cpp
+ * @brief Shared by the headless benchmarks: synthetic books, timing and the report
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * The reported spread is the median absolute deviation, which a single preempted run does not
+ * skew, next to the plain standard deviation.
+ */
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <sys/stat.h>
+#include <time.h>
+
+//--------------------------------------------------------------------------------------------------
+
+bench_options_t
+parse_bench_options (int argc, char** argv, bench_options_t defaults)
+{
+    auto opt = std::move (defaults);
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        bool more = i + 1 < argc;
+        if (a == "--quick")
+        {
+            opt.quick = true;
+            opt.min_runs = std::max (3u, opt.min_runs / 10);
+            opt.min_seconds = .2;
+        }
+        else if (a == "--runs" && more)
+            opt.min_runs = unsigned (std::max (1, std::atoi (argv[++i])));
+        else if (a == "--seconds" && more)
+            opt.min_seconds = std::atof (argv[++i]);
+        else if (a == "--dir" && more)
+            opt.directory = argv[++i];
+        else
+            opt.rest.push_back (a);
+    }
+    opt.max_runs = std::max (opt.max_runs, opt.min_runs);
+    ::mkdir (opt.directory.c_str (), 0755);
+    if (opt.directory.back () != '/')
+        opt.directory += '/';
+    return opt;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string
+book_size_t::name () const
+{
+    return std::to_string (pages) + "x" + std::to_string (chars);
+}
+
+std::vector<book_size_t>
+bench_book_sizes (bench_options_t const& opt)
+{
+    if (opt.quick)
+        return { { 100, 2000 }, { 300, 8000 } };
+    return { { 100, 2000 }, { 1000, 8000 }, { 1000, 40000 } };
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+make_book (book_size_t const& size, std::uint32_t seed)
+{
+    static const char* syllables[] = {
+        "ka", "ri", "dov", "ah", "kiin", "mul", "qah", "fus", "ro", "dah", "wuld", "nah",
+        "\xc3\xa4r", "\xc3\xb6k", "sk\xc3\xa5", "ri\xc3\xb0"
+    };
+    static const char* days[] = {
+        "Sundas", "Morndas", "Tirdas", "Middas", "Turdas", "Fredas", "Loredas"
+    };
+    std::mt19937 rng (seed);
+    auto pick = [&rng] (std::size_t n) { return std::size_t (rng () % n); };
+
+    journal.pages.clear ();
+    journal.pages.resize (std::max (size.pages, 2u));
+    unsigned day = 0;
+    for (auto& p: journal.pages)
+    {
+        ++day;
+        p.title = std::string (days[day % 7]) + ", " + std::to_string (day % 30 + 1)
+            + " of Last Seed";
+        p.content.reserve (size.chars + 16);
+        unsigned words = 0;
+        while (p.content.size () < size.chars)
+        {
+            for (auto n = 1 + pick (3); n; --n)
+                p.content += syllables[pick (sizeof (syllables) / sizeof (*syllables))];
+            ++words;
+            if (words % 97 == 0)
+                p.content += ".\n\n";
+            else if (words % 13 == 0)
+                p.content += ". ";
+            else
+                p.content += ' ';
+        }
+    }
+    journal.current_page = 0;
+    journal.book_file.clear ();
+    invalidate_retained_book ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+save_takenotes_xml (const char* destination)
+{
+    std::ofstream of (destination);
+    if (!of.is_open ())
+        return false;
+    auto n = journal.pages.size ();
+    of << "<fiss>\n<Data>\n<NumberOfEntries>" << n << "</NumberOfEntries>\n";
+    for (std::size_t i = 0; i < n; ++i)
+        of << "<date" << i+1 << ">" << journal.pages[i].title << "</date" << i+1 << ">\n"
+           << "<entry" << i+1 << ">" << journal.pages[i].content << "</entry" << i+1 << ">\n";
+    of << "</Data>\n</fiss>\n";
+    return bool (of);
+}
+
+std::size_t
+book_bytes ()
+{
+    std::size_t n = 0;
+    for (auto const& p: journal.pages)
+        n += p.title.size () + p.content.size ();
+    return n;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+print_bench_header ()
+{
+    std::printf ("bench,size,bytes,runs,min_ms,median_ms,mean_ms,stddev_ms,mad_ms,mb_per_s,"
+            "cpu_median_ms\n");
+    std::fflush (stdout);
+}
+
+double
+thread_cpu_ms ()
+{
+    timespec ts;
+    ::clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static double
+median (std::vector<double> v)
+{
+    std::sort (v.begin (), v.end ());
+    auto n = v.size ();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+bench_result_t
+run_bench (bench_options_t const& opt, const char* bench, std::string const& size,
+        std::size_t bytes, std::function<void ()> const& fn)
+{
+    using clock = std::chrono::steady_clock;
+    std::fprintf (stderr, "%s %s...\n", bench, size.c_str ());
+
+    fn (); // Warm-up: caches, allocator pools and the like
+
+    std::vector<double> ms, cpu;
+    double total = 0;
+    while (ms.size () < opt.max_runs && (ms.size () < opt.min_runs || total < opt.min_seconds))
+    {
+        auto c0 = thread_cpu_ms ();
+        auto t0 = clock::now ();
+        fn ();
+        auto t = std::chrono::duration<double, std::milli> (clock::now () - t0).count ();
+        cpu.push_back (thread_cpu_ms () - c0);
+        ms.push_back (t);
+        total += t / 1000;
+    }
+    return report_bench (bench, size, bytes, ms, cpu);
+}
+
+bench_result_t
+report_bench (const char* bench, std::string const& size, std::size_t bytes,
+        std::vector<double> ms, std::vector<double> cpu)
+{
+    bench_result_t r;
+    r.bench = bench;
+    r.size = size;
+    r.bytes = bytes;
+    r.runs = unsigned (ms.size ());
+    r.min_ms = *std::min_element (ms.begin (), ms.end ());
+    r.median_ms = median (ms);
+    r.mean_ms = std::accumulate (ms.begin (), ms.end (), 0.) / ms.size ();
+    double var = 0;
+    for (auto t: ms)
+        var += (t - r.mean_ms) * (t - r.mean_ms);
+    r.stddev_ms = std::sqrt (var / ms.size ());
+    std::vector<double> dev;
+    for (auto t: ms)
+        dev.push_back (std::abs (t - r.median_ms));
+    r.mad_ms = median (dev);
+    r.cpu_median_ms = median (cpu);
+
+    double mbps = r.median_ms > 0 ? bytes / (1024. * 1024.) / (r.median_ms / 1000) : 0;
+    std::printf ("%s,%s,%zu,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f,%.4f\n", r.bench.c_str (),
+            r.size.c_str (), r.bytes, r.runs, r.min_ms, r.median_ms, r.mean_ms, r.stddev_ms,
+            r.mad_ms, mbps, r.cpu_median_ms);
+    std::fflush (stdout);
+    return r;
+}
+
+//--------------------------------------------------------------------------------------------------
+
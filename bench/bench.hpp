@@ -0,0 +1,103 @@
+/**
+ * @file bench.hpp
+ * @brief Shared by the headless benchmarks: synthetic books, timing and the report
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Each benchmark program prints one CSV row per measured case to the standard output, progress
+ * goes to the standard error. Times are per run, in milliseconds, after a warm-up run.
+ */
+
+#ifndef SSEJOURNAL_BENCH_HPP
+#define SSEJOURNAL_BENCH_HPP
+
+#include "sse-journal.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+
+struct bench_options_t
+{
+    bool quick = false;         ///< Smaller books and less runs, for a smoke test
+    unsigned min_runs = 5;
+    double min_seconds = 1.0;   ///< Keep running until both this and #min_runs are met
+    unsigned max_runs = 200;
+    std::string directory = "bench-data";
+    std::vector<std::string> rest;  ///< Not recognized by #parse_bench_options()
+};
+
+/// Common command line: --quick, --runs N, --seconds S, --dir D, over the given @param defaults
+bench_options_t parse_bench_options (int argc, char** argv, bench_options_t defaults = {});
+
+//--------------------------------------------------------------------------------------------------
+
+struct book_size_t
+{
+    unsigned pages;
+    unsigned chars;     ///< Of content per page, roughly
+    std::string name () const;
+};
+
+/// The 1000 x 40k one is the "fat book" noted in setup()
+std::vector<book_size_t> bench_book_sizes (bench_options_t const& opt);
+
+/// Replaces the journal pages with a deterministic text, mostly ASCII with some accents
+void make_book (book_size_t const& size, std::uint32_t seed = 42);
+
+/// What a Take Notes export of the current journal pages would look like
+bool save_takenotes_xml (const char* destination);
+
+/// Of titles and contents of the current journal pages
+std::size_t book_bytes ();
+
+//--------------------------------------------------------------------------------------------------
+
+struct bench_result_t
+{
+    std::string bench, size;
+    std::size_t bytes;  ///< Processed per run, for the throughput
+    unsigned runs;
+    double min_ms, median_ms, mean_ms, stddev_ms, mad_ms;
+    double cpu_median_ms;   ///< Thread CPU time, apart from the waits and the preemptions
+};
+
+/// Warm-up once, then time @param fn as set by @param opt and print the CSV row
+bench_result_t run_bench (bench_options_t const& opt, const char* bench, std::string const& size,
+        std::size_t bytes, std::function<void ()> const& fn);
+
+/// Of the calling thread, for timing apart from #run_bench()
+double thread_cpu_ms ();
+
+/// The CSV row of the run times @param ms and thread CPU times @param cpu measured elsewhere
+bench_result_t report_bench (const char* bench, std::string const& size, std::size_t bytes,
+        std::vector<double> ms, std::vector<double> cpu);
+
+/// Once, before any #run_bench()
+void print_bench_header ();
+
+//--------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file bench_io.cpp
+ * @brief Book I/O and text transforms on synthetic books of several sizes
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Runs the same code as the in game Save, Load and Wrap buttons, minus the textures: the books
+ * have no images. The directory watch of the pickers is checked first, through its polling
+ * fallback, on the same directory. Usage: bench-io [--quick] [--runs N] [--seconds S] [--dir D]
+ * > io.csv
+ */
+
+#include "bench.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+
+//--------------------------------------------------------------------------------------------------
+
+/// Adds, a rename, then a removal, each seen by the next poll as the books list would
+static bool
+check_watch (std::string const& directory)
+{
+    auto dir = directory + "watch/";
+    ::mkdir (dir.c_str (), 0755);
+    for (auto name: { "a.json", "b.json", "c.json", "d.json", "e.txt", ".json" })
+        std::remove ((dir + name).c_str ());
+    auto touch = [&dir] (const char* name) { std::ofstream (dir + name) << "{}"; };
+    touch ("a.json");
+    touch ("e.txt");
+    touch (".json");
+
+    directory_watch_t watch;
+    watch.poll_interval_ms = 0;
+    bool ok = watch.open (dir, ".json");
+    using events_t = std::vector<directory_watch_t::event_t>;
+    auto expect = [&watch, &ok] (const char* what, std::vector<std::string> const& names,
+            events_t const& events) {
+        watch.poll ();
+        bool same = watch.names () == names && watch.events ().size () == events.size ()
+            && std::equal (events.cbegin (), events.cend (), watch.events ().cbegin (),
+                    [] (auto const& a, auto const& b) {
+                        return a.action == b.action && a.name == b.name
+                            && a.old_name == b.old_name;
+                    });
+        if (!same)
+            std::fprintf (stderr, "directory_watch_t: unexpected list or events after %s.\n", what);
+        ok = ok && same;
+    };
+    expect ("the opening", { "a" }, {});
+
+    touch ("b.json");
+    touch ("c.json");
+    expect ("the adds", { "a", "b", "c" },
+            { { directory_watch_t::added, "b", {} }, { directory_watch_t::added, "c", {} } });
+
+    std::rename ((dir + "c.json").c_str (), (dir + "d.json").c_str ());
+    expect ("the rename", { "a", "b", "d" }, { { directory_watch_t::renamed, "d", "c" } });
+
+    std::remove ((dir + "a.json").c_str ());
+    std::remove ((dir + "b.json").c_str ());
+    expect ("the removals", { "d" },
+            { { directory_watch_t::removed, "a", {} }, { directory_watch_t::removed, "b", {} } });
+
+    expect ("no change", { "d" }, {});
+    return ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int
+main (int argc, char** argv)
+{
+    auto opt = parse_bench_options (argc, argv);
+    if (!check_watch (opt.directory))
+        return 1;
+    print_bench_header ();
+
+    bool ok = true;
+    for (auto const& size: bench_book_sizes (opt))
+    {
+        auto name = size.name ();
+        auto base = opt.directory + "book-" + name;
+        auto json = base + ".json", text = base + ".txt", xml = base + ".xml";
+
+        make_book (size);
+        auto bytes = book_bytes ();
+        ok = ok && save_takenotes_xml (xml.c_str ());
+
+        run_bench (opt, "save_book", name, bytes, [&] { ok = ok && save_book (json.c_str ()); });
+        run_bench (opt, "save_text", name, bytes, [&] { ok = ok && save_text (text.c_str ()); });
+        run_bench (opt, "load_book", name, bytes, [&] { ok = ok && load_book (json.c_str ()); });
+        run_bench (opt, "load_takenotes", name, bytes,
+                [&] { ok = ok && load_takenotes (xml.c_str ()); });
+
+        // Each run wraps the same unwrapped text, the result is kept aside
+        std::vector<std::string> wrapped (journal.pages.size ());
+        run_bench (opt, "greedy_word_wrap", name, bytes, [&] {
+            for (std::size_t i = 0; i < journal.pages.size (); ++i)
+                wrapped[i] = greedy_word_wrap (journal.pages[i].content, 60);
+        });
+    }
+
+    if (!ok)
+        std::fprintf (stderr, "Some of the I/O failed, the timings are not meaningful.\n");
+    return ok ? 0 : 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,231 @@
+/**
+ * @file bench_render.cpp
+ * @brief Frame times of the render path against the mock ImGui table
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * One run is one frame of render(), hence the times are the journal own cost per frame, with
+ * ImGui itself reduced to the mock. The ImGui calls and the draw list sizes per frame go to
+ * render-calls.csv in the data directory. Usage: bench-render [--quick] [--runs N] [--seconds S]
+ * [--dir D] > render.csv
+ */
+
+#include "bench.hpp"
+#include "mock_imgui.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+//--------------------------------------------------------------------------------------------------
+
+/// A way of using the journal, in frames
+struct scenario_t
+{
+    const char* name;
+    bool retained;
+    bool chapters;
+    bool timeline;  ///< Over all the pages, stamped a few hours apart
+    bool placeholders;  ///< Shown pages with fifty each, the rest of the text as it was
+    mock_input_t (*input) (unsigned frame);
+};
+
+static const scenario_t scenarios[] = {
+    { "idle", true, false, false, false, [] (unsigned) { return mock_input_t {}; } },
+    { "idle_not_retained", false, false, false, false, [] (unsigned) { return mock_input_t {}; } },
+    { "flip", true, false, false, false, [] (unsigned frame) {
+        mock_input_t in;
+        in.click = frame % 2 ? "Prev" : "Next";
+        return in;
+    }},
+    { "type", true, false, false, false, [] (unsigned) {
+        mock_input_t in;
+        in.type_into = "##Left text";
+        return in;
+    }},
+    { "chapters", true, true, false, false, [] (unsigned frame) {
+        mock_input_t in;
+        in.list_scroll = int (frame);
+        return in;
+    }},
+    { "timeline", true, false, true, false, [] (unsigned frame) {
+        mock_input_t in;
+        in.list_scroll = int (frame);
+        return in;
+    }},
+    { "placeholders", true, false, false, true, [] (unsigned) { return mock_input_t {}; } },
+    { "placeholders_not_retained", false, false, false, true, [] (unsigned) {
+        return mock_input_t {};
+    }},
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/// The journal fonts as load_settings() makes them by default, then built on this thread
+static bool
+setup_fonts (bench_options_t const& opt)
+{
+    extern const char* font_viner_hand;
+    extern const char* font_inconsolata;
+    struct { font_t* font; const char* name; float size; const char* data; } defaults[] = {
+        { &journal.button_font, "button", 36.f, font_viner_hand },
+        { &journal.chapter_font, "chapter", 54.f, font_viner_hand },
+        { &journal.text_font, "text", 36.f, font_viner_hand },
+        { &journal.default_font, "system", 18.f, font_inconsolata },
+    };
+    fonts_cache_location = opt.directory + "fonts.cache";
+    for (auto const& d: defaults)
+    {
+        d.font->name = d.name;
+        d.font->size = d.size;
+        d.font->file = "";
+        d.font->glyphs = "used";
+        d.font->default_data = d.data;
+        add_font (*d.font);
+    }
+    return build_fonts ();
+}
+
+/// Each frame asks for a text font of a size not seen yet, so every build misses the cache: in
+/// the background as the settings UI does, or as a blocking build on the render thread would
+static void
+bench_fonts (bench_options_t const& opt, std::ofstream& calls)
+{
+    auto size = bench_book_sizes (opt).front ();
+    make_book (size);
+    journal.current_page = unsigned (journal.pages.size ()) / 2;
+    retained_book = true;
+
+    unsigned frames = 0;
+    auto resize = [&frames] {
+        journal.text_font.size = 36.f + (frames % 10000) * .001f;
+        add_font (journal.text_font);
+    };
+    // The frames swapping a set in, which are all what the render thread does of a build
+    std::vector<double> install_ms, install_cpu;
+    run_bench (opt, "fonts_rebuild", size.name (), 0, [&] {
+        using clock = std::chrono::steady_clock;
+        auto before = journal.text_font.imfont;
+        resize ();
+        auto c0 = thread_cpu_ms ();
+        auto t0 = clock::now ();
+        mock_frame ();
+        if (journal.text_font.imfont != before)
+        {
+            install_ms.push_back (
+                    std::chrono::duration<double, std::milli> (clock::now () - t0).count ());
+            install_cpu.push_back (thread_cpu_ms () - c0);
+        }
+        ++frames;
+    });
+    if (!install_ms.empty ())
+        report_bench ("fonts_install", size.name (), 0, install_ms, install_cpu);
+    calls << "fonts_rebuild," << size.name () << ",(fonts installed),"
+          << double (install_ms.size ()) / frames << '\n';
+
+    auto blocking = opt;
+    blocking.min_runs = std::min (blocking.min_runs, 20u);
+    run_bench (blocking, "fonts_blocking", size.name (), 0, [&] {
+        resize ();
+        build_fonts ();
+        mock_frame ();
+        ++frames;
+    });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int
+main (int argc, char** argv)
+{
+    bench_options_t defaults;
+    defaults.min_runs = 2000;
+    defaults.max_runs = 20000;
+    auto opt = parse_bench_options (argc, argv, defaults);
+
+    install_mock_imgui ();
+    journal.variables = make_variables (); // For the placeholders
+    std::ofstream calls (opt.directory + "render-calls.csv");
+    calls << "bench,size,what,per_frame\n";
+    print_bench_header ();
+
+    for (auto const& size: bench_book_sizes (opt))
+    {
+        auto name = size.name ();
+        for (auto const& s: scenarios)
+        {
+            make_book (size);
+            journal.current_page = unsigned (journal.pages.size ()) / 2;
+            journal.show_chapters = s.chapters;
+            journal.show_timeline = s.timeline;
+            for (unsigned i = 0; s.timeline && i < journal.pages.size (); ++i)
+                journal.pages[i].written = 1 + i * .125f;
+            invalidate_chronology ();
+            for (unsigned i = 0; s.placeholders && i < 2; ++i)
+            {
+                auto& page = journal.pages[journal.current_page + i];
+                page.title = "{local_time:%x}";
+                std::string text;
+                auto step = std::max<std::size_t> (page.content.size () / 50, 1);
+                for (std::size_t at = 0; at < page.content.size (); at += step)
+                    text += page.content.substr (at, step) + " {local_time} ";
+                page.content = text;
+            }
+            retained_book = s.retained;
+
+            reset_mock_calls ();
+            unsigned frames = 0;
+            run_bench (opt, s.name, name, 0, [&] { mock_frame (s.input (frames++)); });
+
+            for (auto const& c: mock_calls ())
+                if (c.calls)
+                    calls << s.name << ',' << name << ',' << c.name << ','
+                          << double (c.calls) / frames << '\n';
+            auto g = mock_geometry ();
+            calls << s.name << ',' << name << ",(draw lists)," << g.lists << '\n'
+                  << s.name << ',' << name << ",(commands)," << g.cmds << '\n'
+                  << s.name << ',' << name << ",(vertices)," << g.vertices << '\n'
+                  << s.name << ',' << name << ",(indices)," << g.indices << '\n';
+        }
+    }
+    journal.show_chapters = false;
+    journal.show_timeline = false;
+    retained_book = true;
+
+    if (!setup_fonts (opt))
+    {
+        std::fprintf (stderr, "The fonts failed to build with the mock device.\n");
+        return 1;
+    }
+    bench_fonts (opt, calls);
+
+    if (!calls)
+    {
+        std::fprintf (stderr, "Unable to write %srender-calls.csv\n", opt.directory.c_str ());
+        return 1;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,233 @@
+/**
+ * @file bench_replay.cpp
+ * @brief Frame times of recorded input replayed through the mock ImGui table
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * One run is the whole recording replayed on a fresh book, frame by frame, so its time is the
+ * sum of the frame times. The book reset is left out. Without recordings given, a scripted
+ * one is made against the mock layout and written to replay.rec in the data directory, which
+ * also checks the record format round trip. Per frame medians and maximums go to
+ * replay-frames.csv. Usage: bench-replay [--quick] [--runs N] [--seconds S] [--dir D]
+ * [input.rec...] > replay.csv
+ */
+
+#include "bench.hpp"
+#include "mock_imgui.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+//--------------------------------------------------------------------------------------------------
+
+/// Appends frames as the overlay would have captured them, the book window staying put
+struct script_t
+{
+    std::vector<input_frame_t> frames;
+    input_frame_t now = {};
+
+    script_t ()
+    {
+        now.delta_time = 1.f / 60;
+        now.display_size = ImVec2 { 1920, 1080 };
+        now.mouse_pos = ImVec2 { -1e6f, -1e6f };
+        now.window_pos = ImVec2 { 40, 30 };
+        now.window_size = ImVec2 { 1200, 800 };
+    }
+
+    void wait (unsigned n)
+    {
+        for (unsigned i = 0; i < n; ++i)
+            frames.push_back (now);
+    }
+
+    void click (ImVec2 at)
+    {
+        now.mouse_pos = at;
+        wait (1);
+        now.mouse_down = 1;
+        wait (1);
+        now.mouse_down = 0;
+        wait (1);
+    }
+
+    void type (const char* text)
+    {
+        for (; *text; ++text)
+        {
+            now.chars.assign (1, ImWchar (*text));
+            wait (1);
+        }
+        now.chars.clear ();
+    }
+
+    void scroll (ImVec2 at, float wheel, unsigned n)
+    {
+        now.mouse_pos = at;
+        now.wheel = wheel;
+        wait (n);
+        now.wheel = 0;
+    }
+};
+
+/// Types into the left page, flips a few pages back and forth, scrolls the chapters
+static std::vector<input_frame_t>
+scripted_input ()
+{
+    journal.show_chapters = true;
+    auto chapters_list = mock_locate ("##Chapters");
+    journal.show_chapters = false;
+    auto left = mock_locate ("##Left text");
+    auto next = mock_locate ("Next"), prev = mock_locate ("Prev");
+    auto chapters = mock_locate ("Chapters");
+
+    script_t s;
+    s.wait (30);
+    s.click (left);
+    s.type ("Dear diary, today I met a dragon. It did not go well. ");
+    s.wait (30);
+    for (unsigned i = 0; i < 5; ++i)
+        s.click (next), s.wait (10);
+    for (unsigned i = 0; i < 5; ++i)
+        s.click (prev), s.wait (10);
+    s.click (chapters);
+    s.scroll (chapters_list, -1, 60);
+    s.scroll (chapters_list, 1, 60);
+    s.click (chapters);
+    s.wait (30);
+    return s.frames;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Times each frame of a run, on a book reset beforehand
+static void
+replay (book_size_t const& size, std::vector<input_frame_t> const& frames,
+        std::vector<double>& frame_ms, double& cpu_ms)
+{
+    using clock = std::chrono::steady_clock;
+    make_book (size);
+    journal.current_page = unsigned (journal.pages.size ()) / 2;
+    journal.show_chapters = false;
+    reset_mock_input ();
+
+    frame_ms.clear ();
+    auto c0 = thread_cpu_ms ();
+    for (auto const& f: frames)
+    {
+        mock_input_t in;
+        in.io = &f;
+        auto t0 = clock::now ();
+        mock_frame (in);
+        frame_ms.push_back (std::chrono::duration<double, std::milli> (clock::now () - t0)
+                .count ());
+    }
+    cpu_ms = thread_cpu_ms () - c0;
+}
+
+int
+main (int argc, char** argv)
+{
+    bench_options_t defaults;
+    defaults.min_runs = 20;
+    auto opt = parse_bench_options (argc, argv, defaults);
+
+    install_mock_imgui ();
+    std::ofstream per_frame (opt.directory + "replay-frames.csv");
+    per_frame << "bench,size,frame,median_ms,max_ms\n";
+    print_bench_header ();
+
+    for (auto const& size: bench_book_sizes (opt))
+    {
+        auto name = size.name ();
+        std::vector<std::pair<std::string, std::vector<input_frame_t>>> records;
+        if (opt.rest.empty ())
+        {
+            make_book (size);
+            auto scripted = scripted_input ();
+            auto file = opt.directory + "replay.rec";
+            records.emplace_back ("scripted", std::vector<input_frame_t> {});
+            if (!write_input_record (file, scripted)
+                    || !read_input_record (file, records.back ().second)
+                    || records.back ().second.size () != scripted.size ())
+            {
+                std::fprintf (stderr, "The record round trip through %s failed.\n", file.c_str ());
+                return 1;
+            }
+        }
+        for (auto const& file: opt.rest)
+        {
+            records.emplace_back (file.substr (file.find_last_of ("/\\") + 1),
+                    std::vector<input_frame_t> {});
+            if (!read_input_record (file, records.back ().second))
+            {
+                std::fprintf (stderr, "Unable to read %s.\n", file.c_str ());
+                return 1;
+            }
+        }
+
+        for (auto const& r: records)
+        {
+            auto const& frames = r.second;
+            if (frames.empty ())
+                continue;
+            std::fprintf (stderr, "%s %s...\n", r.first.c_str (), name.c_str ());
+
+            std::vector<double> frame_ms, ms, cpu;
+            std::vector<std::vector<double>> by_frame (frames.size ());
+            double cpu_ms, total = 0;
+            replay (size, frames, frame_ms, cpu_ms); // Warm-up
+            while (ms.size () < opt.max_runs
+                    && (ms.size () < opt.min_runs || total < opt.min_seconds))
+            {
+                replay (size, frames, frame_ms, cpu_ms);
+                double t = 0;
+                for (std::size_t i = 0; i < frame_ms.size (); ++i)
+                    by_frame[i].push_back (frame_ms[i]), t += frame_ms[i];
+                ms.push_back (t);
+                cpu.push_back (cpu_ms);
+                total += t / 1000;
+            }
+            report_bench (r.first.c_str (), name, 0, ms, cpu);
+
+            for (std::size_t i = 0; i < by_frame.size (); ++i)
+            {
+                auto& v = by_frame[i];
+                std::sort (v.begin (), v.end ());
+                per_frame << r.first << ',' << name << ',' << i << ',' << v[v.size () / 2] << ','
+                          << v.back () << '\n';
+            }
+        }
+    }
+
+    if (!per_frame)
+    {
+        std::fprintf (stderr, "Unable to write %sreplay-frames.csv\n", opt.directory.c_str ());
+        return 1;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,132 @@
+/**
+ * @file bench_sdf.cpp
+ * @brief Signed distance fields of the SDF fonts, checked on a known bitmap and timed per face
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * The check is a square, hard edged but for one anti-aliased pixel, inside a larger atlas: the
+ * values at and around the edges are known, the field is symmetric, and nothing outside of the
+ * given rectangle is written. A run is then a face of glyph cells, as fonts.cpp rasterizes them.
+ * Usage: bench-sdf [--quick] [--runs N] [--seconds S] > sdf.csv
+ */
+
+#include "bench.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr int spread = 4;   ///< As sdf_spread in fonts.cpp
+
+/// A 16 pixels square at 8,8 of a 32x32 rectangle at 4,2 of a 40x36 atlas, zero elsewhere
+static bool
+check_square ()
+{
+    constexpr int stride = 40, rows = 36, x0 = 4, y0 = 2, n = 32;
+    std::vector<unsigned char> src (stride * rows, 0), dst (stride * rows, 7);
+    auto at = [] (std::vector<unsigned char>& v, int x, int y) -> unsigned char& {
+        return v[std::size_t (y0 + y) * stride + x0 + x];
+    };
+    for (int y = 8; y < 24; ++y)
+        for (int x = 8; x < 24; ++x)
+            at (src, x, y) = 255;
+    at (src, 8, 4 + 8) = 191; // Sub-pixel edge, a quarter of a pixel inside
+
+    make_sdf (src.data (), dst.data (), stride, x0, y0, n, n, spread);
+
+    bool ok = true;
+    auto expect = [&] (int x, int y, int value, const char* what) {
+        if (at (dst, x, y) == value)
+            return;
+        std::fprintf (stderr, "make_sdf: %s at %d,%d is %d, not %d.\n",
+                what, x, y, at (dst, x, y), value);
+        ok = false;
+    };
+    expect (16, 16, 255, "center");
+    expect (0, 0, 0, "corner");
+    expect (8, 16, 143, "inner edge");        // Half a pixel inside, 128 + .5 * 127/4
+    expect (7, 16, 112, "outer edge");        // Half a pixel outside
+    expect (6, 16, 80, "outer edge + 1");
+    expect (8, 12, 135, "anti-aliased edge"); // 191/255 - .5 of a pixel inside
+
+    // Mirrored around the square center, but for the anti-aliased pixel
+    for (int y = 0; y < n; ++y)
+        for (int x = 0; x < n; ++x)
+            if (!(x == 8 && y == 12) && !(x == 12 && y == 8) && !(x == 23 && y == 12))
+            {
+                if (at (dst, x, y) != at (dst, n-1 - x, y) || at (dst, x, y) != at (dst, y, x))
+                {
+                    std::fprintf (stderr, "make_sdf: not symmetric at %d,%d.\n", x, y);
+                    return false;
+                }
+            }
+    for (int y = 0; y < rows; ++y)
+        for (int x = 0; x < stride; ++x)
+            if ((x < x0 || y < y0 || x >= x0 + n || y >= y0 + n)
+                    && dst[std::size_t (y) * stride + x] != 7)
+            {
+                std::fprintf (stderr, "make_sdf: wrote outside of the rectangle at %d,%d.\n",
+                        x, y);
+                return false;
+            }
+    return ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int
+main (int argc, char** argv)
+{
+    auto opt = parse_bench_options (argc, argv);
+    if (!check_square ())
+        return 1;
+
+    print_bench_header ();
+    // Cells of 48 pixels glyphs with their spread, with noisy coverage for the edges
+    constexpr int cell = 48 + 2 * spread, columns = 16;
+    for (int glyphs: { 96, opt.quick ? 0 : 1024 })
+    {
+        if (!glyphs)
+            continue;
+        int width = cell * columns, height = cell * ((glyphs + columns - 1) / columns);
+        std::vector<unsigned char> src (std::size_t (width) * height), dst (src.size ());
+        std::srand (42);
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+            {
+                int cx = x % cell - cell / 2, cy = y % cell - cell / 2;
+                int r2 = cx*cx + cy*cy, edge = (cell / 3) * (cell / 3);
+                src[std::size_t (y) * width + x] = r2 < edge - 40 ? 255
+                    : r2 > edge + 40 ? 0 : static_cast<unsigned char> (std::rand () & 255);
+            }
+        run_bench (opt, "make_sdf", std::to_string (glyphs), src.size (), [&] {
+            for (int g = 0; g < glyphs; ++g)
+                make_sdf (src.data (), dst.data (), width,
+                        (g % columns) * cell, (g / columns) * cell, cell, cell, spread);
+        });
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,150 @@
+/**
+ * @file bench_variables.cpp
+ * @brief Evaluation costs of the Journal Variables, built-in and of the plugin providers
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * A run is a number of evaluations of one variable. The providers are registered through the
+ * public API table, as another plugin would, and taken as render() would. Their
+ * evaluation stands in for a game lookup of about a microsecond. The formats are checked first
+ * for the longest token matching, as the game time ones share their prefixes. Usage:
+ * bench-variables [--quick] [--runs N] [--seconds S] > variables.csv
+ */
+
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+//--------------------------------------------------------------------------------------------------
+
+/// Busy for the given nanoseconds, then prints the gold count
+static std::int32_t SSEJOURNAL_CCONV
+slow_gold (void* context, char const* params, char* buffer, std::uint32_t capacity)
+{
+    using clock = std::chrono::steady_clock;
+    auto until = clock::now () + std::chrono::nanoseconds (*static_cast<int*> (context));
+    while (clock::now () < until)
+        ;
+    char value[64];
+    int n = std::snprintf (value, sizeof (value), "%s 1234", params);
+    std::memcpy (buffer, value, std::min<std::size_t> (std::size_t (n), capacity));
+    return n;
+}
+
+/// Tokens of the game time, which is read of the game memory, so only its format is checked
+static bool
+check_formats ()
+{
+    static const char* const tokens[] = {
+        "y", "Y", "lm", "bm", "am", "mo", "md", "sd", "ld", "wd", "h", "m", "s", "ri", "r" };
+    constexpr std::size_t count = sizeof (tokens) / sizeof (*tokens);
+    std::string names[count];
+    std::string_view values[count];
+    for (std::size_t i = 0; i < count; ++i)
+        values[i] = names[i] = std::string ("<") + tokens[i] + '>';
+
+    const char* cases[][2] = {
+        { "%m %md %mo", "<m> <md> <mo>" },
+        { "%s %sd %sx", "<s> <sd> <s>x" },
+        { "%r %ri %rim", "<r> <ri> <ri>m" },
+        { "%h:%m:%s", "<h>:<m>:<s>" },
+        { "%q %%m %", "%q %<m> %" },
+    };
+    format_t format;
+    for (auto const& c: cases)
+    {
+        compile_format (format, c[0], tokens, count);
+        expand_format (format, values, format.out);
+        if (format.out != c[1])
+        {
+            std::fprintf (stderr, "Format \"%s\" expanded to \"%s\", not \"%s\".\n",
+                    c[0], format.out.c_str (), c[1]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static variable_t*
+find_variable (const char* name)
+{
+    for (auto& v: journal.variables)
+        if (v.name == name)
+            return &v;
+    return nullptr;
+}
+
+int
+main (int argc, char** argv)
+{
+    auto opt = parse_bench_options (argc, argv);
+    unsigned evaluations = opt.quick ? 1000 : 10000;
+    if (!check_formats ())
+        return 1;
+
+    journal.variables = make_variables ();
+    static int lookup_ns = 1000;
+    auto api = make_journal_api ();
+    ssejournal_provider gold = { "Gold", "The septims carried", "Gold:", 0.f, slow_gold,
+        &lookup_ns };
+    ssejournal_provider cached = gold;
+    cached.name = "Gold (cached)";
+    cached.ttl = 1.f;
+    if (!api.register_provider (&gold) || !api.register_provider (&cached))
+    {
+        std::fprintf (stderr, "Unable to register the providers.\n");
+        return 1;
+    }
+    std::vector<std::shared_ptr<provider_t>> providers;
+    take_providers (providers);
+    for (auto& p: providers)
+        add_provider (std::move (p));
+
+    print_bench_header ();
+    auto size = std::to_string (evaluations);
+    const char* cases[][2] = {
+        { "local_time", "Local time (fixed)" },
+        { "provider", "Gold" },
+        { "provider_cached", "Gold (cached)" }
+    };
+    for (auto const& c: cases)
+    {
+        auto bench = c[0], name = c[1];
+        auto var = find_variable (name);
+        if (!var)
+        {
+            std::fprintf (stderr, "No variable named %s.\n", name);
+            return 1;
+        }
+        std::size_t bytes = 0;
+        run_bench (opt, bench, size, 0, [var, evaluations, &bytes] {
+            for (unsigned i = 0; i < evaluations; ++i)
+                bytes += (*var) ().size ();
+        });
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,99 @@
+/**
+ * @file d3d11.h
+ * @brief Headless stand-in: the Direct3D 11 subset the journal sources compile against
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Only for the Linux benchmark builds, see windows.h.
+ */
+
+#ifndef JOURNAL_HEADLESS_D3D11_H
+#define JOURNAL_HEADLESS_D3D11_H
+
+#include <windows.h>
+#include <cstddef>
+
+struct IUnknown
+{
+    virtual unsigned long AddRef () = 0;
+    virtual unsigned long Release () = 0;
+};
+
+struct ID3D11Device;
+struct ID3D11ClassInstance;
+struct ID3D11ClassLinkage;
+
+struct ID3D11DeviceChild : IUnknown
+{
+    virtual void GetDevice (ID3D11Device**) = 0;
+};
+
+struct ID3D11Resource : ID3D11DeviceChild {};
+struct ID3D11Texture2D : ID3D11Resource {};
+struct ID3D11ShaderResourceView : ID3D11DeviceChild {};
+struct ID3D11PixelShader : ID3D11DeviceChild {};
+
+struct ID3D11DeviceContext : ID3D11DeviceChild
+{
+    virtual void PSSetShader (ID3D11PixelShader*, ID3D11ClassInstance* const*, UINT) = 0;
+    virtual void PSGetShader (ID3D11PixelShader**, ID3D11ClassInstance**, UINT*) = 0;
+};
+
+typedef enum { DXGI_FORMAT_R8G8B8A8_UNORM = 28, DXGI_FORMAT_R8_UNORM = 61 } DXGI_FORMAT;
+typedef enum { D3D11_USAGE_DEFAULT = 0, D3D11_USAGE_IMMUTABLE = 1 } D3D11_USAGE;
+
+#define D3D11_BIND_SHADER_RESOURCE 8
+#define D3D11_SRV_DIMENSION_TEXTURE2D 4
+
+struct DXGI_SAMPLE_DESC { UINT Count, Quality; };
+
+struct D3D11_TEXTURE2D_DESC
+{
+    UINT Width, Height, MipLevels, ArraySize;
+    DXGI_FORMAT Format;
+    DXGI_SAMPLE_DESC SampleDesc;
+    D3D11_USAGE Usage;
+    UINT BindFlags, CPUAccessFlags, MiscFlags;
+};
+
+struct D3D11_SUBRESOURCE_DATA { const void* pSysMem; UINT SysMemPitch, SysMemSlicePitch; };
+struct D3D11_TEX2D_SRV { UINT MostDetailedMip, MipLevels; };
+
+struct D3D11_SHADER_RESOURCE_VIEW_DESC
+{
+    DXGI_FORMAT Format;
+    int ViewDimension;
+    union { D3D11_TEX2D_SRV Texture2D; };
+};
+
+struct ID3D11Device : IUnknown
+{
+    virtual HRESULT CreateTexture2D (D3D11_TEXTURE2D_DESC const*, D3D11_SUBRESOURCE_DATA const*,
+            ID3D11Texture2D**) = 0;
+    virtual HRESULT CreateShaderResourceView (ID3D11Resource*,
+            D3D11_SHADER_RESOURCE_VIEW_DESC const*, ID3D11ShaderResourceView**) = 0;
+    virtual HRESULT CreatePixelShader (const void*, std::size_t, ID3D11ClassLinkage*,
+            ID3D11PixelShader**) = 0;
+    virtual void GetImmediateContext (ID3D11DeviceContext**) = 0;
+};
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * @file d3dcompiler.h
+ * @brief Headless stand-in: the shader compiler entry point type, loaded at run-time
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Only for the Linux benchmark builds, see windows.h.
+ */
+
+#ifndef JOURNAL_HEADLESS_D3DCOMPILER_H
+#define JOURNAL_HEADLESS_D3DCOMPILER_H
+
+#include <d3d11.h>
+
+struct ID3DBlob : IUnknown
+{
+    virtual void* GetBufferPointer () = 0;
+    virtual std::size_t GetBufferSize () = 0;
+};
+
+struct D3D_SHADER_MACRO;
+struct ID3DInclude;
+
+typedef HRESULT (*pD3DCompile) (const void*, std::size_t, LPCSTR, D3D_SHADER_MACRO const*,
+        ID3DInclude*, LPCSTR, LPCSTR, UINT, UINT, ID3DBlob**, ID3DBlob**);
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file plugin.cpp
+ * @brief Headless stand-in for what skse.cpp provides to the rest of the journal
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * The API tables stay empty, so anything reaching SSE-ImGui or SSE-Hooks must be either avoided
+ * by the benchmarks or filled in by them (e.g. a mock ImGui table).
+ */
+
+#include "sse-journal.hpp"
+#include <sse-hooks/sse-hooks.h>
+
+#include <array>
+
+//--------------------------------------------------------------------------------------------------
+
+sseimgui_api sseimgui = {};
+sseh_api sseh = {};
+imgui_api imgui = {};
+
+//--------------------------------------------------------------------------------------------------
+
+void
+journal_version (int* maj, int* min, int* patch, const char** timestamp)
+{
+    constexpr std::array<int, 3> ver = {
+#include "../../VERSION"
+    };
+    if (maj) *maj = ver[0];
+    if (min) *min = ver[1];
+    if (patch) *patch = ver[2];
+    if (timestamp) *timestamp = JOURNAL_TIMESTAMP;
+}
+
+//--------------------------------------------------------------------------------------------------
+
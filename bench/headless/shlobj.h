@@ -0,0 +1,39 @@
+/**
+ * @file shlobj.h
+ * @brief Headless stand-in: known folders lookup
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Only for the Linux benchmark builds, see windows.h.
+ */
+
+#ifndef JOURNAL_HEADLESS_SHLOBJ_H
+#define JOURNAL_HEADLESS_SHLOBJ_H
+
+#include <windows.h>
+
+struct GUID { unsigned long data; };
+typedef GUID const& REFKNOWNFOLDERID;
+
+HRESULT SHGetKnownFolderPath (REFKNOWNFOLDERID, DWORD, HANDLE, PWSTR*);
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ * @file win32.cpp
+ * @brief Headless stand-in: the Win32 functions the linked journal code calls
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Just enough to keep the journal sources going on Linux: UTF-8 conversions for the file names,
+ * file attributes through stat(), and no DLLs, no known folders, no crash handler.
+ */
+
+#include <windows.h>
+#include <shlobj.h>
+#include <knownfolders.h>
+
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+
+//--------------------------------------------------------------------------------------------------
+
+GUID const FOLDERID_Documents = {};
+
+//--------------------------------------------------------------------------------------------------
+
+/// wchar_t is UTF-32 here, sizes are in elements, same contract as the Win32 ones
+
+int
+MultiByteToWideChar (UINT, DWORD, const char* bytes, int size, wchar_t* out, int out_size)
+{
+    auto p = reinterpret_cast<const unsigned char*> (bytes);
+    auto end = p + (size < 0 ? std::strlen (bytes) + 1 : std::size_t (size));
+    int n = 0;
+    while (p < end)
+    {
+        char32_t c = *p++;
+        int extra = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+        c &= extra ? 0x3f >> extra : 0x7f;
+        for (; extra && p < end; --extra)
+            c = (c << 6) | (*p++ & 0x3f);
+        if (out_size && n < out_size)
+            out[n] = wchar_t (c);
+        ++n;
+    }
+    return out_size && n > out_size ? 0 : n;
+}
+
+int
+WideCharToMultiByte (UINT, DWORD, const wchar_t* wide, int size, char* out, int out_size,
+        const char*, BOOL*)
+{
+    auto end = wide + (size < 0 ? std::wcslen (wide) + 1 : std::size_t (size));
+    std::string s;
+    for (auto p = wide; p < end; ++p)
+    {
+        auto c = char32_t (*p);
+        if (c < 0x80)
+            s += char (c);
+        else if (c < 0x800)
+            s += char (0xc0 | c >> 6), s += char (0x80 | (c & 0x3f));
+        else if (c < 0x10000)
+            s += char (0xe0 | c >> 12), s += char (0x80 | (c >> 6 & 0x3f)),
+            s += char (0x80 | (c & 0x3f));
+        else
+            s += char (0xf0 | c >> 18), s += char (0x80 | (c >> 12 & 0x3f)),
+            s += char (0x80 | (c >> 6 & 0x3f)), s += char (0x80 | (c & 0x3f));
+    }
+    if (!out_size)
+        return int (s.size ());
+    if (int (s.size ()) > out_size)
+        return 0;
+    s.copy (out, s.size ());
+    return int (s.size ());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+DWORD
+GetFileAttributesW (LPCWSTR file)
+{
+    std::string name (WideCharToMultiByte (CP_UTF8, 0, file, -1, nullptr, 0, nullptr, nullptr),
+            '\0');
+    WideCharToMultiByte (CP_UTF8, 0, file, -1, &name[0], int (name.size ()), nullptr, nullptr);
+    struct stat st;
+    if (::stat (name.c_str (), &st) != 0)
+        return INVALID_FILE_ATTRIBUTES;
+    return S_ISDIR (st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+HMODULE GetModuleHandle (LPCWSTR) { return nullptr; }
+HMODULE LoadLibraryW (LPCWSTR) { return nullptr; }
+BOOL FreeLibrary (HMODULE) { return FALSE; }
+void* GetProcAddress (HMODULE, LPCSTR) { return nullptr; }
+
+HRESULT SHGetKnownFolderPath (REFKNOWNFOLDERID, DWORD, HANDLE, PWSTR*) { return -1; }
+void CoTaskMemFree (void*) {}
+
+LPTOP_LEVEL_EXCEPTION_FILTER
+SetUnhandledExceptionFilter (LPTOP_LEVEL_EXCEPTION_FILTER)
+{
+    return nullptr;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,75 @@
+/**
+ * @file windows.h
+ * @brief Headless stand-in: the Win32 subset the journal sources compile against
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Only for the Linux benchmark builds, see bench/README.md. Declarations only, the few functions
+ * which the linked code actually calls are defined in win32.cpp.
+ */
+
+#ifndef JOURNAL_HEADLESS_WINDOWS_H
+#define JOURNAL_HEADLESS_WINDOWS_H
+
+#include <cstdint>
+#include <cwchar>
+
+#define WINAPI
+#define __declspec(x)
+
+typedef unsigned long DWORD;
+typedef long LONG;
+typedef int BOOL;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef long HRESULT;
+typedef unsigned int UINT;
+typedef wchar_t TCHAR;
+typedef wchar_t* PWSTR;
+typedef wchar_t* LPTSTR;
+typedef const wchar_t* LPCWSTR;
+typedef const char* LPCSTR;
+
+#define S_OK 0
+#define TRUE 1
+#define FALSE 0
+#define MAX_PATH 260
+#define CP_UTF8 65001
+#define INVALID_FILE_ATTRIBUTES ((DWORD) -1)
+#define FILE_ATTRIBUTE_DIRECTORY 0x10
+#define FILE_ATTRIBUTE_NORMAL 0x80
+
+struct EXCEPTION_POINTERS;
+typedef LONG (WINAPI* LPTOP_LEVEL_EXCEPTION_FILTER) (EXCEPTION_POINTERS*);
+#define EXCEPTION_CONTINUE_SEARCH 0
+
+int MultiByteToWideChar (UINT, DWORD, const char*, int, wchar_t*, int);
+int WideCharToMultiByte (UINT, DWORD, const wchar_t*, int, char*, int, const char*, BOOL*);
+DWORD GetFileAttributesW (LPCWSTR);
+HMODULE GetModuleHandle (LPCWSTR);
+HMODULE LoadLibraryW (LPCWSTR);
+BOOL FreeLibrary (HMODULE);
+void* GetProcAddress (HMODULE, LPCSTR);
+void CoTaskMemFree (void*);
+LPTOP_LEVEL_EXCEPTION_FILTER SetUnhandledExceptionFilter (LPTOP_LEVEL_EXCEPTION_FILTER);
+
+#endif
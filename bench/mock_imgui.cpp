@@ -0,0 +1,1087 @@
+/**
+ * @file mock_imgui.cpp
+ * @brief Stand-in ImGui table for driving the render path without SSE-ImGui
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Each mocked slot is a captureless lambda, counting through a per slot index which the
+ * #MOCK() macro registers together with the slot name. The metrics are fixed: 7 pixels per
+ * glyph, 17 per line, 20 per frame (widget) height, no matter the font.
+ *
+ * Items are laid out from the cursor, top to bottom unless on the same line, and hit tested
+ * against the mouse: a release over a button presses it, a click into a text input activates it
+ * and the queued characters go into the active one. The book window is where the input says,
+ * the others sit next to it so they never overlap.
+ */
+
+#include "mock_imgui.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr float glyph_width = 7, line_height = 17, frame_height = 20, spacing = 4, padding = 8;
+constexpr ImVec2 other_size = { 420, 480 };
+
+struct mock_list_t
+{
+    ImDrawList list;
+    std::vector<ImDrawCmd> cmds;
+    std::vector<ImDrawVert> vtx;
+    std::vector<ImDrawIdx> idx;
+    std::vector<ImVec4> clips;
+    std::vector<ImTextureID> textures;
+    ImVec2 pos, size;
+    ImVec2 parent_cursor;   ///< Of child windows, where the parent goes on
+    unsigned frame;
+};
+
+static struct
+{
+    std::vector<mock_calls_t> calls;
+    std::unordered_map<ImGuiID, std::unique_ptr<mock_list_t>> lists;
+    std::vector<mock_list_t*> stack;    ///< Current window last
+    unsigned frame;
+    mock_input_t input;
+    ImGuiIO io;
+    std::vector<ImWchar> chars; ///< Of this frame, for the active input
+    std::vector<ImWchar> typed_queue;   ///< Behind ImGuiIO::InputQueueCharacters
+    std::uint8_t mouse_down;    ///< Of the previous frame
+    ImGuiID active;             ///< Input being typed into, zero if none
+    bool focus_next;            ///< igSetKeyboardFocusHere(), activates the next input
+    ImVec2 book_pos, book_size;
+    ImVec2 next_pos, next_size; ///< Of the next window, zero if not set
+    ImVec2 cursor;              ///< Relative to the current window
+    ImVec2 line_end;            ///< Top right of the last item, for igSameLine()
+    ImVec4 item;                ///< Last item, in screen space
+    ImGuiID item_id;
+    float next_width;
+    int scroll;                 ///< Of the list boxes
+    std::string locate;         ///< Label of the item to look for
+    ImVec2 located;             ///< Its center, once found
+    std::uint64_t sink;         ///< Keeps the text scans from being optimized away
+}
+mock = {};
+
+/// Per slot, where it counts in mock.calls
+template<auto Slot>
+static std::size_t slot_index = 0;
+
+static std::size_t
+register_slot (const char* name)
+{
+    mock.calls.push_back (mock_calls_t { name, 0 });
+    return mock.calls.size () - 1;
+}
+
+#define MOCK(fn, ...) \
+    (slot_index<&imgui_api::fn> = register_slot (#fn), imgui.fn = __VA_ARGS__)
+#define COUNT(fn) \
+    (++mock.calls[slot_index<&imgui_api::fn>].calls)
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<mock_calls_t> const&
+mock_calls ()
+{
+    return mock.calls;
+}
+
+void
+reset_mock_calls ()
+{
+    for (auto& c: mock.calls)
+        c.calls = 0;
+}
+
+mock_geometry_t
+mock_geometry ()
+{
+    mock_geometry_t g = {};
+    for (auto const& l: mock.lists)
+        if (l.second->frame == mock.frame)
+        {
+            ++g.lists;
+            g.cmds += l.second->cmds.size ();
+            g.vertices += l.second->vtx.size ();
+            g.indices += l.second->idx.size ();
+        }
+    return g;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static ImGuiID
+hash_id (const char* s)
+{
+    ImGuiID h = 2166136261u;
+    for (; *s; ++s)
+        h = (h ^ std::uint8_t (*s)) * 16777619u;
+    return h;
+}
+
+static bool
+same_label (const char* label, std::string const& wanted)
+{
+    if (wanted.empty ())
+        return false;
+    auto end = std::strstr (label, "##");
+    auto n = end && end != label ? std::size_t (end - label) : std::strlen (label);
+    return n == wanted.size () && !std::memcmp (label, wanted.data (), n);
+}
+
+static bool
+hovered ()
+{
+    auto const& m = mock.io.MousePos;
+    return m.x >= mock.item.x && m.y >= mock.item.y && m.x < mock.item.z && m.y < mock.item.w;
+}
+
+/// Notes where the last item is, if it is the one looked for
+static void
+locate (const char* label)
+{
+    if (!same_label (label, mock.locate))
+        return;
+    mock.located = ImVec2 { (mock.item.x + mock.item.z) / 2, (mock.item.y + mock.item.w) / 2 };
+    mock.locate.clear ();
+}
+
+/// By a mouse release over it, or once by the label given in the input
+static bool
+clicked (const char* label)
+{
+    locate (label);
+    if (hovered () && mock.io.MouseReleased[0])
+        return true;
+    if (!same_label (label, mock.input.click))
+        return false;
+    mock.input.click.clear ();
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+sync_list (mock_list_t& l)
+{
+    l.list.CmdBuffer = { int (l.cmds.size ()), int (l.cmds.capacity ()), l.cmds.data () };
+    l.list.VtxBuffer = { int (l.vtx.size ()), int (l.vtx.capacity ()), l.vtx.data () };
+    l.list.IdxBuffer = { int (l.idx.size ()), int (l.idx.capacity ()), l.idx.data () };
+}
+
+/// As ImDrawList::UpdateClipRect() and UpdateTextureID() do, reuse an empty command or add one
+static void
+update_cmd (mock_list_t& l)
+{
+    auto& c = l.cmds.back ();
+    if (c.ElemCount || c.UserCallback)
+        l.cmds.push_back (ImDrawCmd {});
+    l.cmds.back ().ClipRect = l.clips.back ();
+    l.cmds.back ().TextureId = l.textures.back ();
+    sync_list (l);
+}
+
+static mock_list_t&
+current_list ()
+{
+    return *mock.stack.back ();
+}
+
+/// Also of windows already ended, as the child of a text box
+static mock_list_t&
+list_of (ImDrawList const* dl)
+{
+    for (auto const& p: mock.lists)
+        if (&p.second->list == dl)
+            return *p.second;
+    return current_list ();
+}
+
+/// Windows and child frames, each one is cleared on its first use in a frame
+static void
+begin_list (ImGuiID id, ImVec2 pos, ImVec2 size)
+{
+    auto& p = mock.lists[id];
+    if (!p)
+    {
+        p = std::make_unique<mock_list_t> ();
+        p->vtx.reserve (1 << 16);
+        p->idx.reserve (3 << 15);
+        p->frame = mock.frame - 1;
+    }
+    if (p->frame != mock.frame)
+    {
+        p->frame = mock.frame;
+        p->cmds.clear ();
+        p->vtx.clear ();
+        p->idx.clear ();
+        p->clips.assign (1, ImVec4 { pos.x, pos.y, pos.x + size.x, pos.y + size.y });
+        p->textures.assign (1, nullptr);
+        p->cmds.push_back (ImDrawCmd { 0, p->clips.back (), nullptr, nullptr, nullptr });
+        p->list._VtxCurrentIdx = 0;
+        sync_list (*p);
+    }
+    p->pos = pos;
+    p->size = size;
+    mock.stack.push_back (p.get ());
+    mock.cursor = ImVec2 { padding, padding };
+}
+
+/// The parent cursor goes on below the child
+static void
+end_list (ImVec2 cursor)
+{
+    if (!mock.stack.empty ())
+        mock.stack.pop_back ();
+    mock.cursor = cursor;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+prim_reserve (mock_list_t& l, int idx_count, int vtx_count)
+{
+    if (l.cmds.back ().UserCallback)
+        update_cmd (l);
+    l.cmds.back ().ElemCount += idx_count;
+    auto v = l.vtx.size (), i = l.idx.size ();
+    l.vtx.resize (v + vtx_count);
+    l.idx.resize (i + idx_count);
+    sync_list (l);
+    l.list._VtxWritePtr = l.vtx.data () + v;
+    l.list._IdxWritePtr = l.idx.data () + i;
+}
+
+static void
+add_quad (mock_list_t& l, ImVec2 a, ImVec2 b, ImVec2 uv_a, ImVec2 uv_b, ImU32 col)
+{
+    prim_reserve (l, 6, 4);
+    auto& d = l.list;
+    auto n = ImDrawIdx (d._VtxCurrentIdx);
+    d._VtxWritePtr[0] = ImDrawVert { a, uv_a, col };
+    d._VtxWritePtr[1] = ImDrawVert { ImVec2 { b.x, a.y }, ImVec2 { uv_b.x, uv_a.y }, col };
+    d._VtxWritePtr[2] = ImDrawVert { b, uv_b, col };
+    d._VtxWritePtr[3] = ImDrawVert { ImVec2 { a.x, b.y }, ImVec2 { uv_a.x, uv_b.y }, col };
+    ImDrawIdx q[6] = { n, ImDrawIdx (n+1), ImDrawIdx (n+2), n, ImDrawIdx (n+2), ImDrawIdx (n+3) };
+    std::memcpy (d._IdxWritePtr, q, sizeof (q));
+    d._VtxWritePtr += 4;
+    d._IdxWritePtr += 6;
+    d._VtxCurrentIdx += 4;
+}
+
+static void
+add_image (mock_list_t& l, ImTextureID tex, ImVec2 a, ImVec2 b, ImVec2 uv_a, ImVec2 uv_b,
+        ImU32 col)
+{
+    bool push = tex != l.textures.back ();
+    if (push)
+        l.textures.push_back (tex), update_cmd (l);
+    add_quad (l, a, b, uv_a, uv_b, col);
+    if (push)
+        l.textures.pop_back (), update_cmd (l);
+}
+
+/// Lays out the next item at the cursor, true if the mouse is over it
+static bool
+item (ImVec2 size, ImGuiID id = 0)
+{
+    auto& l = current_list ();
+    ImVec2 a = { l.pos.x + mock.cursor.x, l.pos.y + mock.cursor.y };
+    mock.item = ImVec4 { a.x, a.y, a.x + size.x, a.y + size.y };
+    mock.item_id = id;
+    mock.line_end = ImVec2 { mock.cursor.x + size.x, mock.cursor.y };
+    mock.cursor = ImVec2 { padding, mock.cursor.y + size.y + spacing };
+    return hovered ();
+}
+
+/// Negative is up to the right edge less that much, zero is @param automatic
+static float
+item_width (float width, float automatic)
+{
+    auto& l = current_list ();
+    if (width < 0)
+        return std::max (l.size.x - mock.cursor.x + width - padding, 1.f);
+    return width > 0 ? width : automatic;
+}
+
+/// One quad per glyph of the last item, at most as many as fit in it
+static void
+add_text (const char* text, const char* end)
+{
+    auto& l = current_list ();
+    auto n = std::size_t (end - text);
+    auto cols = std::max<std::size_t> (std::size_t ((mock.item.z - mock.item.x) / glyph_width), 1);
+    auto rows = std::max<std::size_t> (std::size_t ((mock.item.w - mock.item.y) / line_height), 1);
+    auto shown = std::min (n, cols * rows);
+    for (std::size_t i = 0; i < shown; ++i)
+    {
+        if (text[i] == ' ' || text[i] == '\n')
+            continue;
+        float x = mock.item.x + (i % cols) * glyph_width;
+        float y = mock.item.y + (i / cols) * line_height;
+        add_quad (l, ImVec2 { x, y }, ImVec2 { x + glyph_width, y + line_height },
+                ImVec2 {}, ImVec2 { 1, 1 }, IM_COL32_WHITE);
+    }
+}
+
+static void
+add_label (const char* text, const char* end)
+{
+    item (ImVec2 { (end - text) * glyph_width, line_height });
+    add_text (text, end);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// A click over the text input activates it, ImGui does so on the press
+static bool
+input_item (ImGuiID id, ImVec2 size)
+{
+    if ((item (size, id) && mock.io.MouseClicked[0]) || mock.focus_next)
+        mock.active = id;
+    mock.focus_next = false;
+    return mock.active == id;
+}
+
+/// Appends the queued characters, through the resize callback as ImGui would
+static bool
+type_into (char* buf, std::size_t buf_size, ImGuiInputTextFlags flags,
+        ImGuiInputTextCallback callback, void* user)
+{
+    if (mock.chars.empty () || (flags & ImGuiInputTextFlags_ReadOnly))
+        return false;
+    std::string typed;
+    for (auto c: mock.chars)
+    {
+        if ((flags & ImGuiInputTextFlags_CallbackCharFilter) && callback)
+        {
+            // Every character typed or pasted, as InputTextFilterCharacter() does
+            ImGuiInputTextCallbackData d = {};
+            d.EventFlag = ImGuiInputTextFlags_CallbackCharFilter;
+            d.Flags = flags;
+            d.UserData = user;
+            d.EventChar = c;
+            if (callback (&d))
+                continue;
+            c = d.EventChar;
+        }
+        if (c < 0x80)
+            typed += char (c);
+        else if (c < 0x800)
+            typed += char (0xc0 | c >> 6), typed += char (0x80 | (c & 0x3f));
+        else
+            typed += char (0xe0 | c >> 12), typed += char (0x80 | ((c >> 6) & 0x3f)),
+            typed += char (0x80 | (c & 0x3f));
+    }
+    mock.chars.clear ();
+
+    auto len = std::strlen (buf);
+    if (len + typed.size () + 1 > buf_size
+            && (flags & ImGuiInputTextFlags_CallbackResize) && callback)
+    {
+        ImGuiInputTextCallbackData d = {};
+        d.EventFlag = ImGuiInputTextFlags_CallbackResize;
+        d.Flags = flags;
+        d.UserData = user;
+        d.Buf = buf;
+        d.BufTextLen = int (len);
+        d.BufSize = int (len + typed.size () + 1);
+        callback (&d);
+        buf = d.Buf;
+        buf_size = std::size_t (d.BufSize);
+    }
+    if (len + typed.size () + 1 > buf_size)
+        return false;
+    std::memcpy (buf + len, typed.c_str (), typed.size () + 1);
+    return true;
+}
+
+/// Inactive boxes still measure the whole text, hence a line count over the buffer
+static std::size_t
+scan_text (const char* buf, std::size_t& lines)
+{
+    auto len = std::strlen (buf);
+    lines = 1;
+    for (auto p = buf; (p = static_cast<const char*> (std::memchr (p, '\n', buf + len - p)));)
+        ++p, ++lines;
+    return len;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// C variadic, not possible as a lambda
+static void
+mock_text (const char* fmt, ...)
+{
+    COUNT (igText);
+    char buf[1024];
+    va_list args;
+    va_start (args, fmt);
+    auto n = std::vsnprintf (buf, sizeof (buf), fmt, args);
+    va_end (args);
+    add_label (buf, buf + std::min<std::size_t> (std::max (n, 0), sizeof (buf) - 1));
+}
+
+static void
+install_windows ()
+{
+    MOCK (igBegin, [] (const char* name, bool*, ImGuiWindowFlags) {
+        COUNT (igBegin);
+        if (!std::strcmp (name, "SSE Journal"))
+        {
+            if (mock.next_size.x > 0 && mock.next_size.y > 0)
+                mock.book_pos = mock.next_pos, mock.book_size = mock.next_size;
+            begin_list (hash_id (name), mock.book_pos, mock.book_size);
+        }
+        else
+            begin_list (hash_id (name), ImVec2 {
+                    mock.book_pos.x + mock.book_size.x + padding, mock.book_pos.y }, other_size);
+        mock.next_pos = mock.next_size = ImVec2 {};
+        return true;
+    });
+    MOCK (igEnd, [] { COUNT (igEnd); end_list (ImVec2 {}); });
+    MOCK (igSetNextWindowPos, [] (const ImVec2 pos, ImGuiCond cond, const ImVec2) {
+        COUNT (igSetNextWindowPos);
+        if (cond == ImGuiCond_Always)
+            mock.next_pos = pos;
+    });
+    MOCK (igSetNextWindowSize, [] (const ImVec2 size, ImGuiCond cond) {
+        COUNT (igSetNextWindowSize);
+        if (cond == ImGuiCond_Always)
+            mock.next_size = size;
+    });
+    // Only ever the child of a text box entered ahead of it, see igInputTextMultiline
+    MOCK (igBeginChildFrame, [] (ImGuiID id, const ImVec2 size, ImGuiWindowFlags) {
+        COUNT (igBeginChildFrame);
+        auto const& l = current_list ();
+        auto cursor = mock.cursor;
+        begin_list (id, ImVec2 { l.pos.x + cursor.x, l.pos.y + cursor.y }, size);
+        current_list ().parent_cursor = ImVec2 { padding, cursor.y + size.y + spacing };
+        return true;
+    });
+    MOCK (igEndChildFrame, [] {
+        COUNT (igEndChildFrame);
+        end_list (current_list ().parent_cursor);
+    });
+    MOCK (igBeginChild, [] (const char* name, const ImVec2 size, bool, ImGuiWindowFlags) {
+        COUNT (igBeginChild);
+        auto const& l = current_list ();
+        auto cursor = mock.cursor;
+        ImVec2 pos = { l.pos.x + cursor.x, l.pos.y + cursor.y };
+        ImVec2 area = { size.x > 0 ? size.x : l.size.x - cursor.x - padding,
+                        size.y > 0 ? size.y : l.size.y - cursor.y - padding };
+        begin_list (hash_id (name), pos, area);
+        current_list ().parent_cursor = ImVec2 { padding, cursor.y + area.y + spacing };
+        return true;
+    });
+    MOCK (igEndChild, [] { COUNT (igEndChild); end_list (current_list ().parent_cursor); });
+    MOCK (igGetWindowDrawList, [] { COUNT (igGetWindowDrawList); return &current_list ().list; });
+    MOCK (igGetWindowPos, [] { COUNT (igGetWindowPos); return current_list ().pos; });
+    MOCK (igGetWindowSize, [] { COUNT (igGetWindowSize); return current_list ().size; });
+    MOCK (igGetWindowHeight, [] { COUNT (igGetWindowHeight); return current_list ().size.y; });
+    MOCK (igGetContentRegionAvail, [] {
+        COUNT (igGetContentRegionAvail);
+        auto const& l = current_list ();
+        return ImVec2 { l.size.x - mock.cursor.x - padding, l.size.y - mock.cursor.y - padding };
+    });
+    MOCK (igGetIDStr, [] (const char* s) { COUNT (igGetIDStr); return hash_id (s); });
+    MOCK (igGetIO, [] { COUNT (igGetIO); return &mock.io; });
+    MOCK (igIsAnyItemActive, [] { COUNT (igIsAnyItemActive); return mock.active != 0; });
+    MOCK (igIsItemActive, [] {
+        COUNT (igIsItemActive);
+        return mock.item_id && mock.item_id == mock.active;
+    });
+    MOCK (igIsItemHovered, [] (ImGuiHoveredFlags) { COUNT (igIsItemHovered); return hovered (); });
+    MOCK (igIsItemDeactivatedAfterEdit, [] { COUNT (igIsItemDeactivatedAfterEdit); return false; });
+    MOCK (igIsPopupOpen, [] (const char*) { COUNT (igIsPopupOpen); return false; });
+    MOCK (igGetMouseCursor, [] { COUNT (igGetMouseCursor); return ImGuiMouseCursor (0); });
+    MOCK (igGetFrameHeight, [] { COUNT (igGetFrameHeight); return frame_height; });
+    MOCK (igGetFontSize, [] { COUNT (igGetFontSize); return line_height - 1; });
+    MOCK (igGetTextLineHeight, [] { COUNT (igGetTextLineHeight); return line_height - 2; });
+    MOCK (igGetTextLineHeightWithSpacing, [] {
+        COUNT (igGetTextLineHeightWithSpacing);
+        return line_height;
+    });
+    MOCK (igCalcTextSize, [] (const char* text, const char* end, bool, float) {
+        COUNT (igCalcTextSize);
+        auto n = end ? end - text : std::strlen (text);
+        return ImVec2 { n * glyph_width, line_height - 1 };
+    });
+    MOCK (igSetCursorPos, [] (const ImVec2 pos) { COUNT (igSetCursorPos); mock.cursor = pos; });
+    MOCK (igGetCursorPos, [] { COUNT (igGetCursorPos); return mock.cursor; });
+    MOCK (igSameLine, [] (float, float) {
+        COUNT (igSameLine);
+        mock.cursor = ImVec2 { mock.line_end.x + padding, mock.line_end.y };
+    });
+    MOCK (igSetKeyboardFocusHere, [] (int) {
+        COUNT (igSetKeyboardFocusHere);
+        mock.focus_next = true;
+    });
+    MOCK (igSetNextItemWidth, [] (float width) {
+        COUNT (igSetNextItemWidth);
+        mock.next_width = width;
+    });
+}
+
+static void
+install_draw_lists ()
+{
+    MOCK (ImDrawList_AddImage, [] (ImDrawList*, ImTextureID tex, const ImVec2 a, const ImVec2 b,
+                const ImVec2 uv_a, const ImVec2 uv_b, ImU32 col) {
+        COUNT (ImDrawList_AddImage);
+        add_image (current_list (), tex, a, b, uv_a, uv_b, col);
+    });
+    MOCK (ImDrawList_AddRect, [] (ImDrawList*, const ImVec2 a, const ImVec2 b, ImU32 col,
+                float, int, float t) {
+        COUNT (ImDrawList_AddRect);
+        auto& l = current_list ();
+        add_quad (l, a, ImVec2 { b.x, a.y + t }, ImVec2 {}, ImVec2 {}, col);
+        add_quad (l, ImVec2 { b.x - t, a.y }, b, ImVec2 {}, ImVec2 {}, col);
+        add_quad (l, ImVec2 { a.x, b.y - t }, b, ImVec2 {}, ImVec2 {}, col);
+        add_quad (l, a, ImVec2 { a.x + t, b.y }, ImVec2 {}, ImVec2 {}, col);
+    });
+    MOCK (ImDrawList_AddCallback, [] (ImDrawList* dl, ImDrawCallback cb, void* data) {
+        COUNT (ImDrawList_AddCallback);
+        auto& l = list_of (dl);
+        if (l.cmds.back ().ElemCount || l.cmds.back ().UserCallback)
+            l.cmds.push_back (ImDrawCmd { 0, l.clips.back (), l.textures.back () });
+        l.cmds.back ().UserCallback = cb;
+        l.cmds.back ().UserCallbackData = data;
+        l.cmds.push_back (ImDrawCmd { 0, l.clips.back (), l.textures.back () });
+        sync_list (l);
+    });
+    MOCK (ImDrawList_PushClipRect, [] (ImDrawList*, ImVec2 a, ImVec2 b, bool) {
+        COUNT (ImDrawList_PushClipRect);
+        auto& l = current_list ();
+        l.clips.push_back (ImVec4 { a.x, a.y, b.x, b.y });
+        update_cmd (l);
+    });
+    MOCK (ImDrawList_PopClipRect, [] (ImDrawList*) {
+        COUNT (ImDrawList_PopClipRect);
+        auto& l = current_list ();
+        l.clips.pop_back ();
+        update_cmd (l);
+    });
+    MOCK (ImDrawList_PushTextureID, [] (ImDrawList*, ImTextureID tex) {
+        COUNT (ImDrawList_PushTextureID);
+        auto& l = current_list ();
+        l.textures.push_back (tex);
+        update_cmd (l);
+    });
+    MOCK (ImDrawList_PopTextureID, [] (ImDrawList*) {
+        COUNT (ImDrawList_PopTextureID);
+        auto& l = current_list ();
+        l.textures.pop_back ();
+        update_cmd (l);
+    });
+    MOCK (ImDrawList_PrimReserve, [] (ImDrawList*, int idx_count, int vtx_count) {
+        COUNT (ImDrawList_PrimReserve);
+        prim_reserve (current_list (), idx_count, vtx_count);
+    });
+}
+
+static void
+install_widgets ()
+{
+    MOCK (igButton, [] (const char* label, const ImVec2 size) {
+        COUNT (igButton);
+        auto end = std::strstr (label, "##");
+        if (!end)
+            end = label + std::strlen (label);
+        item (ImVec2 { item_width (size.x, (end - label) * glyph_width + 2 * padding),
+                       size.y > 0 ? size.y : frame_height });
+        add_quad (current_list (), ImVec2 { mock.item.x, mock.item.y },
+                ImVec2 { mock.item.z, mock.item.w }, ImVec2 {}, ImVec2 {}, IM_COL32_BLACK);
+        add_text (label, end);
+        return clicked (label);
+    });
+    MOCK (igInvisibleButton, [] (const char* label, const ImVec2 size) {
+        COUNT (igInvisibleButton);
+        item (size);
+        return clicked (label);
+    });
+    MOCK (igTextUnformatted, [] (const char* text, const char* end) {
+        COUNT (igTextUnformatted);
+        add_label (text, end ? end : text + std::strlen (text));
+    });
+    MOCK (igText, mock_text);
+    MOCK (igInputText, [] (const char* label, char* buf, std::size_t buf_size,
+                ImGuiInputTextFlags flags, ImGuiInputTextCallback callback, void* user) {
+        COUNT (igInputText);
+        auto width = item_width (mock.next_width, current_list ().size.x * .65f);
+        mock.next_width = 0;
+        bool changed = input_item (hash_id (label), ImVec2 { width, frame_height })
+            && type_into (buf, buf_size, flags, callback, user);
+        locate (label);
+        add_text (buf, buf + std::strlen (buf));
+        return changed;
+    });
+    MOCK (igInputTextMultiline, [] (const char* label, char* buf, std::size_t buf_size,
+                const ImVec2 size, ImGuiInputTextFlags flags, ImGuiInputTextCallback callback,
+                void* user) {
+        COUNT (igInputTextMultiline);
+        auto id = hash_id (label);
+        bool changed = input_item (id, size) && type_into (buf, buf_size, flags, callback, user);
+        locate (label);
+        auto box = mock.item;
+        auto cursor = mock.cursor;
+        begin_list (id, ImVec2 { box.x, box.y }, size);
+        mock.item = box;
+        std::size_t lines;
+        auto len = scan_text (buf, lines);
+        mock.sink += lines;
+        add_text (buf, buf + len);
+        end_list (cursor);
+        mock.item = box;
+        mock.item_id = id;
+        return changed;
+    });
+    MOCK (igSelectable, [] (const char* label, bool, ImGuiSelectableFlags, const ImVec2 size) {
+        COUNT (igSelectable);
+        auto end = std::strstr (label, "##");
+        if (!end)
+            end = label + std::strlen (label);
+        item (ImVec2 { item_width (size.x, current_list ().size.x - 2 * padding),
+                       size.y > 0 ? size.y : line_height });
+        add_text (label, end);
+        return clicked (label);
+    });
+    MOCK (igInputInt, [] (const char* label, int*, int, int, ImGuiInputTextFlags) {
+        COUNT (igInputInt);
+        item (ImVec2 { item_width (mock.next_width, 100), frame_height });
+        mock.next_width = 0;
+        locate (label);
+        return false;
+    });
+    // As ImGui does for a known item height: one step, the rows in view from the scroll on
+    MOCK (ImGuiListClipper_Begin, [] (ImGuiListClipper* c, int count, float height) {
+        COUNT (ImGuiListClipper_Begin);
+        *c = ImGuiListClipper { mock.cursor.y, height, count, 0, -1, -1 };
+    });
+    MOCK (ImGuiListClipper_Step, [] (ImGuiListClipper* c) {
+        COUNT (ImGuiListClipper_Step);
+        if (c->StepNo++ || c->ItemsCount <= 0 || c->ItemsHeight <= 0)
+        {
+            c->ItemsCount = -1;
+            return false;
+        }
+        auto rows = int (current_list ().size.y / c->ItemsHeight) + 1;
+        c->DisplayStart = mock.scroll % c->ItemsCount;
+        c->DisplayEnd = std::min (c->ItemsCount, c->DisplayStart + rows);
+        return true;
+    });
+    MOCK (igListBoxFnPtr, [] (const char* label, int* current,
+                bool (*getter) (void*, int, const char**), void* data, int count, int height) {
+        COUNT (igListBoxFnPtr);
+        auto width = item_width (0, current_list ().size.x * .65f);
+        bool over = item (ImVec2 { width, height * line_height + 2 * padding });
+        locate (label);
+        auto list = mock.item;
+        if (over && mock.io.MouseWheel)
+            mock.scroll = std::max (0, mock.scroll - int (mock.io.MouseWheel * 3));
+        int first = count ? mock.scroll % count : 0;
+        bool changed = false;
+        for (int i = first; i < count && i < first + height; ++i)
+        {
+            float y = list.y + padding + (i - first) * line_height;
+            mock.item = ImVec4 { list.x, y, list.z, y + line_height };
+            if (hovered () && mock.io.MouseReleased[0])
+                *current = i, changed = true;
+            const char* text = nullptr;
+            if (getter (data, i, &text) && text)
+                add_text (text, text + std::strlen (text));
+        }
+        mock.item = list;
+        return changed;
+    });
+    MOCK (igColorConvertU32ToFloat4, [] (ImU32 c) {
+        COUNT (igColorConvertU32ToFloat4);
+        constexpr float k = 1.f / 255;
+        return ImVec4 { (c & 0xff) * k, ((c >> 8) & 0xff) * k, ((c >> 16) & 0xff) * k,
+                        (c >> 24) * k };
+    });
+    MOCK (igColorConvertFloat4ToU32, [] (const ImVec4 v) {
+        COUNT (igColorConvertFloat4ToU32);
+        auto b = [] (float f) { return ImU32 (std::min (std::max (f, 0.f), 1.f) * 255 + .5f); };
+        return b (v.x) | b (v.y) << 8 | b (v.z) << 16 | b (v.w) << 24;
+    });
+    MOCK (igGetColorU32Vec4, [] (const ImVec4 v) {
+        COUNT (igGetColorU32Vec4);
+        return imgui.igColorConvertFloat4ToU32 (v);
+    });
+}
+
+/// Counted, with no effect and a zero result
+template<class F>
+struct mock_default_t;
+
+template<class R, class... A>
+struct mock_default_t<R (*) (A...)>
+{
+    template<auto Slot>
+    static R call (A...) { ++mock.calls[slot_index<Slot>].calls; return R (); }
+};
+
+template<class R, class... A>
+struct mock_default_t<R (*) (A..., ...)>
+{
+    template<auto Slot>
+    static R call (A..., ...) { ++mock.calls[slot_index<Slot>].calls; return R (); }
+};
+
+#define MOCK_DEFAULT(fn) \
+    MOCK (fn, &mock_default_t<decltype (imgui_api::fn)>::call<&imgui_api::fn>)
+
+//--------------------------------------------------------------------------------------------------
+
+/// ImVector::push_back() of the C API structures
+template<class V, class T>
+static void
+vector_push (V& v, T const& value)
+{
+    if (v.Size == v.Capacity)
+    {
+        v.Capacity = v.Capacity ? v.Capacity * 2 : 8;
+        v.Data = static_cast<T*> (std::realloc (v.Data, sizeof (T) * v.Capacity));
+    }
+    v.Data[v.Size++] = value;
+}
+
+/// ImVector::resize() and fill
+template<class V, class T>
+static void
+vector_assign (V& v, int size, T const& value)
+{
+    if (size > v.Capacity)
+    {
+        v.Capacity = size;
+        v.Data = static_cast<T*> (std::realloc (v.Data, sizeof (T) * v.Capacity));
+    }
+    v.Size = size;
+    std::fill_n (v.Data, size, value);
+}
+
+/// Only the detached fonts and their atlas, the glyph lookups built as ImGui does
+static void
+install_fonts ()
+{
+    MOCK (ImFontConfig_ImFontConfig, [] {
+        COUNT (ImFontConfig_ImFontConfig);
+        return new ImFontConfig {};
+    });
+    MOCK (ImFontAtlas_ImFontAtlas, [] {
+        COUNT (ImFontAtlas_ImFontAtlas);
+        return new ImFontAtlas {};
+    });
+    MOCK (ImFontAtlas_destroy, [] (ImFontAtlas* atlas) {
+        COUNT (ImFontAtlas_destroy);
+        delete atlas;
+    });
+    MOCK (ImFontAtlas_SetTexID, [] (ImFontAtlas* atlas, ImTextureID id) {
+        COUNT (ImFontAtlas_SetTexID);
+        atlas->TexID = id;
+    });
+    MOCK (ImFont_ImFont, [] {
+        COUNT (ImFont_ImFont);
+        auto f = new ImFont {};
+        f->FallbackChar = '?';
+        f->Scale = 1;
+        return f;
+    });
+    MOCK (ImFont_destroy, [] (ImFont* f) {
+        COUNT (ImFont_destroy);
+        std::free (f->Glyphs.Data);
+        std::free (f->IndexAdvanceX.Data);
+        std::free (f->IndexLookup.Data);
+        delete f;
+    });
+    MOCK (ImFont_AddGlyph, [] (ImFont* f, ImWchar c, float x0, float y0, float x1, float y1,
+                float u0, float v0, float u1, float v1, float advance) {
+        COUNT (ImFont_AddGlyph);
+        vector_push (f->Glyphs, ImFontGlyph { c, advance, x0, y0, x1, y1, u0, v0, u1, v1 });
+    });
+    MOCK (ImFont_SetFallbackChar, [] (ImFont* f, ImWchar c) {
+        COUNT (ImFont_SetFallbackChar);
+        f->FallbackChar = c;
+        int n = 0;
+        for (int i = 0; i < f->Glyphs.Size; ++i)
+            n = std::max (n, int (f->Glyphs.Data[i].Codepoint) + 1);
+        vector_assign (f->IndexAdvanceX, n, -1.f);
+        vector_assign (f->IndexLookup, n, ImWchar (0xffff));
+        for (int i = 0; i < f->Glyphs.Size; ++i)
+        {
+            auto const& g = f->Glyphs.Data[i];
+            f->IndexAdvanceX.Data[g.Codepoint] = g.AdvanceX;
+            f->IndexLookup.Data[g.Codepoint] = ImWchar (i);
+            if (g.Codepoint == c)
+                f->FallbackGlyph = &g, f->FallbackAdvanceX = g.AdvanceX;
+        }
+    });
+}
+
+static void
+install_defaults ()
+{
+    MOCK_DEFAULT (igBeginGroup);
+    MOCK_DEFAULT (igEndGroup);
+    MOCK_DEFAULT (igBeginPopup);
+    MOCK_DEFAULT (igBeginPopupModal);
+    MOCK_DEFAULT (igEndPopup);
+    MOCK_DEFAULT (igOpenPopup);
+    MOCK_DEFAULT (igCloseCurrentPopup);
+    MOCK_DEFAULT (igBeginTabBar);
+    MOCK_DEFAULT (igEndTabBar);
+    MOCK_DEFAULT (igBeginTabItem);
+    MOCK_DEFAULT (igEndTabItem);
+    MOCK_DEFAULT (igCheckbox);
+    MOCK_DEFAULT (igColorEdit4);
+    MOCK_DEFAULT (igColumns);
+    MOCK_DEFAULT (igNextColumn);
+    MOCK_DEFAULT (igCombo);
+    MOCK_DEFAULT (igDragFloat);
+    MOCK_DEFAULT (igDragFloat2);
+    MOCK_DEFAULT (igDragInt);
+    MOCK_DEFAULT (igSliderFloat);
+    MOCK_DEFAULT (igDummy);
+    MOCK_DEFAULT (igPlotLines);
+    MOCK_DEFAULT (igPushFont);
+    MOCK_DEFAULT (igPopFont);
+    MOCK_DEFAULT (igPushIDInt);
+    MOCK_DEFAULT (igPopID);
+    MOCK_DEFAULT (igPushItemWidth);
+    MOCK_DEFAULT (igPopItemWidth);
+    MOCK_DEFAULT (igPushStyleColorU32);
+    MOCK_DEFAULT (igPopStyleColor);
+    MOCK_DEFAULT (igPushStyleVarFloat);
+    MOCK_DEFAULT (igPopStyleVar);
+    MOCK_DEFAULT (igSetClipboardText);
+    MOCK_DEFAULT (igSetTooltip);
+    MOCK_DEFAULT (igSetItemDefaultFocus);
+    MOCK_DEFAULT (igSetMouseCursor);
+    MOCK_DEFAULT (igSetNextWindowCollapsed);
+    MOCK_DEFAULT (igSetNextWindowFocus);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Whatever slot is left has no business being called by the render path
+static void
+unmocked_slot ()
+{
+    std::fprintf (stderr, "Unmocked ImGui slot called, see mock_imgui.cpp.\n");
+    std::abort ();
+}
+
+/// Stands in for the DDS textures, only ever referenced and released
+struct mock_view_t : ID3D11ShaderResourceView
+{
+    unsigned long AddRef () override { return 1; }
+    unsigned long Release () override { return 1; }
+    void GetDevice (ID3D11Device** device) override;
+};
+
+struct mock_texture_t : ID3D11Texture2D
+{
+    unsigned long AddRef () override { return 1; }
+    unsigned long Release () override { return 1; }
+    void GetDevice (ID3D11Device**) override {}
+};
+
+/// Makes the fonts textures, no shaders as there is no d3dcompiler_47.dll to compile them
+struct mock_device_t : ID3D11Device
+{
+    unsigned long AddRef () override { return 1; }
+    unsigned long Release () override { return 1; }
+    HRESULT CreateTexture2D (D3D11_TEXTURE2D_DESC const*, D3D11_SUBRESOURCE_DATA const*,
+            ID3D11Texture2D** texture) override
+    {
+        static mock_texture_t t;
+        *texture = &t;
+        return S_OK;
+    }
+    HRESULT CreateShaderResourceView (ID3D11Resource*, D3D11_SHADER_RESOURCE_VIEW_DESC const*,
+            ID3D11ShaderResourceView** view) override
+    {
+        static mock_view_t v;
+        *view = &v;
+        return S_OK;
+    }
+    HRESULT CreatePixelShader (const void*, std::size_t, ID3D11ClassLinkage*,
+            ID3D11PixelShader**) override
+    {
+        return -1;
+    }
+    void GetImmediateContext (ID3D11DeviceContext** context) override { *context = nullptr; }
+};
+
+void
+mock_view_t::GetDevice (ID3D11Device** device)
+{
+    static mock_device_t d;
+    *device = &d;
+}
+
+static int SSEIMGUI_CCONV
+mock_ddsfile_texture (const char*, void*, void* view)
+{
+    static mock_view_t texture;
+    if (view)
+        *static_cast<ID3D11ShaderResourceView**> (view) = &texture;
+    return 1;
+}
+
+void
+install_mock_imgui ()
+{
+    using slot_t = void (*) ();
+    auto slots = reinterpret_cast<slot_t*> (&imgui);
+    for (std::size_t i = 0; i < sizeof (imgui) / sizeof (slot_t); ++i)
+        slots[i] = unmocked_slot;
+
+    mock.calls.clear ();
+    install_windows ();
+    install_draw_lists ();
+    install_widgets ();
+    install_defaults ();
+    install_fonts ();
+    sseimgui.ddsfile_texture = mock_ddsfile_texture;
+
+    mock.io.DisplaySize = ImVec2 { 1920, 1080 };
+    mock.io.DeltaTime = 1.f / 60;
+    mock.book_pos = ImVec2 { 40, 30 };
+    mock.book_size = ImVec2 { 1200, 800 };
+
+    static ImFont fonts[4] = {};
+    font_t* journal_fonts[] = {
+        &journal.button_font, &journal.chapter_font, &journal.text_font, &journal.default_font };
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        fonts[i].FontSize = line_height - 1;
+        fonts[i].Scale = 1;
+        journal_fonts[i]->imfont = &fonts[i];
+    }
+
+    if (!use_skin (nullptr, false))
+        std::fprintf (stderr, "The built-in skin failed with the mock textures.\n");
+    refresh_skin ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+mock_frame (mock_input_t const& input)
+{
+    extern void SSEIMGUI_CCONV render (int active);
+
+    ++mock.frame;
+    mock.stack.clear ();
+    mock.input = input;
+    if (input.list_scroll >= 0)
+        mock.scroll = input.list_scroll;
+    auto& io = mock.io;
+
+    if (input.io)
+    {
+        // What NewFrame() would make of the recorded frame
+        auto const& f = *input.io;
+        auto last_pos = io.MousePos;
+        io.DeltaTime = f.delta_time;
+        io.DisplaySize = f.display_size;
+        io.MousePos = f.mouse_pos;
+        io.MouseDelta = ImVec2 { f.mouse_pos.x - last_pos.x, f.mouse_pos.y - last_pos.y };
+        for (unsigned i = 0; i < 5; ++i)
+        {
+            bool down = (f.mouse_down >> i) & 1, was = (mock.mouse_down >> i) & 1;
+            io.MouseDown[i] = down;
+            io.MouseClicked[i] = down && !was;
+            io.MouseReleased[i] = !down && was;
+        }
+        mock.mouse_down = f.mouse_down;
+        io.MouseWheel = f.wheel;
+        io.MouseWheelH = f.wheel_h;
+        io.KeyCtrl = f.modifiers & 1;
+        io.KeyShift = f.modifiers & 2;
+        io.KeyAlt = f.modifiers & 4;
+        io.KeySuper = f.modifiers & 8;
+        for (std::size_t k = 0; k < f.keys.size (); ++k)
+            io.KeysDown[k] = f.keys[k];
+        mock.chars = f.chars;
+        if (io.MouseClicked[0])
+            mock.active = 0;
+        if (f.window_size.x > 0 && f.window_size.y > 0)
+            mock.book_pos = f.window_pos, mock.book_size = f.window_size;
+    }
+    else
+    {
+        // By label only: the mouse stays away, a click releases where quiet_input() sees it
+        io.MousePos = ImVec2 { -1e6f, -1e6f };
+        io.MouseClicked[0] = false;
+        io.MouseReleased[0] = !input.click.empty ();
+        mock.active = input.type_into.empty () ? 0 : hash_id (input.type_into.c_str ());
+        mock.chars.clear ();
+        if (mock.active)
+            mock.chars.push_back (ImWchar ('a' + mock.frame % 26));
+    }
+    // Whatever is left untyped at the end of the frame is dropped, as by EndFrame()
+    mock.typed_queue = mock.chars;
+    io.InputQueueCharacters = { int (mock.typed_queue.size ()), int (mock.typed_queue.size ()),
+                                mock.typed_queue.data () };
+
+    render (1);
+}
+
+ImVec2
+mock_locate (std::string const& label)
+{
+    // The retained book would replay its draw lists, without the items
+    auto retained = retained_book;
+    retained_book = false;
+    mock.locate = label;
+    mock.located = ImVec2 { -1e6f, -1e6f };
+    mock_frame ();
+    mock.locate.clear ();
+    retained_book = retained;
+    return mock.located;
+}
+
+void
+reset_mock_input ()
+{
+    mock.io.MousePos = ImVec2 { -1e6f, -1e6f };
+    for (auto& b: mock.io.MouseDown)
+        b = false;
+    mock.mouse_down = 0;
+    mock.active = 0;
+    mock.focus_next = false;
+    mock.scroll = 0;
+    mock.chars.clear ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,89 @@
+/**
+ * @file mock_imgui.hpp
+ * @brief Stand-in ImGui table for driving the render path without SSE-ImGui
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Benchmarks
+ *
+ * @details
+ * Every slot of #imgui used by the journal counts its calls. The draw lists are real ones, filled
+ * with one quad per button, image or visible glyph, so the retained book records and replays
+ * actual geometry. The text inputs scan their whole buffer for its length and lines, as ImGui
+ * does for an inactive multiline box, which is the cost that grows with the books.
+ *
+ * The items are hit tested against the mouse, hence recorded input (see input.cpp) replays
+ * into the same buttons and text boxes as it did in game, given the same window geometry.
+ *
+ * Slots the journal is not known to call abort with their index, rather than crash somewhere.
+ */
+
+#ifndef SSEJOURNAL_MOCK_IMGUI_HPP
+#define SSEJOURNAL_MOCK_IMGUI_HPP
+
+#include "sse-journal.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+
+/// What the next frame gets as input, either by labels or as recorded
+struct mock_input_t
+{
+    std::string click;      ///< Button label, up to its "##", pressed on the next frame
+    std::string type_into;  ///< Input label which gets one more character on the next frame
+    int list_scroll = -1;   ///< First item shown by the list boxes, if not negative
+    input_frame_t const* io = nullptr;  ///< Recorded frame, then the labels are left unused
+};
+
+struct mock_calls_t
+{
+    const char* name;
+    std::uint64_t calls;
+};
+
+/// Fills #imgui and the SSE-ImGui texture loading, loads the built-in skin with stand-in fonts
+void install_mock_imgui ();
+
+/// One render() with @param input, as the overlay would call it
+void mock_frame (mock_input_t const& input = {});
+
+/// Center of the item with @param label (as for mock_input_t::click), after an idle frame
+ImVec2 mock_locate (std::string const& label);
+
+/// Mouse away and up, no active input, list boxes back to the top, as before a replay
+void reset_mock_input ();
+
+/// All the counted slots, in the order of their first use
+std::vector<mock_calls_t> const& mock_calls ();
+void reset_mock_calls ();
+
+/// Of all the draw lists in the last frame
+struct mock_geometry_t
+{
+    std::size_t lists, cmds, vertices, indices;
+};
+mock_geometry_t mock_geometry ();
+
+//--------------------------------------------------------------------------------------------------
+
+#endif
+
@@ -0,0 +1,252 @@
+/**
+ * @file sse-journal.h
+ * @brief Public C API for the plugins which write into or read from SSE Journal
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Public API
+ *
+ * @note All functions may be called from any thread, and none of them blocks.
+ * @note Unless mentioned, all strings are in UTF-8 and sized, i.e. not null-terminated.
+ *
+ * @details
+ * The API is not exported from the DLL. Instead, a #ssejournal_api table is sent through the
+ * SKSE messaging: register a listener for the "sse-journal" sender during kMessage_PostLoad, and
+ * on kMessage_PostPostLoad it receives a message with type #SSEJOURNAL_API_VERSION and the table
+ * as data. Keep a copy of the table, the message data is gone after the listener returns.
+ *
+ * Changes are sent in batches: a single buffer with any number of records, each one starting
+ * with a #ssejournal_record header. The batch is checked and copied once, as a whole, then
+ * applied by the journal on its next frames, in the order of submission, whether the journal is
+ * shown or not. Hence, hundreds of entries cost as much as a single memcpy for the caller.
+ */
+
+#ifndef SSEJOURNAL_SSEJOURNAL_H
+#define SSEJOURNAL_SSEJOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// To match a compiled in API against one loaded at run-time.
+#define SSEJOURNAL_API_VERSION (1)
+
+#if defined(_WIN32) || defined(_WIN64)
+#  define SSEJOURNAL_CCONV __cdecl
+#else
+#  define SSEJOURNAL_CCONV
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+
+/**
+ * Run-time version of this API and its implementation details.
+ *
+ * Same meaning as for SSE-ImGui: @param api must match #SSEJOURNAL_API_VERSION, @param maj tells
+ * about compatible additions (e.g. new record types) and @param imp is for patches.
+ *
+ * @param[out] api (optional) non-portable
+ * @param[out] maj (optional) new features and enhancements
+ * @param[out] imp (optional) patches
+ * @param[out] timestamp (optional) in ISO format, null-terminated
+ */
+
+typedef void (SSEJOURNAL_CCONV* ssejournal_version_t) (int*, int*, int*, const char**);
+
+/******************************************************************************/
+
+/** What a record does, what follows its header is given for each one */
+enum ssejournal_op
+{
+    /** Text to append to the content of the page */
+    SSEJOURNAL_APPEND = 1,
+    /** Text replacing the title of the page */
+    SSEJOURNAL_SET_TITLE = 2,
+    /**
+     * New page inserted before the page, or appended if the page is negative or past the end:
+     * uint32_t title size, the title and then the content up to the record end.
+     */
+    SSEJOURNAL_NEW_PAGE = 3,
+    /** A #ssejournal_image followed by the DDS file path */
+    SSEJOURNAL_SET_IMAGE = 4,
+    /** Turns the book to the page, no data */
+    SSEJOURNAL_SHOW_PAGE = 5
+};
+
+/**
+ * Starts each record of a batch. Records follow each other with no padding.
+ *
+ * The @ref page is zero based, a negative one counts from the end (-1 is the last page).
+ */
+
+struct ssejournal_record
+{
+    /** In bytes, this header included */
+    uint32_t size;
+    /** One of #ssejournal_op */
+    uint32_t op;
+    int32_t page;
+};
+
+/** @see #SSEJOURNAL_SET_IMAGE, same meaning as in the book JSON file */
+struct ssejournal_image
+{
+    float uv[4], xy[4];
+    uint32_t tint;
+    /** Non-zero if the text is drawn above the image */
+    uint32_t background;
+};
+
+/**
+ * Queue a batch of records.
+ *
+ * The whole batch is validated upfront, so either all records are applied or none. Applying may
+ * still skip a record which names a page out of range, or an image which fails to load; these
+ * are reported in the journal log.
+ *
+ * @param[in] batch of records
+ * @param[in] size in bytes of @param batch
+ * @returns non-zero if queued, zero if malformed or if the journal queue is full
+ */
+
+typedef int (SSEJOURNAL_CCONV* ssejournal_submit_t) (void const* batch, size_t size);
+
+/******************************************************************************/
+
+/** What the #ssejournal_query_t callback receives for each page */
+struct ssejournal_page
+{
+    /** Zero based, or -1 if there was no page in the asked range */
+    int32_t index;
+    /** Pages in the book */
+    int32_t count;
+    char const* title;
+    uint32_t title_size;
+    char const* content;
+    uint32_t content_size;
+};
+
+/**
+ * Called by the journal from its render thread, also while the journal is not shown. The strings
+ * are valid only during the call.
+ * @returns zero to stop receiving further pages of the same query
+ */
+
+typedef int (SSEJOURNAL_CCONV* ssejournal_page_callback)
+    (void* user, struct ssejournal_page const* page);
+
+/**
+ * Read pages, after any batch submitted before.
+ *
+ * @param[in] first page, negative counts from the end
+ * @param[in] count of pages to read at most
+ * @param[in] callback invoked for each page, or once with index -1 if none is in range
+ * @param[in] user passed back to @param callback
+ * @returns non-zero if queued, zero if the journal queue is full
+ */
+
+typedef int (SSEJOURNAL_CCONV* ssejournal_query_t)
+    (int32_t first, int32_t count, ssejournal_page_callback callback, void* user);
+
+/******************************************************************************/
+
+/**
+ * Evaluates a variable of a provider, called by the journal from its render thread, where the
+ * game memory is safe to read. Not called while the last value for the same parameters is
+ * younger than the provider @ref ttl.
+ *
+ * @param[in] context as given in #ssejournal_provider
+ * @param[in] params of the variable, null-terminated, as edited by the user
+ * @param[out] buffer for the value, not null-terminated
+ * @param[in] capacity of @param buffer in bytes
+ * @returns the value size, possibly larger than @param capacity, in which case the journal calls
+ *          again with a buffer that large; negative if there is no value (e.g. in the main menu)
+ */
+
+typedef int32_t (SSEJOURNAL_CCONV* ssejournal_evaluate_t)
+    (void* context, char const* params, char* buffer, uint32_t capacity);
+
+/**
+ * A source of Journal Variables, e.g. the current quest or the gold the player carries.
+ *
+ * The strings are null-terminated and copied at registration. The @ref name identifies the
+ * provider in the saved variables, hence it should not change between versions of a plugin.
+ */
+
+struct ssejournal_provider
+{
+    /** Shown in the variables list, unique among the providers */
+    char const* name;
+    /** Help text of the parameters, as shown by the Info button */
+    char const* info;
+    /** Default parameters */
+    char const* params;
+    /** Seconds a value is reused for the same parameters, zero to evaluate each time */
+    float ttl;
+    ssejournal_evaluate_t evaluate;
+    /** Passed back to @ref evaluate, must stay valid for the whole game session */
+    void* context;
+};
+
+/**
+ * Adds a variable provider. Registering a name again replaces the previous provider.
+ *
+ * @param[in] provider to copy
+ * @returns non-zero if queued, zero if malformed; unlike the batches, never dropped
+ */
+
+typedef int (SSEJOURNAL_CCONV* ssejournal_register_provider_t)
+    (struct ssejournal_provider const* provider);
+
+/******************************************************************************/
+
+/**
+ * Set of function pointers as found in this file.
+ *
+ * Compatible changes are function pointers appened to the end of this
+ * structure.
+ */
+
+struct ssejournal_api_v1
+{
+    /** @see #ssejournal_version_t */
+    ssejournal_version_t version;
+    /** @see #ssejournal_submit_t */
+    ssejournal_submit_t submit;
+    /** @see #ssejournal_query_t */
+    ssejournal_query_t query;
+    /** @see #ssejournal_register_provider_t, read it only if @ref version gives maj >= 5 */
+    ssejournal_register_provider_t register_provider;
+};
+
+/** Points to the current API version in use. */
+typedef struct ssejournal_api_v1 ssejournal_api;
+
+/******************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SSEJOURNAL_SSEJOURNAL_H */
+
+/* EOF */
@@ -0,0 +1,162 @@
+/**
+ * @file allocs.cpp
+ * @brief Opt-in heap allocation counting for the render path
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * The global operator new of this module is replaced, so everything the plugin allocates through
+ * the standard library passes here (ImGui and SSE-ImGui use their own heaps). Only the render
+ * thread, while inside a profiled stage, is counted: per stage into the current profiler sample,
+ * and per site into the innermost #alloc_scope_t, or the stage itself when there is none. Nothing
+ * here allocates, so counting can't recurse.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+//--------------------------------------------------------------------------------------------------
+
+std::atomic<bool> alloc_tracking { false };
+std::uint64_t alloc_tracked_frames = 0;
+
+alloc_site_t* alloc_site_t::first = nullptr;
+thread_local alloc_site_t* alloc_scope_t::current = nullptr;
+
+/// Allocations outside of any explicit site go to their stage
+static alloc_site_t stage_sites[stage_count] = {
+    alloc_site_t { "frame" }, alloc_site_t { "journal_command" }, alloc_site_t { "draw_book" },
+    alloc_site_t { "draw_settings" }, alloc_site_t { "draw_elements" },
+    alloc_site_t { "draw_chapters" }, alloc_site_t { "draw_saveas" }, alloc_site_t { "draw_load" },
+    alloc_site_t { "draw_nearby" }, alloc_site_t { "draw_timeline" }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+alloc_site_t::alloc_site_t (const char* name) : name (name), next (first)
+{
+    first = this; // Function statics are made on the render thread, no race
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+note_allocation (std::size_t size)
+{
+    if (!alloc_tracking.load (std::memory_order_relaxed))
+        return;
+    auto stage = profile_scope_t::current_stage ();
+    if (stage == stage_count)
+        return;
+    profile_note_allocation (stage, size);
+    auto site = alloc_scope_t::current ? alloc_scope_t::current : &stage_sites[stage];
+    site->count++;
+    site->bytes += size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+top_alloc_sites (std::vector<alloc_site_t const*>& out)
+{
+    out.clear ();
+    for (auto s = alloc_site_t::first; s; s = s->next)
+        if (s->count)
+            out.push_back (s);
+    std::sort (out.begin (), out.end (), [] (alloc_site_t const* a, alloc_site_t const* b) {
+        return a->count > b->count;
+    });
+}
+
+void
+reset_alloc_sites ()
+{
+    for (auto s = alloc_site_t::first; s; s = s->next)
+        s->count = s->bytes = 0;
+    alloc_tracked_frames = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+dump_allocations (std::string const& destination)
+{
+    std::vector<alloc_site_t const*> sites;
+    top_alloc_sites (sites);
+
+    std::ofstream of (destination);
+    if (!of.is_open ())
+    {
+        log () << "Unable to open " << destination << " for writting." << std::endl;
+        return false;
+    }
+
+    auto frames = std::max<std::uint64_t> (alloc_tracked_frames, 1);
+    of << "Frames: " << alloc_tracked_frames << "\n\n"
+       << "site, allocations, bytes, allocations per frame, bytes per frame\n";
+    for (auto s: sites)
+        of << s->name << ", " << s->count << ", " << s->bytes << ", "
+           << double (s->count) / frames << ", " << double (s->bytes) / frames << '\n';
+    return bool (of);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void*
+operator new (std::size_t size)
+{
+    note_allocation (size);
+    if (auto p = std::malloc (size ? size : 1))
+        return p;
+    throw std::bad_alloc ();
+}
+
+void*
+operator new[] (std::size_t size)
+{
+    return ::operator new (size);
+}
+
+void*
+operator new (std::size_t size, std::nothrow_t const&) noexcept
+{
+    note_allocation (size);
+    return std::malloc (size ? size : 1);
+}
+
+void*
+operator new[] (std::size_t size, std::nothrow_t const& nt) noexcept
+{
+    return ::operator new (size, nt);
+}
+
+void operator delete (void* p) noexcept { std::free (p); }
+void operator delete[] (void* p) noexcept { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept { std::free (p); }
+void operator delete (void* p, std::nothrow_t const&) noexcept { std::free (p); }
+void operator delete[] (void* p, std::nothrow_t const&) noexcept { std::free (p); }
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,267 @@
+/**
+ * @file api.cpp
+ * @brief Public API for the other plugins, see sse-journal/sse-journal.h
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * The API functions run on the caller threads and only ever post into the commands queue. A
+ * batch is validated there, so the render thread walks it without checking the sizes again, and
+ * appends the texts straight from the batch bytes.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+//--------------------------------------------------------------------------------------------------
+
+template<class T>
+static inline T
+read_pod (const char* p)
+{
+    T v;
+    std::memcpy (&v, p, sizeof (T));
+    return v;
+}
+
+static bool
+valid_batch (const char* p, std::size_t size)
+{
+    while (size)
+    {
+        if (size < sizeof (ssejournal_record))
+            return false;
+        auto r = read_pod<ssejournal_record> (p);
+        if (r.size < sizeof (ssejournal_record) || r.size > size)
+            return false;
+        std::size_t n = r.size - sizeof (ssejournal_record);
+        switch (r.op)
+        {
+            case SSEJOURNAL_APPEND:
+            case SSEJOURNAL_SET_TITLE:
+            case SSEJOURNAL_SHOW_PAGE:
+                break;
+            case SSEJOURNAL_NEW_PAGE:
+                if (n < sizeof (std::uint32_t)
+                        || read_pod<std::uint32_t> (p + sizeof (ssejournal_record))
+                            > n - sizeof (std::uint32_t))
+                    return false;
+                break;
+            case SSEJOURNAL_SET_IMAGE:
+                if (n < sizeof (ssejournal_image))
+                    return false;
+                break;
+            default:
+                return false;
+        }
+        p += r.size;
+        size -= r.size;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void SSEJOURNAL_CCONV
+api_version (int* api, int* maj, int* imp, const char** timestamp)
+{
+    if (api) *api = SSEJOURNAL_API_VERSION;
+    journal_version (nullptr, maj, imp, timestamp);
+}
+
+static int SSEJOURNAL_CCONV
+api_submit (void const* batch, std::size_t size)
+{
+    auto p = static_cast<const char*> (batch);
+    if (!p || !size || !valid_batch (p, size))
+        return 0;
+    command_t c = {};
+    c.type = command_batch;
+    c.text.assign (p, size);
+    return post_command (std::move (c));
+}
+
+static int SSEJOURNAL_CCONV
+api_query (std::int32_t first, std::int32_t count, ssejournal_page_callback callback, void* user)
+{
+    if (!callback)
+        return 0;
+    command_t c = {};
+    c.type = command_query;
+    c.callback = callback;
+    c.user = user;
+    c.first = first;
+    c.count = count;
+    return post_command (std::move (c));
+}
+
+static int SSEJOURNAL_CCONV
+api_register_provider (ssejournal_provider const* provider)
+{
+    if (!provider || !provider->name || !*provider->name || !provider->evaluate)
+        return 0;
+    auto p = std::make_shared<provider_t> ();
+    p->name = provider->name;
+    p->info = provider->info ? provider->info : "";
+    p->params = provider->params ? provider->params : "";
+    p->ttl = provider->ttl > 0 ? std::min (provider->ttl, 86400.f) : 0; // NaN too
+    p->evaluate = provider->evaluate;
+    p->context = provider->context;
+    post_provider (std::move (p));
+    return 1;
+}
+
+ssejournal_api
+make_journal_api ()
+{
+    ssejournal_api api = {};
+    api.version = api_version;
+    api.submit = api_submit;
+    api.query = api_query;
+    api.register_provider = api_register_provider;
+    return api;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Negative counts from the end, -1 if out of range
+
+static int
+page_index (std::int32_t page)
+{
+    auto n = std::int32_t (journal.pages.size ());
+    if (page < 0)
+        page += n;
+    return page >= 0 && page < n ? page : -1;
+}
+
+/// The UI input boxes keep the strings padded with zeros, see imgui_text_callback()
+
+static inline std::size_t
+text_size (std::string const& text)
+{
+    return std::strlen (text.c_str ());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+apply_batch (std::string const& batch)
+{
+    auto p = batch.data (), end = p + batch.size ();
+    for (ssejournal_record r; p < end; p += r.size)
+    {
+        r = read_pod<ssejournal_record> (p);
+        auto data = p + sizeof (ssejournal_record);
+        auto data_end = p + r.size;
+
+        if (r.op == SSEJOURNAL_NEW_PAGE)
+        {
+            auto title_size = read_pod<std::uint32_t> (data);
+            data += sizeof (std::uint32_t);
+            page_t page = {};
+            page.title.assign (data, title_size);
+            page.content.assign (data + title_size, data_end);
+            note_glyphs (page.title);
+            note_glyphs (page.content);
+            auto n = std::int32_t (journal.pages.size ());
+            auto at = r.page < 0 || r.page > n ? n : r.page;
+            stamp_page (*journal.pages.insert (journal.pages.begin () + at, std::move (page)));
+            continue;
+        }
+
+        auto i = page_index (r.page);
+        if (i < 0)
+        {
+            static log_limit_t limit (5);
+            log (log_warning, &limit)
+                << "Mod requested page " << r.page << " is out of range." << std::endl;
+            continue;
+        }
+        auto& page = journal.pages[i];
+
+        switch (r.op)
+        {
+            case SSEJOURNAL_APPEND:
+                page.content.resize (text_size (page.content));
+                page.content.append (data, data_end);
+                note_glyphs (data, data_end);
+                break;
+            case SSEJOURNAL_SET_TITLE:
+                page.title.assign (data, data_end);
+                note_glyphs (page.title);
+                break;
+            case SSEJOURNAL_SET_IMAGE:
+            {
+                auto img = read_pod<ssejournal_image> (data);
+                frame_string_t file (data + sizeof (ssejournal_image), data_end);
+                if (!obtain_image (file.c_str (), page.image))
+                {
+                    static log_limit_t limit (5);
+                    log (log_warning, &limit)
+                        << "Unable to load mod requested image " << file << std::endl;
+                    break;
+                }
+                std::copy (img.uv, img.uv + 4, page.image.uv.begin ());
+                std::copy (img.xy, img.xy + 4, page.image.xy.begin ());
+                page.image.tint = img.tint;
+                page.image.background = img.background != 0;
+                break;
+            }
+            case SSEJOURNAL_SHOW_PAGE:
+                journal.current_page = std::min<unsigned> (i, unsigned (journal.pages.size ()) - 2);
+                show_book_window (); // Maybe hidden now
+                break;
+        }
+    }
+    invalidate_retained_book ();
+    invalidate_places ();
+    invalidate_chronology ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+run_query (command_t const& query)
+{
+    auto count = std::int32_t (journal.pages.size ());
+    auto first = query.first < 0 ? query.first + count : query.first;
+    auto last = std::int32_t (std::min<std::int64_t> (count,
+                std::int64_t (first) + std::max (query.count, 0)));
+
+    ssejournal_page out = { -1, count, "", 0, "", 0 };
+    for (auto i = std::max (first, 0); i < last; ++i)
+    {
+        auto const& p = journal.pages[i];
+        out = ssejournal_page { i, count,
+            p.title.c_str (), std::uint32_t (text_size (p.title)),
+            p.content.c_str (), std::uint32_t (text_size (p.content)) };
+        if (!query.callback (query.user, &out))
+            return;
+    }
+    if (out.index < 0)
+        query.callback (query.user, &out);
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,80 @@
+/**
+ * @file arena.cpp
+ * @brief Per frame bump allocator for the transient render time data
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * Memory is only ever handed out by moving a pointer, and taken back all at once when render()
+ * ends. Blocks are kept across frames: if a frame needed more than one, they are merged into a
+ * single one as large as all of them, so the next such frame fits without touching the heap.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+
+//--------------------------------------------------------------------------------------------------
+
+frame_arena_t frame_arena;
+
+//--------------------------------------------------------------------------------------------------
+
+void*
+frame_arena_t::allocate (std::size_t size, std::size_t align)
+{
+    for (;; ++current, used = 0)
+    {
+        if (current == blocks.size ())
+        {
+            std::size_t n = std::max (block_size, size + align);
+            blocks.push_back (block_t { std::make_unique<char[]> (n), n });
+        }
+        auto& b = blocks[current];
+        auto base = reinterpret_cast<std::uintptr_t> (b.data.get ());
+        std::size_t offset = ((base + used + align - 1) & ~(align - 1)) - base;
+        if (offset + size <= b.size)
+        {
+            used = offset + size;
+            return b.data.get () + offset;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+frame_arena_t::reset ()
+{
+    if (blocks.size () > 1)
+    {
+        std::size_t total = 0;
+        for (auto const& b: blocks)
+            total += b.size;
+        blocks.clear ();
+        blocks.push_back (block_t { std::make_unique<char[]> (total), total });
+    }
+    current = 0;
+    used = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,281 @@
+/**
+ * @file books.cpp
+ * @brief Recently opened books kept in memory, and the background loading of the rest
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * The book being switched away from goes into the cache as it is, unsaved edits included, so
+ * switching back gives it as it was left. Books move in and out of journal_t::pages by moving
+ * the vectors, nothing is copied. The least recently used ones are dropped once the cache grows
+ * past #book_cache_limit; that loses their unsaved edits, same as loading another book always
+ * did.
+ *
+ * A book not in the cache is parsed on a worker thread, and made current by #poll_books() on
+ * the render thread, where its images are obtained too.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <list>
+
+//--------------------------------------------------------------------------------------------------
+
+std::size_t book_cache_limit = 64 * 1024 * 1024;
+
+/// Most recently used first
+static std::list<book_t> cache;
+static std::size_t cache_bytes = 0;
+
+static std::future<std::unique_ptr<book_t>> pending_read;
+/// Which book the current read is for, it may be asked for another one meanwhile
+static std::string wanted;
+
+//--------------------------------------------------------------------------------------------------
+
+static std::size_t
+book_bytes (book_t const& book)
+{
+    std::size_t n = sizeof (book_t) + book.pages.capacity () * sizeof (page_t);
+    for (auto const& p: book.pages)
+        n += p.title.capacity () + p.content.capacity ();
+    return n;
+}
+
+static void
+release_book (book_t& book)
+{
+    for (auto& p: book.pages)
+        release_image (p.image);
+    book.pages.clear ();
+}
+
+static void
+obtain_images (book_t& book)
+{
+    for (std::size_t i = 0; i < book.image_files.size () && i < book.pages.size (); ++i)
+        if (!book.image_files[i].empty ())
+            obtain_image (book.image_files[i].c_str (), book.pages[i].image);
+    book.image_files.clear ();
+}
+
+static void
+evict_books ()
+{
+    while (cache_bytes > book_cache_limit && !cache.empty ())
+    {
+        auto& b = cache.back ();
+        log () << "Dropping " << b.file << " from the books cache." << std::endl;
+        cache_bytes -= b.bytes;
+        release_book (b);
+        cache.pop_back ();
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+forget_book (std::string const& file)
+{
+    auto it = std::find_if (cache.begin (), cache.end (),
+            [&file] (book_t const& b) { return b.file == file; });
+    if (it == cache.end ())
+        return;
+    cache_bytes -= it->bytes;
+    release_book (*it);
+    cache.erase (it);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+stash_book ()
+{
+    book_t book;
+    book.file = std::move (journal.book_file);
+    book.pages = std::move (journal.pages);
+    book.current_page = journal.current_page;
+    journal.book_file.clear ();
+    journal.pages.clear ();
+    journal.current_page = 0;
+    invalidate_retained_book ();
+    invalidate_places ();
+    invalidate_chronology ();
+
+    if (book.file.empty ())
+    {
+        release_book (book);
+        return;
+    }
+    forget_book (book.file);
+    book.bytes = book_bytes (book);
+    cache_bytes += book.bytes;
+    cache.push_front (std::move (book));
+    evict_books ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+install_book (book_t&& book)
+{
+    // Reloading the current one from disk drops its edits, as expected
+    if (book.file == journal.book_file)
+    {
+        for (auto& p: journal.pages)
+            release_image (p.image);
+        journal.pages.clear ();
+        journal.book_file.clear ();
+    }
+    stash_book ();
+    forget_book (book.file);
+
+    obtain_images (book);
+    for (auto const& p: book.pages)
+    {
+        note_glyphs (p.title);
+        note_glyphs (p.content);
+    }
+
+    journal.book_file = std::move (book.file);
+    journal.pages = std::move (book.pages);
+    journal.current_page = book.current_page;
+    invalidate_retained_book ();
+    invalidate_places ();
+    invalidate_chronology ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static std::unique_ptr<book_t>
+read_book_async (std::string file)
+{
+    auto book = std::make_unique<book_t> ();
+    book->file = file;
+    book->ok = read_book (file.c_str (), *book);
+    return book;
+}
+
+static void
+start_read (std::string const& file)
+{
+    wanted = file;
+    if (pending_read.valid ())
+        return; // The next poll after this read completes starts the wanted one
+    pending_read = std::async (std::launch::async, read_book_async, file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+open_book (std::string const& file)
+{
+    if (file == journal.book_file)
+    {
+        wanted.clear ();
+        return true;
+    }
+
+    auto it = std::find_if (cache.begin (), cache.end (),
+            [&file] (book_t const& b) { return b.file == file; });
+    if (it == cache.end ())
+    {
+        start_read (file);
+        return false;
+    }
+
+    wanted.clear ();
+    book_t book = std::move (*it);
+    cache_bytes -= book.bytes;
+    cache.erase (it);
+    stash_book ();
+    journal.book_file = std::move (book.file);
+    journal.pages = std::move (book.pages);
+    journal.current_page = book.current_page;
+    invalidate_retained_book ();
+    invalidate_places ();
+    invalidate_chronology ();
+    return true;
+}
+
+void
+reload_book (std::string const& file)
+{
+    forget_book (file);
+    start_read (file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+book_read_t
+poll_books ()
+{
+    if (!pending_read.valid ()
+            || pending_read.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+        return book_reading;
+
+    auto book = pending_read.get ();
+    if (!book->messages.empty ())
+        log () << book->messages << std::flush;
+
+    auto read = book_reading;
+    if (!book->ok)
+    {
+        log () << "Unable to open book " << book->file << std::endl;
+        if (book->file == wanted)
+            read = book_failed;
+    }
+    else if (book->file == wanted)
+    {
+        install_book (std::move (*book));
+        read = book_installed;
+    }
+    else
+    {
+        // Asked for another one meanwhile, still good to have
+        forget_book (book->file);
+        obtain_images (*book);
+        book->bytes = book_bytes (*book);
+        cache_bytes += book->bytes;
+        cache.push_front (std::move (*book));
+        evict_books ();
+    }
+
+    if (read != book_reading || book->file == wanted)
+        wanted.clear ();
+    if (!wanted.empty ())
+        pending_read = std::async (std::launch::async, read_book_async, wanted);
+    return read;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+book_cache_stats_t
+book_cache_stats ()
+{
+    return book_cache_stats_t { cache.size (), cache_bytes };
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,102 @@
+/**
+ * @file chronology.cpp
+ * @brief Pages in the order of the game time they were written at
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * The index is a flat array of the stamped pages sorted by their game time, so a range is two
+ * binary searches and its entries are contiguous, which is what a clipped list wants. As with
+ * the places, it is rebuilt once invalidated, on the next use.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+
+//--------------------------------------------------------------------------------------------------
+
+static struct
+{
+    std::vector<chronology_entry_t> entries;
+    bool valid;
+}
+chronology_index = {};
+
+//--------------------------------------------------------------------------------------------------
+
+void
+stamp_page (page_t& page)
+{
+    if (!page.written)
+    {
+        auto state = game_state ();
+        if (state.time_ok)
+        {
+            page.written = state.time;
+            invalidate_chronology ();
+        }
+    }
+    if (!page.place.tagged)
+        geotag_page (page);
+}
+
+void
+invalidate_chronology ()
+{
+    chronology_index.valid = false;
+}
+
+std::vector<chronology_entry_t> const&
+chronology ()
+{
+    auto& c = chronology_index;
+    if (c.valid)
+        return c.entries;
+
+    trace_span_t span ("build_chronology");
+    c.entries.clear ();
+    for (unsigned i = 0; i < journal.pages.size (); ++i)
+        if (journal.pages[i].written > 0)
+            c.entries.push_back (chronology_entry_t { journal.pages[i].written, i });
+    // Same time, book order
+    std::stable_sort (c.entries.begin (), c.entries.end (), [] (auto const& a, auto const& b) {
+        return a.time < b.time;
+    });
+    c.valid = true;
+    return c.entries;
+}
+
+std::pair<std::size_t, std::size_t>
+chronology_range (float from, float to)
+{
+    auto const& e = chronology ();
+    auto first = std::lower_bound (e.begin (), e.end (), from, [] (auto const& a, float t) {
+        return a.time < t;
+    });
+    auto last = std::lower_bound (first, e.end (), to, [] (auto const& a, float t) {
+        return a.time < t;
+    });
+    return { std::size_t (first - e.begin ()), std::size_t (last - e.begin ()) };
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,119 @@
+/**
+ * @file commands.cpp
+ * @brief Queue of commands sent by the other plugins, executed by the render loop
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * Bounded array of cells, each with a sequence number telling whose turn it is (D. Vyukov's
+ * design). Producers claim a cell by moving the shared tail with a CAS, fill it, then publish it
+ * through its sequence. The only consumer, the render thread, owns the head and needs no CAS. A
+ * full queue never blocks the sender, the command is dropped and counted instead.
+ *
+ * The variable providers are not commands: plugins register them all at once on startup, when
+ * dropping one would lose it for the session. They go to an unbounded list, pushed with a CAS
+ * and taken whole by the render thread, which reverses it back into the order of registration.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <utility>
+
+//--------------------------------------------------------------------------------------------------
+
+static mpsc_queue_t<command_t, 256> queue;
+static std::atomic<std::uint64_t> posted { 0 }, dropped { 0 }, taken { 0 };
+
+struct pending_provider_t
+{
+    std::shared_ptr<provider_t> provider;
+    pending_provider_t* next;
+};
+
+static std::atomic<pending_provider_t*> providers { nullptr }; ///< Last registered first
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+post_command (command_t&& cmd)
+{
+    if (!queue.push (std::move (cmd)))
+    {
+        dropped.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+    posted.fetch_add (1, std::memory_order_relaxed);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+take_commands (std::vector<command_t>& out, std::size_t max)
+{
+    out.resize (max);
+    std::size_t n = 0;
+    while (n < max && queue.pop (out[n]))
+        ++n;
+    out.resize (n);
+    taken.fetch_add (n, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+post_provider (std::shared_ptr<provider_t> provider)
+{
+    auto p = new pending_provider_t { std::move (provider), nullptr };
+    p->next = providers.load (std::memory_order_relaxed);
+    while (!providers.compare_exchange_weak (p->next, p,
+                std::memory_order_release, std::memory_order_relaxed))
+        ;
+}
+
+void
+take_providers (std::vector<std::shared_ptr<provider_t>>& out)
+{
+    out.clear ();
+    auto p = providers.exchange (nullptr, std::memory_order_acquire);
+    while (p)
+    {
+        out.push_back (std::move (p->provider));
+        delete std::exchange (p, p->next);
+    }
+    std::reverse (out.begin (), out.end ());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+command_stats_t
+command_stats ()
+{
+    return command_stats_t {
+        posted.load (std::memory_order_relaxed),
+        dropped.load (std::memory_order_relaxed),
+        taken.load (std::memory_order_relaxed)
+    };
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -31,6 +31,7 @@
 #include <gsl/gsl_util>
 
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <iterator>
 
@@ -49,14 +50,24 @@ std::string journal_directory = "Data\\SKSE\\Plugins\\sse-journal\\";
 std::string books_directory   = journal_directory + "books\\";
 std::string default_book      = books_directory   + "default_book.json";
 std::string settings_location = journal_directory + "settings.json";
+std::string skins_directory   = journal_directory + "skins\\";
+std::string default_skin_location = skins_directory + "book.json";
 std::string variables_location= journal_directory + "variables.json";
 std::string images_directory  = journal_directory + "images\\";
+std::string fonts_cache_location = journal_directory + "fonts.cache";
+std::string profile_location = journal_directory + "profile.csv";
+std::string trace_location = journal_directory + "trace.json";
+std::string allocations_location = journal_directory + "allocations.txt";
+std::string input_location = journal_directory + "input.rec";
+std::string input_timings_location = journal_directory + "input-timings.csv";
+std::string travel_location = journal_directory + "travel.log";
 
 //--------------------------------------------------------------------------------------------------
 
 bool
-save_text (std::string const& destination)
+save_text (const char* destination)
 {
+    trace_span_t span ("save_text", destination);
     int maj, min, patch;
     const char* timestamp;
     journal_version (&maj, &min, &patch, &timestamp);
@@ -75,12 +86,13 @@ save_text (std::string const& destination)
            << std::endl;
 
         int i = 0;
+        std::string title, content; // The values of the placeholders, as shown
         for (auto const& p: journal.pages)
         {
             of << "Page #" << std::to_string (i++) << '\n'
-               << p.title.c_str () << '\n'
-               << p.content.c_str () << '\n'
-               << std::endl;
+               << (expand_placeholders (p.title, title) ? title : p.title).c_str () << '\n'
+               << (expand_placeholders (p.content, content) ? content : p.content).c_str ()
+               << '\n' << std::endl;
         }
     }
     catch (std::exception const& ex)
@@ -94,8 +106,9 @@ save_text (std::string const& destination)
 //--------------------------------------------------------------------------------------------------
 
 bool
-save_book (std::string const& destination)
+save_book (const char* destination)
 {
+    trace_span_t span ("save_book", destination);
     int maj, min, patch;
     const char* timestamp;
     journal_version (&maj, &min, &patch, &timestamp);
@@ -118,7 +131,8 @@ save_book (std::string const& destination)
         for (auto const& p: journal.pages)
         {
             auto it = journal.images.find (p.image.ref);
-            json["pages"][std::to_string (i++)] = {
+            auto& jp = json["pages"][std::to_string (i++)];
+            jp = {
                 { "title", p.title.c_str () },
                 { "content", p.content.c_str () },
                 { "image",  {
@@ -129,6 +143,15 @@ save_book (std::string const& destination)
                     { "xy", { p.image.xy[0], p.image.xy[1], p.image.xy[2], p.image.xy[3] }}
                 }}
             };
+            if (p.written > 0)
+                jp["written"] = p.written;
+            if (p.place.tagged)
+                jp["place"] = {
+                    { "worldspace", p.place.worldspace },
+                    { "cell", p.place.cell },
+                    { "position", {
+                        p.place.position[0], p.place.position[1], p.place.position[2] }}
+                };
         }
 
         std::ofstream of (destination);
@@ -145,23 +168,32 @@ save_book (std::string const& destination)
         log () << "Unable to save book: " << ex.what () << std::endl;
         return false;
     }
+
+    // Whatever was cached for the destination is outdated, this one is the book in there now
+    forget_book (destination);
+    journal.book_file = destination;
     return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 
 bool
-load_book (std::string const& source)
+read_book (const char* source, book_t& book)
 {
+    trace_span_t span ("read_book", source);
     int maj;
     journal_version (&maj, nullptr, nullptr, nullptr);
 
+    // Likely off the render thread, hence messages are collected and logged by the caller
+    std::ostringstream messages;
+    auto flush = gsl::finally ([&] { book.messages += messages.str (); });
+
     try
     {
         std::ifstream fi (source);
         if (!fi.is_open ())
         {
-            log () << "Unable to open " << source << " for reading." << std::endl;
+            messages << "Unable to open " << source << " for reading.\n";
             return false;
         }
 
@@ -170,16 +202,18 @@ load_book (std::string const& source)
 
         if (json["version"]["major"].get<int> () != maj)
         {
-            log () << "Incompatible book version." << std::endl;
+            messages << "Incompatible book version.\n";
             return false;
         }
 
         auto current = json["current"].get<unsigned> ();
 
-        std::map<int, page_t> pages; // a map for page sorting and gaps fixing
+        // a map for page sorting and gaps fixing
+        std::map<int, std::pair<page_t, std::string>> pages;
         for (auto const& kv: json["pages"].items ())
         {
             page_t p = {};
+            std::string image_file;
             int ndx = std::stoull (kv.key ());
             auto& v = kv.value ();
             p.title = v["title"].get<std::string> ();
@@ -193,37 +227,66 @@ load_book (std::string const& source)
                 for (float& xy: p.image.xy) xy = *it++;
                 p.image.tint = std::stoull (vi["tint"].get<std::string> (), nullptr, 0);
                 p.image.background = vi["background"];
-                obtain_image (vi["file"], p.image); // resets p.image on success
+                image_file = vi["file"].get<std::string> ();
+            }
+            p.written = v.value ("written", 0.f);
+            if (v.contains ("place"))
+            {
+                auto& vp = v["place"];
+                p.place.tagged = true;
+                p.place.worldspace = vp["worldspace"].get<std::string> ();
+                p.place.cell = vp["cell"].get<std::string> ();
+                auto it = vp["position"].begin ();
+                for (float& xyz: p.place.position) xyz = *it++;
             }
-            pages.emplace (ndx, std::move (p));
+            pages.emplace (ndx, std::make_pair (std::move (p), std::move (image_file)));
         }
 
-        journal.pages.clear ();
-        journal.pages.reserve (pages.size ());
-        for (auto const& kv: pages)
-            journal.pages.emplace_back (std::move (kv.second));
+        book.file = source;
+        book.pages.clear ();
+        book.image_files.clear ();
+        book.pages.reserve (pages.size ());
+        for (auto& kv: pages)
+        {
+            book.pages.emplace_back (std::move (kv.second.first));
+            book.image_files.emplace_back (std::move (kv.second.second));
+        }
 
-        while (journal.pages.size () < 2)
+        while (book.pages.size () < 2)
         {
-            log () << "Less than two pages. Inserting empty one." << std::endl;
-            journal.pages.emplace_back (page_t {});
+            messages << "Less than two pages. Inserting empty one.\n";
+            book.pages.emplace_back (page_t {});
+            book.image_files.emplace_back ();
         }
 
-        if (current >= journal.pages.size ())
+        if (current >= book.pages.size ())
         {
-            log () << "Current page seems off. Setting it to the first one." << std::endl;
+            messages << "Current page seems off. Setting it to the first one.\n";
             current = 0;
         }
-        journal.current_page = current;
+        book.current_page = current;
     }
     catch (std::exception const& ex)
     {
-        log () << "Unable to load book: " << ex.what () << std::endl;
+        messages << "Unable to load book: " << ex.what () << '\n';
         return false;
     }
     return true;
 }
 
+bool
+load_book (const char* source)
+{
+    trace_span_t span ("load_book", source);
+    book_t book;
+    bool ok = read_book (source, book);
+    if (!book.messages.empty ())
+        log () << book.messages << std::flush;
+    if (ok)
+        install_book (std::move (book));
+    return ok;
+}
+
 //--------------------------------------------------------------------------------------------------
 
 static void
@@ -232,10 +295,11 @@ save_font (nlohmann::json& json, font_t const& font)
     auto& jf = json[font.name + " font"];
     jf["scale"] = font.imfont->Scale;
     jf["color"] = hex_string (font.color);
-    jf["size"] = font.imfont->FontSize;
+    jf["size"] = font.size;
     jf["file"] = font.file;
     jf["glyphs"] = font.glyphs;
     jf["ranges"] = font.ranges;
+    jf["sdf"] = font.sdf;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -243,6 +307,7 @@ save_font (nlohmann::json& json, font_t const& font)
 bool
 save_settings ()
 {
+    trace_span_t span ("save_settings", settings_location.c_str ());
     int maj, min, patch;
     const char* timestamp;
     journal_version (&maj, &min, &patch, &timestamp);
@@ -259,6 +324,13 @@ save_settings ()
         };
 
         json["titlebar"] = journal.show_titlebar;
+        json["trace"] = journal.trace;
+        json["loglevel"] = log_threshold.load ();
+        json["travel"] = journal.travel_log;
+        json["travelcadence"] = journal.travel_cadence;
+        json["nearby"] = journal.show_nearby;
+        json["nearbyradius"] = journal.nearby_radius;
+        json["skin"] = journal.skin_file.c_str (); // Input boxes leave trailing zeros
         json["background"]["file"] = journal.background_file;
         save_font (json, journal.text_font);
         save_font (json, journal.chapter_font);
@@ -295,59 +367,25 @@ load_font (nlohmann::json const& json, font_t& font)
 
     font.color = std::stoull (jf.value ("color", hex_string (font.color)), nullptr, 0);
     font.scale = jf.value ("scale", font.scale);
-    auto set_scale = gsl::finally ([&font] { font.imfont->Scale = font.scale; });
-
-    // The UI load button, otherwise we have to recreate all fonts outside the rendering loop
-    // and thats too much of hassle if not tuning all other params through the UI too.
     if (font.imfont)
-        return;
+        font.imfont->Scale = font.scale;
 
+    // From the UI load button too, the fonts are rebuilt in the background and swapped in
     font.size = jf.value ("size", font.size);
     font.glyphs = jf.value ("glyphs", font.glyphs);
     font.file = jf.value ("file", journal_directory + font.name + ".ttf");
     if (font.file.empty ())
         font.file = journal_directory + font.name + ".ttf";
     font.ranges = jf.value ("ranges", std::vector<ImWchar> {});
+    font.sdf = jf.value ("sdf", font.sdf);
 
-    auto font_atlas = imgui.igGetIO ()->Fonts;
-    ImWchar const* ranges = nullptr;
     if (font.ranges.size ())
     {
         font.ranges.push_back (0);
         font.glyphs.clear ();
     }
-    else if (font.glyphs.size ())
-    {
-        if (font.glyphs == "all")
-        {
-            static const ImWchar buff[] = { 0x0020, 0xFFEF, 0 }; // This one is tricky to avoid CDT
-            ranges = buff;
-        }
-        if (font.glyphs == "korean")
-            ranges = imgui.ImFontAtlas_GetGlyphRangesKorean (font_atlas);
-        if (font.glyphs == "japanase")
-            ranges = imgui.ImFontAtlas_GetGlyphRangesJapanese (font_atlas);
-        if (font.glyphs == "chinese full")
-            ranges = imgui.ImFontAtlas_GetGlyphRangesChineseFull (font_atlas);
-        if (font.glyphs == "chinese common")
-            ranges = imgui.ImFontAtlas_GetGlyphRangesChineseSimplifiedCommon (font_atlas);
-        if (font.glyphs == "cyrillic")
-            ranges = imgui.ImFontAtlas_GetGlyphRangesCyrillic (font_atlas);
-        if (font.glyphs == "thai")
-            ranges = imgui.ImFontAtlas_GetGlyphRangesThai (font_atlas);
-        if (font.glyphs == "vietnamese")
-            ranges = imgui.ImFontAtlas_GetGlyphRangesVietnamese (font_atlas);
-    }
 
-    if (file_exists (font.file))
-        font.imfont = imgui.ImFontAtlas_AddFontFromFileTTF (
-                font_atlas, font.file.c_str (), font.size, nullptr, ranges);
-    if (!font.imfont)
-    {
-        font.imfont = imgui.ImFontAtlas_AddFontFromMemoryCompressedBase85TTF (
-            font_atlas, font.default_data, font.size, nullptr, ranges);
-        font.file.clear ();
-    }
+    add_font (font);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -355,6 +393,7 @@ load_font (nlohmann::json const& json, font_t& font)
 bool
 load_settings ()
 {
+    trace_span_t span ("load_settings", settings_location.c_str ());
     int maj;
     journal_version (&maj, nullptr, nullptr, nullptr);
 
@@ -385,30 +424,33 @@ load_settings ()
         journal.button_font.size = 36.f;
         journal.button_font.color = IM_COL32_WHITE;
         journal.button_font.file = "";
-        journal.button_font.glyphs = "all";
+        journal.button_font.glyphs = "used";
         journal.button_font.ranges = {};
+        journal.button_font.sdf = false;
         journal.button_font.default_data = font_viner_hand;
         load_font (json, journal.button_font);
 
         journal.chapter_font.name = "chapter";
-        journal.chapter_font.glyphs = "all";
+        journal.chapter_font.glyphs = "used";
         journal.chapter_font.scale = 1.f;
         journal.chapter_font.size = 54.f;
         journal.chapter_font.color = IM_COL32_BLACK;
         journal.chapter_font.file = "";
-        journal.chapter_font.glyphs = "all";
+        journal.chapter_font.glyphs = "used";
         journal.chapter_font.ranges = {};
+        journal.chapter_font.sdf = false;
         journal.chapter_font.default_data = font_viner_hand;
         load_font (json, journal.chapter_font);
 
         journal.text_font.name = "text";
-        journal.text_font.glyphs = "all";
+        journal.text_font.glyphs = "used";
         journal.text_font.scale = 1.f;
         journal.text_font.size = 36.f;
         journal.text_font.color = IM_COL32 (21, 17, 12, 255);
         journal.text_font.file = "";
-        journal.text_font.glyphs = "all";
+        journal.text_font.glyphs = "used";
         journal.text_font.ranges = {};
+        journal.text_font.sdf = false;
         journal.text_font.default_data = font_viner_hand;
         load_font (json, journal.text_font);
 
@@ -417,16 +459,25 @@ load_settings ()
         journal.default_font.size = 18.f;
         journal.default_font.color = IM_COL32_WHITE;
         journal.default_font.file = "";
-        journal.default_font.glyphs = "all";
+        journal.default_font.glyphs = "used";
         journal.default_font.ranges = {};
+        journal.default_font.sdf = false;
         journal.default_font.default_data = font_inconsolata;
         load_font (json, journal.default_font);
+        journal.default_font.sdf = false; // Window titles are drawn by ImGui, outside our shader
 
+        journal.skin_file = json.value ("skin", default_skin_location);
         journal.background_file = journal_directory + "book.dds";
-        if (json.contains ("background"))
+        if (json.contains ("background")) // Before the skins, now for those without one
             journal.background_file = json["background"].value ("file", journal.background_file);
 
         journal.show_titlebar = json.value ("titlebar", false);
+        journal.trace = json.value ("trace", false);
+        log_threshold = json.value ("loglevel", int (log_info));
+        journal.travel_log = json.value ("travel", false);
+        journal.travel_cadence = json.value ("travelcadence", 5.f);
+        journal.show_nearby = json.value ("nearby", false);
+        journal.nearby_radius = nearby_radius_of (json.value ("nearbyradius", 8192.f));
     }
     catch (std::exception const& ex)
     {
@@ -438,9 +489,88 @@ load_settings ()
 
 //--------------------------------------------------------------------------------------------------
 
+static void
+load_rect (nlohmann::json const& json, const char* key, skin_rect_t& rect)
+{
+    if (json.contains (key))
+        rect = json[key].get<skin_rect_t> ();
+}
+
+bool
+load_skin (const char* source, skin_t& skin)
+{
+    trace_span_t span ("load_skin", source);
+    try
+    {
+        std::ifstream fi (source);
+        if (!fi.is_open ())
+        {
+            log () << "Unable to open " << source << " for reading." << std::endl;
+            return false;
+        }
+
+        nlohmann::json json;
+        fi >> json;
+
+        if (json.contains ("background"))
+        {
+            auto const& jb = json["background"];
+            skin.background_file = jb.value ("file", skin.background_file);
+            skin.background_uv = jb.value ("uv", skin.background_uv);
+        }
+
+        static const char* const sides[] = { "left", "right" };
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            if (!json.contains ("pages") || !json["pages"].contains (sides[i]))
+                continue;
+            auto const& jp = json["pages"][sides[i]];
+            load_rect (jp, "title", skin.titles[i]);
+            load_rect (jp, "text", skin.texts[i]);
+        }
+
+        for (auto& b: skin.buttons)
+        {
+            if (!json.contains ("buttons") || !json["buttons"].contains (b.key))
+                continue;
+            auto const& jb = json["buttons"][b.key];
+            b.label = jb.value ("label", b.label);
+            load_rect (jb, "rect", b.rect);
+            b.hover_tint = std::stoull (jb.value ("tint", hex_string (b.hover_tint)), nullptr, 0);
+            auto align = jb.value ("align", std::array<float, 2> {{ b.align.x, b.align.y }});
+            b.align = ImVec2 { align[0], align[1] };
+        }
+
+        // Whatever is not given is kept as currently set
+        font_t const* fonts[] = { &journal.button_font, &journal.chapter_font, &journal.text_font };
+        for (std::size_t i = 0; i < skin.fonts.size (); ++i)
+        {
+            auto section = fonts[i]->name + " font";
+            if (!json.contains ("fonts") || !json["fonts"].contains (section))
+                continue;
+            auto const& jf = json["fonts"][section];
+            auto& f = skin.fonts[i];
+            f.given = true;
+            f.file = jf.value ("file", fonts[i]->file);
+            f.size = jf.value ("size", fonts[i]->size);
+            f.color = std::stoull (jf.value ("color", hex_string (fonts[i]->color)), nullptr, 0);
+            f.sdf = jf.value ("sdf", fonts[i]->sdf);
+        }
+    }
+    catch (std::exception const& ex)
+    {
+        log () << "Unable to load skin: " << ex.what () << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 bool
-load_takenotes (std::string const& source)
+load_takenotes (const char* source)
 {
+    trace_span_t span ("load_takenotes", source);
     try
     {
         std::ifstream fi (source);
@@ -474,6 +604,8 @@ load_takenotes (std::string const& source)
             if (!entry) continue;
             pages[i].title = title->value ();
             pages[i].content = entry->value ();
+            note_glyphs (pages[i].title);
+            note_glyphs (pages[i].content);
         }
 
         while (pages.size () < 2)
@@ -482,8 +614,11 @@ load_takenotes (std::string const& source)
             pages.emplace_back (page_t {});
         }
 
+        stash_book (); // The imported one has no book file yet
         journal.pages = std::move (pages);
-        journal.current_page = 0;
+        invalidate_retained_book ();
+        invalidate_places ();
+        invalidate_chronology ();
     }
     catch (std::exception const& ex)
     {
@@ -498,6 +633,7 @@ load_takenotes (std::string const& source)
 bool
 save_variables ()
 {
+    trace_span_t span ("save_variables", variables_location.c_str ());
     try
     {
         nlohmann::json json;
@@ -508,6 +644,13 @@ save_variables ()
                 { "name", v.name.c_str () },
                 { "params", v.params.c_str () }
             });
+        // Not to lose them when their plugin was not loaded this time
+        for (auto const& v: journal.unclaimed_variables)
+            json["variables"].push_back ({
+                { "fuid", v.fuid },
+                { "name", v.name.c_str () },
+                { "params", v.params.c_str () }
+            });
 
         std::ofstream of (variables_location);
         if (!of.is_open ())
@@ -530,6 +673,7 @@ save_variables ()
 bool
 load_variables ()
 {
+    trace_span_t span ("load_variables", variables_location.c_str ());
     try
     {
         nlohmann::json json;
@@ -544,6 +688,7 @@ load_variables ()
         journal.variables.erase (std::remove_if (
                     journal.variables.begin (), journal.variables.end (), [] (auto const& v)
                     { return v.deletable; }), journal.variables.end ());
+        journal.unclaimed_variables.clear ();
 
         if (!json.contains ("variables"))
             return true;
@@ -552,16 +697,18 @@ load_variables ()
         for (auto const& jv: json["variables"])
         {
             int fuid = jv["fuid"].get<int> ();
-            for (auto const& src: journal.variables)
-                if (src.fuid == fuid)
-                {
-                    variable_t v = src;
-                    v.name = jv["name"].get<std::string> ();
-                    v.params = jv["params"].get<std::string> ();
-                    v.deletable = true;
-                    vars.emplace_back (std::move (v));
-                    break;
-                }
+            auto src = std::find_if (journal.variables.cbegin (), journal.variables.cend (),
+                    [fuid] (auto const& v) { return v.fuid == fuid; });
+            // Else of a provider yet to register, see add_provider()
+            variable_t v = src != journal.variables.cend () ? *src : variable_t {};
+            v.fuid = fuid;
+            v.name = jv["name"].get<std::string> ();
+            v.params = jv["params"].get<std::string> ();
+            v.deletable = true;
+            if (src != journal.variables.cend ())
+                vars.emplace_back (std::move (v));
+            else
+                journal.unclaimed_variables.emplace_back (std::move (v));
         }
 
         journal.variables.insert (journal.variables.begin (),
@@ -0,0 +1,862 @@
+/**
+ * @file fonts.cpp
+ * @brief Journal owned font atlas, its glyph ranges and GPU texture
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * The fonts are not put in the SSE-ImGui shared atlas, as that one can't be rebuilt once the
+ * renderer has uploaded it. Having our own atlas allows the "used" glyphs mode: only the code
+ * points found in the book, the variables and the UI are baked, along with the Latin ones most
+ * text needs anyway, and when the user types or loads something new, the atlas is baked again in
+ * the background.
+ *
+ * Each bake makes a whole new font set (atlas, texture and ImFonts) from a copy of the font
+ * settings. A worker reads the font files and the cache, else rasterizes the glyphs with
+ * rasterize_atlas(), which makes no ImGui call, then makes the distance fields, saves the cache
+ * and uploads the texture, a D3D11 device being free threaded. The render thread only makes the
+ * ImGui objects, whose allocations are counted in the context: the ImFonts of the finished glyph
+ * tables, swapped in between two frames. The previous set is released a frame later, when
+ * nothing drawn can refer to it anymore. There is no locking besides the future.
+ *
+ * Baking is slow enough to be felt on each game start, so the result (Alpha8 pixels and the glyph
+ * tables) is kept in #fonts_cache_location. It is keyed by a hash of each font data, size and
+ * glyph ranges, and restored as is while these match.
+ *
+ * Fonts with the "sdf" setting share one rasterization per face at #sdf_size, turned into signed
+ * distance field by make_sdf(). Each of them gets an ImFont with the glyph metrics scaled to its
+ * own size, and their text is drawn with a pixel shader thresholding the distance, so that any
+ * size or scale stays sharp.
+ */
+
+#include "sse-journal.hpp"
+
+#include <gsl/gsl_util>
+#include <d3dcompiler.h>
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iterator>
+#include <sstream>
+
+//--------------------------------------------------------------------------------------------------
+
+/// All fonts known to the atlas, in the order they were added, so they can be recreated at will
+static std::vector<font_t*> fonts;
+
+/// Font settings as taken for a build, the font_t itself may be tuned meanwhile
+struct font_spec_t
+{
+    font_t* font;
+    std::string source, file; ///< As set, and as loaded (empty if the default data)
+    const char* default_data;
+    float size;
+    bool sdf;
+    std::string glyphs;
+    std::vector<ImWchar> ranges;
+    std::vector<char> data;     ///< Of #file as read by the worker, else the default data once
+                                ///< decompressed, only while rasterizing
+    ImWchar const* atlas_ranges;    ///< Of #glyph_ranges(), looked up on the render thread
+};
+
+/// One rasterization per face and glyph ranges, shared by all SDF fonts using it
+struct sdf_face_t
+{
+    std::string file;
+    const char* default_data;
+    ImWchar const* ranges;
+    std::size_t face;           ///< Of the rasterized ones
+};
+
+struct cache_header_t
+{
+    char magic[8];
+    std::uint64_t key;
+    std::int32_t width, height;
+    ImVec2 uv_white, uv_scale;
+    std::uint32_t fonts;
+};
+
+struct cache_font_t
+{
+    float size, ascent, descent;
+    ImVec2 display_offset;
+    std::uint32_t fallback, glyphs;
+};
+
+/// An atlas with everything it owns, built apart and swapped in as a whole
+struct font_set_t
+{
+    std::vector<font_spec_t> specs;
+    std::bitset<0x10000> glyphs;        ///< Baked code points, for the "used" glyphs mode
+    std::vector<ImWchar> used_ranges;
+    ID3D11Device* device = nullptr;     ///< Borrowed, released once the texture is made
+    ImFontAtlas* atlas = nullptr;       ///< Without fonts, it only holds the texture for them
+    ID3D11ShaderResourceView* view = nullptr;
+    std::vector<ImFont*> imfonts;       ///< Same order as #specs, made by #install_font_set()
+    std::ostringstream messages;        ///< Logged back on the render thread
+    std::uint64_t key = 0;              ///< Of the cache, see #cache_key()
+    cache_header_t header;              ///< Read from the cache, else rasterized, with the rest:
+    std::vector<cache_font_t> metrics;  ///< Same order as #specs
+    std::vector<std::vector<ImFontGlyph>> glyph_tables;
+    std::vector<unsigned char> pixels;  ///< Alpha8, until uploaded
+};
+
+static std::unique_ptr<font_set_t> current_set, retired_set;
+/// Built on a worker, see #refresh_fonts()
+static std::future<std::unique_ptr<font_set_t>> pending_build;
+
+/// Code points seen so far and the ones in the current atlas ("used" glyphs mode only)
+static std::bitset<0x10000> used_glyphs, baked_glyphs;
+static bool rebuild_pending = false;
+
+/// Always in the "used" glyphs: ASCII, Latin-1 and Latin Extended-A, most European languages
+constexpr unsigned preset_glyphs_end = 0x180;
+
+/// Fonts not owned by an atlas still need a config, AddGlyph() reads its spacing
+static ImFontConfig* detached_config = nullptr;
+
+constexpr float sdf_size = 48.f; ///< Rasterization size of the SDF faces
+constexpr int sdf_spread = 4;    ///< Distance in pixels covered by half of the 0-255 range
+
+static ID3D11DeviceContext* sdf_context = nullptr;
+static ID3D11PixelShader* sdf_shader = nullptr;
+static ID3D11PixelShader* sdf_saved_shader = nullptr;
+
+//--------------------------------------------------------------------------------------------------
+
+/// Minimal UTF-8 decoding, invalid sequences are skipped, as ImGui will show them as '?' anyway
+
+template<class F>
+static void
+for_each_codepoint (const char* s, const char* e, F&& f)
+{
+    if (!e)
+        e = s + std::strlen (s);
+    while (s < e && *s)
+    {
+        unsigned c = static_cast<unsigned char> (*s++);
+        if (c < 0x80)
+        {
+            f (c);
+            continue;
+        }
+        int n = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+        if (!n || e - s < n)
+            continue;
+        c &= 0x3f >> n;
+        for (; n; --n)
+            c = (c << 6) | (static_cast<unsigned char> (*s++) & 0x3f);
+        f (c);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static bool
+uses_glyph_set (std::string const& glyphs)
+{
+    return std::any_of (fonts.cbegin (), fonts.cend (),
+            [&glyphs] (font_t const* f) { return f->ranges.empty () && f->glyphs == glyphs; });
+}
+
+void
+note_glyph (unsigned c)
+{
+    if (c < preset_glyphs_end || c > 0xffff || used_glyphs[c])
+        return;
+    used_glyphs.set (c);
+    if (!baked_glyphs[c] && uses_glyph_set ("used"))
+        rebuild_pending = true;
+}
+
+void
+note_glyphs (const char* text, const char* text_end)
+{
+    for_each_codepoint (text, text_end, note_glyph);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Runs of the noted code points, in ImGui format: pairs of inclusive bounds, ending with zero
+
+static std::vector<ImWchar>
+make_used_ranges ()
+{
+    for (unsigned c = 0x20; c < preset_glyphs_end; ++c)
+        if (c < 0x7f || c >= 0xa0) // Not the C1 controls
+            used_glyphs.set (c);
+
+    std::vector<ImWchar> ranges;
+    for (unsigned c = 1; c < used_glyphs.size (); ++c)
+    {
+        if (!used_glyphs[c])
+            continue;
+        unsigned b = c;
+        while (c+1 < used_glyphs.size () && used_glyphs[c+1])
+            ++c;
+        ranges.push_back (ImWchar (b));
+        ranges.push_back (ImWchar (c));
+    }
+    ranges.push_back (0);
+    return ranges;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static ImWchar const*
+glyph_ranges (font_set_t const& set, font_spec_t const& font)
+{
+    auto atlas = set.atlas; // The language tables are static, any atlas will do
+    if (font.ranges.size ())
+        return font.ranges.data ();
+    if (font.glyphs == "used")
+        return set.used_ranges.data ();
+    if (font.glyphs == "all")
+    {
+        static const ImWchar buff[] = { 0x0020, 0xFFEF, 0 }; // This one is tricky to avoid CDT
+        return buff;
+    }
+    if (font.glyphs == "korean")
+        return imgui.ImFontAtlas_GetGlyphRangesKorean (atlas);
+    if (font.glyphs == "japanase")
+        return imgui.ImFontAtlas_GetGlyphRangesJapanese (atlas);
+    if (font.glyphs == "chinese full")
+        return imgui.ImFontAtlas_GetGlyphRangesChineseFull (atlas);
+    if (font.glyphs == "chinese common")
+        return imgui.ImFontAtlas_GetGlyphRangesChineseSimplifiedCommon (atlas);
+    if (font.glyphs == "cyrillic")
+        return imgui.ImFontAtlas_GetGlyphRangesCyrillic (atlas);
+    if (font.glyphs == "thai")
+        return imgui.ImFontAtlas_GetGlyphRangesThai (atlas);
+    if (font.glyphs == "vietnamese")
+        return imgui.ImFontAtlas_GetGlyphRangesVietnamese (atlas);
+    return nullptr;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+add_font (font_t& font)
+{
+    if (std::find (fonts.cbegin (), fonts.cend (), &font) == fonts.cend ())
+        fonts.push_back (&font);
+    rebuild_pending = bool (current_set); // Otherwise the first build, once the book is known
+
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// The D3D11 device is borrowed from a texture made by SSE-ImGui, i.e. the book background
+
+static ID3D11Device*
+borrow_device ()
+{
+    ID3D11Device* device = nullptr;
+    if (journal.background)
+        journal.background->GetDevice (&device);
+    return device;
+}
+
+static ID3D11ShaderResourceView*
+upload_atlas (ID3D11Device* device, unsigned char const* alpha8, int width, int height)
+{
+    if (!device || !alpha8)
+        return nullptr;
+
+    // Same as ImGui does for RGBA32: white, with the coverage in the alpha
+    std::vector<std::uint32_t> rgba (std::size_t (width) * height);
+    for (std::size_t i = 0; i < rgba.size (); ++i)
+        rgba[i] = IM_COL32 (255, 255, 255, alpha8[i]);
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    D3D11_SUBRESOURCE_DATA data = {};
+    data.pSysMem = rgba.data ();
+    data.SysMemPitch = desc.Width * 4;
+
+    ID3D11Texture2D* texture = nullptr;
+    if (device->CreateTexture2D (&desc, &data, &texture) != S_OK)
+        return nullptr;
+    auto release_texture = gsl::finally ([texture] { texture->Release (); });
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC view_desc = {};
+    view_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    view_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    view_desc.Texture2D.MipLevels = desc.MipLevels;
+    ID3D11ShaderResourceView* view = nullptr;
+    if (device->CreateShaderResourceView (texture, &view_desc, &view) != S_OK)
+        return nullptr;
+    return view;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Same input as the ImGui DX11 renderer pixel shader, but the alpha is a distance to threshold
+
+static const char sdf_shader_source[] = R"(
+struct PS_INPUT
+{
+    float4 pos : SV_POSITION;
+    float4 col : COLOR0;
+    float2 uv  : TEXCOORD0;
+};
+sampler sampler0;
+Texture2D texture0;
+
+float4 main (PS_INPUT input) : SV_Target
+{
+    float d = texture0.Sample (sampler0, input.uv).a;
+    float w = max (fwidth (d), 1e-4);
+    return float4 (input.col.rgb, input.col.a * smoothstep (.5 - w, .5 + w, d));
+}
+)";
+
+static bool
+create_sdf_shader ()
+{
+    if (sdf_shader)
+        return true;
+
+    auto device = borrow_device ();
+    if (!device)
+        return false;
+    auto release_device = gsl::finally ([device] { device->Release (); });
+
+    // Not linked against, same as the ImGui renderer only the runtime DLL is needed
+    auto lib = ::LoadLibraryW (L"d3dcompiler_47.dll");
+    if (!lib)
+    {
+        log () << "Unable to load d3dcompiler_47.dll for the SDF fonts." << std::endl;
+        return false;
+    }
+    auto free_lib = gsl::finally ([lib] { ::FreeLibrary (lib); });
+    auto compile = reinterpret_cast<pD3DCompile> (::GetProcAddress (lib, "D3DCompile"));
+    if (!compile)
+        return false;
+
+    ID3DBlob *code = nullptr, *errors = nullptr;
+    compile (sdf_shader_source, sizeof (sdf_shader_source) - 1, nullptr, nullptr, nullptr,
+            "main", "ps_4_0", 0, 0, &code, &errors);
+    if (errors)
+    {
+        log () << "SDF shader: " << static_cast<const char*> (errors->GetBufferPointer ())
+               << std::endl;
+        errors->Release ();
+    }
+    if (!code)
+        return false;
+    device->CreatePixelShader (code->GetBufferPointer (), code->GetBufferSize (),
+            nullptr, &sdf_shader);
+    code->Release ();
+    if (!sdf_shader)
+        return false;
+
+    device->GetImmediateContext (&sdf_context);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Called by the renderer in between the draw commands
+
+static void
+sdf_shader_on (ImDrawList const*, ImDrawCmd const*)
+{
+    sdf_context->PSGetShader (&sdf_saved_shader, nullptr, nullptr);
+    sdf_context->PSSetShader (sdf_shader, nullptr, 0);
+}
+
+static void
+sdf_shader_off (ImDrawList const*, ImDrawCmd const*)
+{
+    sdf_context->PSSetShader (sdf_saved_shader, nullptr, 0);
+    if (sdf_saved_shader)
+        sdf_saved_shader->Release ();
+    sdf_saved_shader = nullptr;
+}
+
+/// As baked, the setting may have been changed since, or be without a shader
+
+static bool
+baked_sdf (font_t const& font)
+{
+    if (!current_set || !sdf_shader)
+        return false;
+    for (auto const& spec: current_set->specs)
+        if (spec.font == &font)
+            return spec.sdf;
+    return false;
+}
+
+void
+begin_font_shader (font_t const& font, ImDrawList* dl)
+{
+    if (baked_sdf (font))
+        imgui.ImDrawList_AddCallback (
+                dl ? dl : imgui.igGetWindowDrawList (), sdf_shader_on, nullptr);
+}
+
+void
+end_font_shader (font_t const& font, ImDrawList* dl)
+{
+    if (baked_sdf (font))
+        imgui.ImDrawList_AddCallback (
+                dl ? dl : imgui.igGetWindowDrawList (), sdf_shader_off, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// ImFont using the atlas texture, but not in its list, as the set owns it
+
+static ImFont*
+detached_font (ImFontAtlas* atlas, cache_font_t const& m, std::vector<ImFontGlyph> const& glyphs)
+{
+    auto imf = imgui.ImFont_ImFont ();
+    imf->FontSize = m.size;
+    imf->Ascent = m.ascent;
+    imf->Descent = m.descent;
+    imf->DisplayOffset = m.display_offset;
+    imf->ContainerAtlas = atlas;
+    imf->ConfigData = detached_config;
+    imf->ConfigDataCount = 1;
+    for (auto const& g: glyphs)
+        imgui.ImFont_AddGlyph (imf, g.Codepoint, g.X0, g.Y0, g.X1, g.Y1,
+                g.U0, g.V0, g.U1, g.V1, g.AdvanceX);
+    imgui.ImFont_SetFallbackChar (imf, ImWchar (m.fallback)); // Builds the lookups
+    return imf;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Converts the rasterized glyphs of the SDF faces to distance fields
+
+static void
+make_sdf_fields (font_set_t& set, std::vector<sdf_face_t> const& faces,
+        std::vector<atlas_font_t> const& rasterized)
+{
+    auto pixels = set.pixels.data ();
+    auto const& hdr = set.header;
+    const int w = hdr.width, h = hdr.height;
+    std::vector<unsigned char> coverage (pixels, pixels + std::size_t (w) * h);
+    for (auto const& face: faces)
+        for (auto const& g: rasterized[face.face].glyphs)
+        {
+            int x0 = std::max (0, int (g.U0 / hdr.uv_scale.x + .5f) - sdf_spread);
+            int y0 = std::max (0, int (g.V0 / hdr.uv_scale.y + .5f) - sdf_spread);
+            int x1 = std::min (w, int (g.U1 / hdr.uv_scale.x + .5f) + sdf_spread);
+            int y1 = std::min (h, int (g.V1 / hdr.uv_scale.y + .5f) + sdf_spread);
+            if (x1 > x0 && y1 > y0)
+                make_sdf (coverage.data (), pixels, w, x0, y0, x1 - x0, y1 - y0, sdf_spread);
+        }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// The file as read by the worker, else the default data, which its empty name then tells
+
+static void
+read_font_data (font_set_t& set, font_spec_t& spec)
+{
+    if (spec.file.empty () || !file_exists (spec.file))
+    {
+        spec.file.clear ();
+        return;
+    }
+    std::ifstream fi (spec.file, std::ios::binary);
+    spec.data.assign (std::istreambuf_iterator<char> (fi), std::istreambuf_iterator<char> ());
+    if (is_truetype (spec.data))
+        return;
+    set.messages << "Unable to use " << spec.file << " (not a TrueType font), using the default.\n";
+    spec.data = {};
+    spec.file.clear ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Worker side, the bitmap fonts get a face each, the SDF ones share it at #sdf_size and get
+/// their glyphs scaled from it
+
+static bool
+rasterize_font_set (font_set_t& set)
+{
+    std::vector<atlas_face_t> faces;
+    std::vector<sdf_face_t> sdf_faces;
+    std::vector<std::size_t> face_of;
+    for (auto& spec: set.specs)
+    {
+        auto ranges = spec.atlas_ranges;
+        if (spec.data.empty () && !decompress_base85_ttf (spec.default_data, spec.data))
+        {
+            set.messages << "Unable to decompress the default font.\n";
+            return false;
+        }
+        if (!spec.sdf)
+        {
+            face_of.push_back (faces.size ());
+            faces.push_back (atlas_face_t { &spec.data, spec.size, ranges, 1 });
+            continue;
+        }
+        auto it = std::find_if (sdf_faces.begin (), sdf_faces.end (), [&] (sdf_face_t const& f) {
+            return f.file == spec.file && f.default_data == spec.default_data && f.ranges == ranges;
+        });
+        if (it == sdf_faces.end ())
+        {
+            it = sdf_faces.insert (sdf_faces.end (),
+                    sdf_face_t { spec.file, spec.default_data, ranges, faces.size () });
+            // The field of a glyph spreads over its padding, so it never reaches another one
+            faces.push_back (atlas_face_t { &spec.data, sdf_size, ranges, sdf_spread });
+        }
+        face_of.push_back (it->face);
+    }
+
+    std::vector<atlas_font_t> rasterized;
+    atlas_pixels_t atlas;
+    if (!rasterize_atlas (faces, rasterized, atlas))
+    {
+        set.messages << "Unable to rasterize the fonts.\n";
+        return false;
+    }
+
+    set.header.width = atlas.width;
+    set.header.height = atlas.height;
+    set.header.uv_white = atlas.uv_white;
+    set.header.uv_scale = atlas.uv_scale;
+    set.pixels = std::move (atlas.alpha8);
+    if (!sdf_faces.empty ())
+        make_sdf_fields (set, sdf_faces, rasterized);
+
+    set.metrics.clear ();
+    set.glyph_tables.clear ();
+    for (std::size_t i = 0; i < set.specs.size (); ++i)
+    {
+        auto const& face = rasterized[face_of[i]];
+        float k = set.specs[i].size / faces[face_of[i]].size;
+        set.metrics.push_back (cache_font_t {
+                set.specs[i].size, face.ascent * k, face.descent * k, ImVec2 {}, '?',
+                std::uint32_t (face.glyphs.size ()) });
+        set.glyph_tables.push_back (face.glyphs);
+        for (auto& g: set.glyph_tables.back ())
+        {
+            g.X0 *= k, g.Y0 *= k, g.X1 *= k, g.Y1 *= k;
+            g.AdvanceX *= k;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// FNV-1a, good enough to tell font configurations apart
+
+static std::uint64_t
+fnv1a (void const* data, std::size_t size, std::uint64_t h = 0xcbf29ce484222325ull)
+{
+    for (auto p = static_cast<unsigned char const*> (data), e = p + size; p != e; ++p)
+        h = (h ^ *p) * 0x100000001b3ull;
+    return h;
+}
+
+/// What would be given to #rasterize_font_set(), plus the format and layout versions
+
+static std::uint64_t
+cache_key (font_set_t const& set)
+{
+    // The glyphs are cached as ImGui lays them out
+    constexpr std::uint32_t version[] = { 3, IMGUI_VERSION_NUM, sizeof (ImFontGlyph) };
+    auto h = fnv1a (version, sizeof (version));
+    for (auto const& spec: set.specs)
+    {
+        auto f = &spec;
+        if (!f->data.empty ())
+            h = fnv1a (f->data.data (), f->data.size (), h);
+        else h = fnv1a (f->default_data, std::strlen (f->default_data), h);
+
+        h = fnv1a (&f->size, sizeof (f->size), h);
+        h = fnv1a (&f->sdf, sizeof (f->sdf), h);
+        if (auto r = spec.atlas_ranges)
+            for (; *r; ++r)
+                h = fnv1a (r, sizeof (*r), h);
+    }
+    return h;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static constexpr char cache_magic[8] = { 'S','S','E','J','F','N','T','\0' };
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+save_cache (font_set_t& set)
+{
+    try
+    {
+        std::ofstream of (fonts_cache_location, std::ios::binary);
+        if (!of.is_open ())
+        {
+            set.messages << "Unable to open " << fonts_cache_location << " for writting.\n";
+            return;
+        }
+
+        auto hdr = set.header;
+        std::copy_n (cache_magic, sizeof (cache_magic), hdr.magic);
+        hdr.key = set.key;
+        hdr.fonts = std::uint32_t (set.metrics.size ());
+        of.write (reinterpret_cast<const char*> (&hdr), sizeof (hdr));
+
+        for (std::size_t i = 0; i < set.metrics.size (); ++i)
+        {
+            of.write (reinterpret_cast<const char*> (&set.metrics[i]), sizeof (cache_font_t));
+            of.write (reinterpret_cast<const char*> (set.glyph_tables[i].data ()),
+                    sizeof (ImFontGlyph) * set.glyph_tables[i].size ());
+        }
+
+        of.write (reinterpret_cast<const char*> (set.pixels.data ()), set.pixels.size ());
+    }
+    catch (std::exception const& ex)
+    {
+        set.messages << "Unable to save fonts cache: " << ex.what () << '\n';
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Leaves the set untouched unless all of the cache could be read
+
+static bool
+read_cache (font_set_t& set)
+{
+    auto const n = set.specs.size ();
+    std::ifstream fi (fonts_cache_location, std::ios::binary);
+    if (!fi.is_open ())
+        return false;
+
+    cache_header_t hdr;
+    if (!fi.read (reinterpret_cast<char*> (&hdr), sizeof (hdr))
+            || !std::equal (cache_magic, cache_magic + sizeof (cache_magic), hdr.magic)
+            || hdr.key != set.key || hdr.fonts != n
+            || hdr.width <= 0 || hdr.height <= 0 || hdr.width > 16384 || hdr.height > 16384)
+        return false;
+
+    std::vector<cache_font_t> metrics (n);
+    std::vector<std::vector<ImFontGlyph>> glyphs (n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (!fi.read (reinterpret_cast<char*> (&metrics[i]), sizeof (cache_font_t))
+                || metrics[i].glyphs > 0x10000)
+            return false;
+        glyphs[i].resize (metrics[i].glyphs);
+        if (!fi.read (reinterpret_cast<char*> (glyphs[i].data ()),
+                    sizeof (ImFontGlyph) * glyphs[i].size ()))
+            return false;
+    }
+    std::vector<unsigned char> alpha8 (std::size_t (hdr.width) * hdr.height);
+    if (!fi.read (reinterpret_cast<char*> (alpha8.data ()), alpha8.size ()))
+        return false;
+
+    set.header = hdr;
+    set.metrics = std::move (metrics);
+    set.glyph_tables = std::move (glyphs);
+    set.pixels = std::move (alpha8);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Render thread side, only what is shared with ImGui: the shader and the (empty) atlas
+
+static std::unique_ptr<font_set_t>
+make_font_set ()
+{
+    // The settings keep asking for SDF, only the set falls back to bitmaps
+    static bool no_shader = false;
+    bool sdf = std::any_of (fonts.cbegin (), fonts.cend (), [] (font_t* f) { return f->sdf; });
+    if (sdf && !no_shader && !create_sdf_shader ())
+    {
+        log () << "No SDF shader, using plain bitmap fonts." << std::endl;
+        no_shader = true;
+    }
+    if (!detached_config)
+        detached_config = imgui.ImFontConfig_ImFontConfig ();
+
+    auto set = std::make_unique<font_set_t> ();
+    if (uses_glyph_set ("used"))
+        set->used_ranges = make_used_ranges ();
+    set->glyphs = used_glyphs;
+    for (auto f: fonts)
+        set->specs.push_back (font_spec_t {
+                f, f->file, f->file, f->default_data, f->size, f->sdf && sdf_shader, f->glyphs,
+                f->ranges });
+    set->device = borrow_device ();
+
+    set->atlas = imgui.ImFontAtlas_ImFontAtlas ();
+    for (auto& spec: set->specs)
+        spec.atlas_ranges = glyph_ranges (*set, spec);
+    return set;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Worker side, all but the ImGui objects: the glyphs read from the cache, else rasterized, then
+/// uploaded. The set is returned even on failure, for its messages.
+
+static std::unique_ptr<font_set_t>
+build_font_set (std::unique_ptr<font_set_t> set)
+{
+    trace_span_t span ("build_font_set");
+    for (auto& spec: set->specs)
+        read_font_data (*set, spec);
+    set->key = cache_key (*set);
+    if (!read_cache (*set))
+    {
+        trace_span_t span ("rasterize_font_set");
+        if (rasterize_font_set (*set))
+            save_cache (*set);
+        else set->pixels.clear ();
+    }
+    for (auto& spec: set->specs)
+        spec.data = {};
+
+    if (!set->pixels.empty ())
+        set->view = upload_atlas (
+                set->device, set->pixels.data (), set->header.width, set->header.height);
+    set->pixels = {}; // Only the GPU copy is needed
+    if (!set->view)
+        set->messages << "Unable to build the fonts texture.\n";
+    if (set->device)
+        set->device->Release ();
+    set->device = nullptr; // Not in a gsl::finally(), the set is moved out by the return
+    return set;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+destroy_font_set (std::unique_ptr<font_set_t>& set)
+{
+    if (!set)
+        return;
+    for (auto f: set->imfonts)
+        imgui.ImFont_destroy (f);
+    if (set->atlas)
+        imgui.ImFontAtlas_destroy (set->atlas);
+    if (set->view)
+        set->view->Release ();
+    set.reset ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Makes the ImFonts of the built glyph tables and points all font_t to them, the current set is
+/// retired for a frame
+
+static bool
+install_font_set (std::unique_ptr<font_set_t> set)
+{
+    trace_span_t span ("install_font_set");
+    auto msg = set->messages.str ();
+    if (!msg.empty ())
+        log () << msg << std::flush;
+    if (!set->view)
+    {
+        destroy_font_set (set);
+        return false;
+    }
+
+    auto const& hdr = set->header;
+    set->atlas->TexWidth = hdr.width;
+    set->atlas->TexHeight = hdr.height;
+    set->atlas->TexUvWhitePixel = hdr.uv_white;
+    set->atlas->TexUvScale = hdr.uv_scale;
+    imgui.ImFontAtlas_SetTexID (set->atlas, set->view);
+    for (std::size_t i = 0; i < set->specs.size (); ++i)
+        set->imfonts.push_back (detached_font (set->atlas, set->metrics[i], set->glyph_tables[i]));
+    set->metrics = {};
+    set->glyph_tables = {};
+
+    for (std::size_t i = 0; i < set->specs.size (); ++i)
+    {
+        auto const& spec = set->specs[i];
+        auto f = spec.font;
+        // Scales are tuned through the UI directly on the ImFont objects
+        if (f->imfont)
+            f->scale = f->imfont->Scale;
+        f->imfont = set->imfonts[i];
+        f->imfont->Scale = f->scale;
+        if (f->file == spec.source)
+            f->file = spec.file;
+    }
+    baked_glyphs = set->glyphs;
+
+    destroy_font_set (retired_set);
+    retired_set = std::move (current_set);
+    current_set = std::move (set);
+    invalidate_retained_book (); // A new ImFont may reuse the address of a gone one
+    relayout_book (); // Button labels are measured with the fonts
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+build_fonts ()
+{
+    if (pending_build.valid ())
+    {
+        auto stale = pending_build.get ();
+        destroy_font_set (stale);
+    }
+    rebuild_pending = false;
+    return install_font_set (build_font_set (make_font_set ()));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+refresh_fonts ()
+{
+    // Swapped out on the previous call, so the frame drawn since did not refer to it
+    destroy_font_set (retired_set);
+
+    if (pending_build.valid ()
+            && pending_build.wait_for (std::chrono::seconds (0)) == std::future_status::ready)
+        install_font_set (pending_build.get ());
+
+    if (rebuild_pending && current_set && !pending_build.valid ())
+    {
+        rebuild_pending = false;
+        pending_build = std::async (std::launch::async, build_font_set, make_font_set ());
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,469 @@
+/**
+ * @file input.cpp
+ * @brief Recording of the ImGui input into a file, and its replay with the frame timings
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * A record is a small header and then each frame as what changed since the previous one: a mask
+ * followed by only the fields it names. Quiet frames take two or six bytes (the delta time
+ * usually changes), so minutes of input fit in a few hundred kilobytes. Recording encodes as it
+ * goes, the file is written when it stops.
+ *
+ * The replay sets the ImGui input from within render(), i.e. after ImGui read it for the frame:
+ * the typed characters are seen by the widgets right away, the mouse and the keys on the next
+ * frame. Hence an in game replay is one frame late against its recording, but the same on every
+ * run, as long as the real mouse and keyboard stay untouched meanwhile. The headless benchmarks
+ * apply the frames before render() instead (see bench/bench_replay.cpp).
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr char input_magic[4] = { 'S', 'J', 'I', 'R' };
+constexpr std::uint32_t input_version = 1;
+
+/// Which fields follow the mask of a frame
+enum : std::uint16_t
+{
+    field_delta     = 1 << 0,
+    field_display   = 1 << 1,
+    field_mouse     = 1 << 2,
+    field_buttons   = 1 << 3,
+    field_wheel     = 1 << 4,
+    field_modifiers = 1 << 5,
+    field_keys      = 1 << 6,
+    field_chars     = 1 << 7,
+    field_window    = 1 << 8
+};
+
+static struct
+{
+    input_mode_t mode;
+    std::string data;           ///< Encoded frames being recorded
+    input_frame_t previous;     ///< Last encoded, or decoded
+    input_frame_t frame;        ///< Being recorded
+    std::size_t count;          ///< Recorded frames
+    bool pressed;
+    std::size_t press_size, press_count;    ///< Where the last mouse press began
+    std::vector<input_frame_t> frames;      ///< Being replayed
+    std::size_t next;
+    std::vector<float> frame_ms, journal_ms;
+    std::uint64_t begin_ticks, last_ticks;
+}
+input = {};
+
+//--------------------------------------------------------------------------------------------------
+
+template<class T>
+static inline void
+put (std::string& out, T const& v)
+{
+    out.append (reinterpret_cast<const char*> (&v), sizeof (T));
+}
+
+template<class T>
+static inline bool
+get (const char*& p, const char* end, T& v)
+{
+    if (std::size_t (end - p) < sizeof (T))
+        return false;
+    std::memcpy (&v, p, sizeof (T));
+    p += sizeof (T);
+    return true;
+}
+
+static inline bool
+same (ImVec2 const& a, ImVec2 const& b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+encode_frame (input_frame_t const& f, input_frame_t& prev, std::string& out)
+{
+    std::uint16_t mask = 0;
+    if (f.delta_time != prev.delta_time) mask |= field_delta;
+    if (!same (f.display_size, prev.display_size)) mask |= field_display;
+    if (!same (f.mouse_pos, prev.mouse_pos)) mask |= field_mouse;
+    if (f.mouse_down != prev.mouse_down) mask |= field_buttons;
+    if (f.wheel || f.wheel_h) mask |= field_wheel;
+    if (f.modifiers != prev.modifiers) mask |= field_modifiers;
+    if (f.keys != prev.keys) mask |= field_keys;
+    if (!f.chars.empty ()) mask |= field_chars;
+    if (!same (f.window_pos, prev.window_pos) || !same (f.window_size, prev.window_size))
+        mask |= field_window;
+
+    put (out, mask);
+    if (mask & field_delta) put (out, f.delta_time);
+    if (mask & field_display) put (out, f.display_size);
+    if (mask & field_mouse) put (out, f.mouse_pos);
+    if (mask & field_buttons) put (out, f.mouse_down);
+    if (mask & field_wheel) put (out, f.wheel), put (out, f.wheel_h);
+    if (mask & field_modifiers) put (out, f.modifiers);
+    if (mask & field_keys)
+    {
+        // The toggled ones, rarely more than a couple
+        auto toggled = f.keys ^ prev.keys;
+        put (out, std::uint16_t (toggled.count ()));
+        for (std::uint16_t k = 0; k < toggled.size (); ++k)
+            if (toggled[k])
+                put (out, k);
+    }
+    if (mask & field_chars)
+    {
+        put (out, std::uint16_t (f.chars.size ()));
+        for (auto c: f.chars)
+            put (out, c);
+    }
+    if (mask & field_window) put (out, f.window_pos), put (out, f.window_size);
+
+    // Only what persists across frames is a base for the next one
+    prev.delta_time = f.delta_time;
+    prev.display_size = f.display_size;
+    prev.mouse_pos = f.mouse_pos;
+    prev.mouse_down = f.mouse_down;
+    prev.modifiers = f.modifiers;
+    prev.keys = f.keys;
+    prev.window_pos = f.window_pos;
+    prev.window_size = f.window_size;
+}
+
+static bool
+decode_frame (const char*& p, const char* end, input_frame_t& f)
+{
+    std::uint16_t mask, n;
+    if (!get (p, end, mask))
+        return false;
+    bool ok = true;
+    f.wheel = f.wheel_h = 0;
+    f.chars.clear ();
+    if (mask & field_delta) ok = ok && get (p, end, f.delta_time);
+    if (mask & field_display) ok = ok && get (p, end, f.display_size);
+    if (mask & field_mouse) ok = ok && get (p, end, f.mouse_pos);
+    if (mask & field_buttons) ok = ok && get (p, end, f.mouse_down);
+    if (mask & field_wheel) ok = ok && get (p, end, f.wheel) && get (p, end, f.wheel_h);
+    if (mask & field_modifiers) ok = ok && get (p, end, f.modifiers);
+    if (ok && (mask & field_keys))
+    {
+        ok = get (p, end, n);
+        for (std::uint16_t i = 0, k; ok && i < n; ++i)
+            if ((ok = get (p, end, k) && k < f.keys.size ()))
+                f.keys.flip (k);
+    }
+    if (ok && (mask & field_chars))
+    {
+        ok = get (p, end, n);
+        for (ImWchar i = 0, c; ok && i < n; ++i)
+            if ((ok = get (p, end, c)))
+                f.chars.push_back (c);
+    }
+    if (mask & field_window)
+        ok = ok && get (p, end, f.window_pos) && get (p, end, f.window_size);
+    return ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+input_frame_t
+capture_input (ImGuiIO const& io)
+{
+    input_frame_t f = {};
+    f.delta_time = io.DeltaTime;
+    f.display_size = io.DisplaySize;
+    f.mouse_pos = io.MousePos;
+    f.wheel = io.MouseWheel;
+    f.wheel_h = io.MouseWheelH;
+    for (unsigned i = 0; i < 5; ++i)
+        f.mouse_down |= io.MouseDown[i] << i;
+    f.modifiers = io.KeyCtrl | io.KeyShift << 1 | io.KeyAlt << 2 | io.KeySuper << 3;
+    for (std::size_t k = 0; k < f.keys.size (); ++k)
+        f.keys[k] = io.KeysDown[k];
+    auto const& q = io.InputQueueCharacters;
+    f.chars.assign (q.Data, q.Data + q.Size);
+    return f;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static bool
+write_record (std::string const& destination, std::size_t count, std::string const& data)
+{
+    std::ofstream of (destination, std::ios::binary);
+    if (!of.is_open ())
+    {
+        log () << "Unable to open " << destination << " for writting." << std::endl;
+        return false;
+    }
+    std::string header (input_magic, sizeof (input_magic));
+    put (header, input_version);
+    put (header, std::uint32_t (count));
+    of << header << data;
+    if (!of)
+    {
+        log () << "Unable to write " << destination << '.' << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool
+write_input_record (std::string const& destination, std::vector<input_frame_t> const& frames)
+{
+    std::string data;
+    input_frame_t prev = {};
+    for (auto const& f: frames)
+        encode_frame (f, prev, data);
+    return write_record (destination, frames.size (), data);
+}
+
+bool
+read_input_record (std::string const& source, std::vector<input_frame_t>& frames)
+{
+    std::ifstream fi (source, std::ios::binary);
+    if (!fi.is_open ())
+    {
+        log () << "Unable to open " << source << " for reading." << std::endl;
+        return false;
+    }
+    std::string data ((std::istreambuf_iterator<char> (fi)), std::istreambuf_iterator<char> ());
+
+    const char* p = data.data (), *end = p + data.size ();
+    char magic[4];
+    std::uint32_t version, count;
+    if (!get (p, end, magic) || std::memcmp (magic, input_magic, sizeof (magic))
+            || !get (p, end, version) || version != input_version || !get (p, end, count))
+    {
+        log () << source << " is not an input record of version " << input_version << '.'
+               << std::endl;
+        return false;
+    }
+
+    frames.clear ();
+    frames.reserve (count);
+    input_frame_t f = {};
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (!decode_frame (p, end, f))
+        {
+            log () << source << " is truncated at frame " << i << '.' << std::endl;
+            return false;
+        }
+        frames.push_back (f);
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+start_input_recording ()
+{
+    if (input.mode != input_idle)
+        stop_input ();
+    input.mode = input_recording;
+    input.data.clear ();
+    input.previous = input_frame_t {};
+    input.frame = input_frame_t {};
+    input.count = input.press_size = input.press_count = 0;
+    input.pressed = false;
+    return true;
+}
+
+bool
+start_input_replay ()
+{
+    if (input.mode != input_idle)
+        stop_input ();
+    if (!read_input_record (input_location, input.frames))
+        return false;
+    input.mode = input_replaying;
+    input.next = 0;
+    input.frame_ms.clear ();
+    input.journal_ms.clear ();
+    input.frame_ms.reserve (input.frames.size ());
+    input.journal_ms.reserve (input.frames.size ());
+    input.last_ticks = 0;
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Mouse and keys as the replay left them would stick, until the real ones change
+static void
+release_input ()
+{
+    auto io = imgui.igGetIO ();
+    for (auto& down: io->MouseDown)
+        down = false;
+    auto const& f = input.frames[input.next - 1];
+    for (std::size_t k = 0; k < f.keys.size (); ++k)
+        if (f.keys[k])
+            io->KeysDown[k] = false;
+    io->KeyCtrl = io->KeyShift = io->KeyAlt = io->KeySuper = false;
+}
+
+static bool
+save_timings ()
+{
+    std::ofstream of (input_timings_location);
+    if (!of.is_open ())
+    {
+        log () << "Unable to open " << input_timings_location << " for writting." << std::endl;
+        return false;
+    }
+    of << "frame,frame_ms,journal_ms\n" << std::fixed << std::setprecision (4);
+    for (std::size_t i = 0; i < input.journal_ms.size (); ++i)
+        of << i << ',' << input.frame_ms[i] << ',' << input.journal_ms[i] << '\n';
+
+    if (!input.journal_ms.empty ())
+    {
+        auto ms = input.journal_ms;
+        std::sort (ms.begin (), ms.end ());
+        log () << "Replayed " << ms.size () << " frames, journal median "
+               << ms[ms.size () / 2] << " ms, p99 " << ms[ms.size () * 99 / 100] << " ms."
+               << std::endl;
+    }
+    return bool (of);
+}
+
+bool
+stop_input ()
+{
+    auto mode = input.mode;
+    input.mode = input_idle;
+    if (mode == input_recording)
+    {
+        // The click which stopped the recording is not part of it
+        if (input.pressed)
+            input.data.resize (input.press_size), input.count = input.press_count;
+        return write_record (input_location, input.count, input.data);
+    }
+    if (mode == input_replaying)
+    {
+        if (input.next)
+            release_input ();
+        input.frames.clear ();
+        return save_timings ();
+    }
+    return true;
+}
+
+input_status_t
+input_status ()
+{
+    if (input.mode == input_replaying)
+        return input_status_t { input.mode, input.next, input.frames.size () };
+    return input_status_t { input.mode, input.count, input.count };
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Most of it applies on the next frame, see the file notes
+static void
+apply_input (input_frame_t const& f)
+{
+    auto io = imgui.igGetIO ();
+    io->MousePos = f.mouse_pos;
+    for (unsigned i = 0; i < 5; ++i)
+        io->MouseDown[i] = (f.mouse_down >> i) & 1;
+    io->MouseWheel = f.wheel;
+    io->MouseWheelH = f.wheel_h;
+    io->KeyCtrl = f.modifiers & 1;
+    io->KeyShift = f.modifiers & 2;
+    io->KeyAlt = f.modifiers & 4;
+    io->KeySuper = f.modifiers & 8;
+    for (std::size_t k = 0; k < f.keys.size (); ++k)
+        io->KeysDown[k] = f.keys[k];
+    for (auto c: f.chars)
+        imgui.ImGuiIO_AddInputCharacter (io, c);
+    if (f.window_size.x > 0 && f.window_size.y > 0)
+    {
+        imgui.igSetNextWindowPos (f.window_pos, ImGuiCond_Always, ImVec2 {});
+        imgui.igSetNextWindowSize (f.window_size, ImGuiCond_Always);
+    }
+}
+
+void
+begin_input_frame ()
+{
+    if (input.mode == input_idle)
+        return;
+    input.begin_ticks = profile_ticks ();
+
+    if (input.mode == input_recording)
+    {
+        // The window is not there while collapsed, it stays where it was then
+        auto pos = input.frame.window_pos, size = input.frame.window_size;
+        input.frame = capture_input (*imgui.igGetIO ());
+        input.frame.window_pos = pos;
+        input.frame.window_size = size;
+        return;
+    }
+
+    if (input.next >= input.frames.size ())
+    {
+        stop_input ();
+        return;
+    }
+    // Between the starts of render(), so the whole game frame, none before the first one
+    auto interval = input.last_ticks ? input.begin_ticks - input.last_ticks : 0;
+    input.frame_ms.push_back (interval * 1e-6f);
+    input.last_ticks = input.begin_ticks;
+    apply_input (input.frames[input.next++]);
+}
+
+void
+input_book_window ()
+{
+    if (input.mode != input_recording)
+        return;
+    input.frame.window_pos = imgui.igGetWindowPos ();
+    input.frame.window_size = imgui.igGetWindowSize ();
+}
+
+void
+end_input_frame ()
+{
+    if (input.mode == input_recording)
+    {
+        if ((input.frame.mouse_down & 1) && !(input.previous.mouse_down & 1))
+        {
+            input.pressed = true;
+            input.press_size = input.data.size ();
+            input.press_count = input.count;
+        }
+        encode_frame (input.frame, input.previous, input.data);
+        ++input.count;
+    }
+    else if (input.mode == input_replaying)
+        input.journal_ms.push_back ((profile_ticks () - input.begin_ticks) * 1e-6f);
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,263 @@
+/**
+ * @file logger.cpp
+ * @brief Log file written by a background thread
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * A line is composed on the calling thread, in a reused per thread buffer, and posted as a whole
+ * with its time into the same kind of queue as the mod commands. Neither the time formatting nor
+ * the file are touched there. The writer thread wakes up every so often, or right away for
+ * errors and half full queues, formats the time once per second and flushes once per wake up.
+ *
+ * Whoever drains the queue holds #draining, so the crash handler and the exit can write what is
+ * left even while (or instead of) the writer thread.
+ */
+
+#include "sse-journal.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+//--------------------------------------------------------------------------------------------------
+
+/// [shared] Reports current log file path (for user friendly messages)
+std::string logfile_path;
+
+std::atomic<int> log_threshold { log_info };
+
+/// Log file in pre-defined location
+static std::ofstream logfile;
+
+struct log_entry_t
+{
+    std::chrono::system_clock::time_point time;
+    log_level_t level;
+    std::string text;
+};
+
+constexpr std::size_t queue_size = 1024;
+static mpsc_queue_t<log_entry_t, queue_size> queue;
+static std::atomic<std::uint64_t> dropped { 0 };
+/// Roughly how many are queued, to wake up the writer before a burst fills it up
+static std::atomic<std::size_t> waiting { 0 };
+
+static std::atomic_flag draining = ATOMIC_FLAG_INIT;
+static std::atomic<bool> stopping { false };
+static std::mutex wake_mutex;
+static std::condition_variable wake;
+
+static LPTOP_LEVEL_EXCEPTION_FILTER previous_filter = nullptr;
+
+//--------------------------------------------------------------------------------------------------
+
+/// Consumer only, the local time is looked up once per second at most
+
+static void
+write_prefix (log_entry_t const& e)
+{
+    static std::time_t last = -1;
+    static char stamp[64] = "";
+
+    auto now_c = std::chrono::system_clock::to_time_t (e.time);
+    if (now_c != last)
+    {
+        last = now_c;
+        auto loc_c = std::localtime (&now_c);
+        std::snprintf (stamp, sizeof (stamp), "[%04d-%02d-%02d %02d:%02d:%02d] ",
+                1900 + loc_c->tm_year, 1 + loc_c->tm_mon, loc_c->tm_mday,
+                loc_c->tm_hour, loc_c->tm_min, loc_c->tm_sec);
+    }
+    logfile << stamp;
+
+    switch (e.level)
+    {
+        case log_debug: logfile << "Debug: "; break;
+        case log_warning: logfile << "Warning: "; break;
+        case log_error: logfile << "Error: "; break;
+        default: break;
+    }
+}
+
+/// Consumer only
+
+static void
+write_entries ()
+{
+    static std::uint64_t reported = 0;
+    log_entry_t e;
+    std::size_t n = 0;
+    while (queue.pop (e))
+    {
+        ++n;
+        write_prefix (e);
+        logfile << e.text;
+        if (e.text.empty () || e.text.back () != '\n')
+            logfile << '\n';
+    }
+    waiting.fetch_sub (n, std::memory_order_relaxed);
+
+    auto lost = dropped.load (std::memory_order_relaxed);
+    if (lost != reported)
+    {
+        logfile << "Dropped " << lost - reported << " log lines, the queue was full.\n";
+        reported = lost;
+        ++n;
+    }
+    if (n)
+        logfile.flush ();
+}
+
+/// Gives up after @param spins if the writer holds the queue (e.g. it was killed meanwhile)
+
+static void
+drain (unsigned spins)
+{
+    bool owned = false;
+    for (unsigned i = 0; i < spins && !owned; ++i)
+        if (!(owned = !draining.test_and_set (std::memory_order_acquire)))
+            std::this_thread::yield ();
+    if (!owned)
+        return;
+    write_entries ();
+    draining.clear (std::memory_order_release);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+writer_loop ()
+{
+    while (!stopping.load (std::memory_order_relaxed))
+    {
+        {
+            std::unique_lock<std::mutex> lock (wake_mutex);
+            wake.wait_for (lock, std::chrono::milliseconds (100));
+        }
+        drain (~0u);
+    }
+}
+
+static LONG WINAPI
+crash_filter (EXCEPTION_POINTERS* info)
+{
+    drain (1000);
+    return previous_filter ? previous_filter (info) : EXCEPTION_CONTINUE_SEARCH;
+}
+
+static void
+close_log ()
+{
+    stopping = true;
+    drain (1000);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+open_log ()
+{
+    logfile_path = "";
+    if (known_folder_path (FOLDERID_Documents, logfile_path))
+    {
+        // Before plugins are loaded, SKSE takes care to create the directiories
+        logfile_path += "\\My Games\\Skyrim Special Edition\\SKSE\\";
+    }
+    logfile_path += "sse-journal.log";
+    logfile.open (logfile_path);
+
+    // Detached, as on exit the threads are gone before the statics are destroyed
+    std::thread (writer_loop).detach ();
+    std::atexit (close_log);
+    previous_filter = SetUnhandledExceptionFilter (crash_filter);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+log_line_t::log_line_t (log_level_t level, log_limit_t* limit)
+    : level (level)
+{
+    if (level < log_threshold.load (std::memory_order_relaxed))
+        return;
+
+    unsigned suppressed = 0;
+    if (limit)
+    {
+        auto now = std::chrono::duration_cast<std::chrono::seconds> (
+                std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+        auto second = limit->second.load (std::memory_order_relaxed);
+        if (second != now && limit->second.compare_exchange_strong (second, now))
+        {
+            limit->count.store (0, std::memory_order_relaxed);
+            suppressed = limit->suppressed.exchange (0, std::memory_order_relaxed);
+        }
+        if (limit->count.fetch_add (1, std::memory_order_relaxed) >= limit->per_second)
+        {
+            limit->suppressed.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // The same thread may compose another line while this one is open (e.g. an argument logs)
+    thread_local std::ostringstream buffer;
+    thread_local bool busy = false;
+    static std::ios const defaults (nullptr);
+    if (busy)
+    {
+        own.reset (new std::ostringstream);
+        out = own.get ();
+    }
+    else
+    {
+        busy = true;
+        buffer.str (std::string ());
+        buffer.clear ();
+        buffer.copyfmt (defaults); // Manipulators of the previous line stick otherwise
+        out = &buffer;
+        owner = &busy;
+    }
+
+    if (suppressed)
+        *out << '(' << suppressed << " similar lines suppressed) ";
+}
+
+log_line_t::~log_line_t ()
+{
+    if (!out)
+        return;
+    log_entry_t e { std::chrono::system_clock::now (), level, out->str () };
+    if (owner)
+        *owner = false;
+    if (!queue.push (std::move (e)))
+    {
+        dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+    auto queued = waiting.fetch_add (1, std::memory_order_relaxed) + 1;
+    if (level >= log_error || queued == queue_size / 2)
+        wake.notify_one ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,237 @@
+/**
+ * @file placeholders.cpp
+ * @brief Journal Variables written into the pages as {name} or {name:parameters}
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * The pages keep the templates, the book shows their expansions. A shown text is looked up by
+ * its address, and its expansion is reused while the template is the same and the values are
+ * younger than #refresh_seconds. The template is compared whole: the text boxes write into the
+ * pages in place, so there is no edit count to go by, and a compare is still much less than the
+ * expansion. Texts without any placeholder are remembered as such, and not scanned again.
+ *
+ * A placeholder evaluates a copy of its variable with its own parameters, kept for the next
+ * time, so the format of the variable is compiled once and a provider caches by them.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr double refresh_seconds = 1;   ///< The game time goes by a minute in three seconds
+constexpr std::size_t max_expansions = 64;
+constexpr std::size_t max_bound = 32;
+
+struct expansion_t
+{
+    std::string source;     ///< Template it was made of
+    std::string text;
+    std::uint64_t expires;  ///< In #profile_ticks()
+    bool any;               ///< Placeholders in #source, else #text is left empty
+};
+
+static struct
+{
+    std::unordered_map<std::string const*, expansion_t> expansions;
+    std::vector<variable_t> bound;  ///< Copies with the parameters of the placeholders
+    std::uint64_t generation;
+}
+placeholders = {};
+
+//--------------------------------------------------------------------------------------------------
+
+static inline char
+key_of (char c)
+{
+    return std::isalnum (static_cast<unsigned char> (c))
+        ? char (std::tolower (static_cast<unsigned char> (c))) : '_';
+}
+
+std::string
+placeholder_key (std::string const& name)
+{
+    // "Game time (fixed)" is game_time
+    std::string key;
+    for (auto c: name.substr (0, name.find ('(')))
+        key += key_of (c);
+    while (!key.empty () && key.back () == '_')
+        key.pop_back ();
+    return key;
+}
+
+/// As placeholder_key (@param name) == @param key, without making it
+static bool
+named (std::string const& name, std::string_view key)
+{
+    std::size_t k = 0;
+    for (std::size_t i = 0, n = std::min (name.find ('('), name.size ()); i < n; ++i)
+    {
+        auto c = key_of (name[i]);
+        if (k < key.size () && c == key[k])
+            ++k;
+        else if (c != '_' || k < key.size ())
+            return false;
+    }
+    return k == key.size () && k;
+}
+
+static variable_t*
+find_variable (std::string_view key)
+{
+    for (auto& v: journal.variables)
+        if ((!v.deletable && v.key == key) || named (v.name, key))
+            return &v;
+    return nullptr;
+}
+
+/// A copy of the variable with @param params, or nullptr if none is named @param key
+static variable_t*
+bind_variable (std::string_view key, std::string_view const* params)
+{
+    auto v = find_variable (key);
+    if (!v)
+        return nullptr;
+    auto p = params ? *params : std::string_view (v->params);
+    auto& bound = placeholders.bound;
+    auto it = std::find_if (bound.begin (), bound.end (), [v, p] (auto const& b) {
+        return b.fuid == v->fuid && b.name == v->name && b.params == p;
+    });
+    if (it != bound.end ())
+        return &*it;
+    if (bound.size () >= max_bound)
+        bound.clear ();
+    bound.push_back (*v);
+    bound.back ().params = p;
+    return &bound.back ();
+}
+
+static inline bool
+key_char (char c)
+{
+    return c == '_' || std::isalnum (static_cast<unsigned char> (c));
+}
+
+bool
+expand_placeholders (std::string const& source, std::string& out)
+{
+    static alloc_site_t site ("expand_placeholders");
+    alloc_scope_t allocs (site);
+
+    // The UI input boxes keep the strings padded with zeros
+    std::string_view text (source.c_str ());
+    out.clear ();
+    bool any = false;
+    std::size_t copied = 0;
+    for (auto open = text.find ('{'); open != text.npos; open = text.find ('{', open + 1))
+    {
+        auto end = open + 1;
+        while (end < text.size () && key_char (text[end]))
+            ++end;
+        if (end == open + 1 || end == text.size ())
+            continue;
+        auto key = text.substr (open + 1, end - open - 1);
+        std::string_view params;
+        bool given = text[end] == ':';
+        if (given)
+        {
+            auto close = text.find_first_of ("{}\n", end + 1);
+            if (close == text.npos || text[close] != '}')
+                continue;
+            params = text.substr (end + 1, close - end - 1);
+            end = close;
+        }
+        if (text[end] != '}')
+            continue;
+        auto v = bind_variable (key, given ? &params : nullptr);
+        if (!v)
+            continue; // Stays as typed
+        out.append (text, copied, open - copied);
+        out += (*v) ();
+        copied = end + 1;
+        any = true;
+    }
+    if (any)
+        out.append (text, copied);
+    return any;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string const*
+expanded_text (std::string const& text)
+{
+    auto& cache = placeholders.expansions;
+    auto it = cache.find (&text);
+    if (it == cache.end ())
+    {
+        if (cache.size () >= max_expansions)
+            cache.clear ();
+        it = cache.emplace (&text, expansion_t {}).first;
+    }
+    auto& e = it->second;
+    bool same = e.source == text;
+    if (same && !e.any)
+        return nullptr;
+    auto now = profile_ticks ();
+    if (same && now < e.expires)
+        return &e.text;
+
+    static std::string expanded;
+    bool any = expand_placeholders (text, expanded);
+    if (!same)
+    {
+        e.source = text;
+        ++placeholders.generation;
+    }
+    e.any = any;
+    e.expires = now + std::uint64_t (refresh_seconds * 1e9);
+    if (!any)
+        e.text.clear ();
+    else if (expanded != e.text)
+    {
+        std::swap (e.text, expanded);
+        note_glyphs (e.text);
+        ++placeholders.generation;
+    }
+    return any ? &e.text : nullptr;
+}
+
+std::uint64_t
+placeholders_generation ()
+{
+    return placeholders.generation;
+}
+
+void
+invalidate_placeholders ()
+{
+    placeholders.expansions.clear ();
+    placeholders.bound.clear ();
+    ++placeholders.generation;
+}
+
+//--------------------------------------------------------------------------------------------------
+
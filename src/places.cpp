@@ -0,0 +1,171 @@
+/**
+ * @file places.cpp
+ * @brief Where the pages were written, and which of them were written near the player
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * The index is a grid per space: the worldspace, or the cell for interiors, whose coordinates
+ * are their own. A grid square is a game cell (4096 units), holding the indices of the pages
+ * tagged in it, so a query looks at a few squares around the player instead of the whole book.
+ *
+ * Page indices shift with any insertion or deletion, hence the index is rebuilt from scratch
+ * once invalidated, on the next query. That is a pass over the book, but only after it changed.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr float grid_size = 4096;
+
+using grid_t = std::unordered_map<std::uint64_t, std::vector<unsigned>>;
+
+static struct
+{
+    std::unordered_map<std::string, grid_t> spaces;
+    bool valid;
+}
+places = {};
+
+static inline std::string const&
+space_of (geotag_t const& tag)
+{
+    return tag.worldspace.empty () ? tag.cell : tag.worldspace;
+}
+
+static inline std::uint64_t
+square_key (std::int32_t x, std::int32_t y)
+{
+    return std::uint64_t (std::uint32_t (x)) << 32 | std::uint32_t (y);
+}
+
+static inline std::int32_t
+square_of (float v)
+{
+    return std::int32_t (std::clamp (std::floor (double (v) / grid_size), -2e9, 2e9));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+geotag_page (page_t& page)
+{
+    auto state = game_state ();
+    if (!state.position_ok)
+        return false;
+    page.place.tagged = true;
+    page.place.worldspace = state.worldspace;
+    page.place.cell = state.cell;
+    std::copy (state.position, state.position + 3, page.place.position);
+    invalidate_places ();
+    return true;
+}
+
+void
+invalidate_places ()
+{
+    places.valid = false;
+}
+
+static void
+build_places ()
+{
+    trace_span_t span ("build_places");
+    places.spaces.clear ();
+    for (unsigned i = 0; i < journal.pages.size (); ++i)
+    {
+        auto const& tag = journal.pages[i].place;
+        if (!tag.tagged || space_of (tag).empty ())
+            continue;
+        auto key = square_key (square_of (tag.position[0]), square_of (tag.position[1]));
+        places.spaces[space_of (tag)][key].push_back (i);
+    }
+    places.valid = true;
+}
+
+float
+nearby_radius_of (float radius)
+{
+    return std::isnan (radius) ? 8192.f : std::clamp (radius, 512.f, 65536.f);
+}
+
+void
+pages_near_player (float radius, std::vector<place_hit_t>& hits)
+{
+    radius = nearby_radius_of (radius);
+    hits.clear ();
+    if (!places.valid)
+        build_places ();
+
+    auto state = game_state ();
+    if (!state.position_ok)
+        return;
+    geotag_t here;
+    here.worldspace = state.worldspace;
+    here.cell = state.cell;
+    auto it = places.spaces.find (space_of (here));
+    if (it == places.spaces.end ())
+        return;
+
+    auto const* p = state.position;
+    auto near = [&] (std::vector<unsigned> const& square) {
+        for (auto i: square)
+        {
+            auto const* q = journal.pages[i].place.position;
+            float dx = q[0] - p[0], dy = q[1] - p[1], dz = q[2] - p[2];
+            float d = std::sqrt (dx*dx + dy*dy + dz*dz);
+            if (d <= radius)
+                hits.push_back (place_hit_t { i, d });
+        }
+    };
+
+    // A span wider than the occupied squares goes through those instead
+    auto const& grid = it->second;
+    auto x0 = square_of (p[0] - radius), x1 = square_of (p[0] + radius);
+    auto y0 = square_of (p[1] - radius), y1 = square_of (p[1] + radius);
+    auto span = (std::int64_t (x1) - x0 + 1) * (std::int64_t (y1) - y0 + 1);
+    if (span > std::int64_t (grid.size ()))
+    {
+        for (auto const& square: grid)
+            near (square.second);
+    }
+    else
+    {
+        for (auto x = x0; x <= x1; ++x)
+            for (auto y = y0; y <= y1; ++y)
+            {
+                auto square = grid.find (square_key (x, y));
+                if (square != grid.end ())
+                    near (square->second);
+            }
+    }
+    std::sort (hits.begin (), hits.end (), [] (auto const& a, auto const& b) {
+        return a.distance < b.distance;
+    });
+}
+
+//--------------------------------------------------------------------------------------------------
+
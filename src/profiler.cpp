@@ -0,0 +1,202 @@
+/**
+ * @file profiler.cpp
+ * @brief Frame timings of the journal render path
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * Stage times are summed up during a frame and pushed as one sample into a fixed ring buffer when
+ * the frame scope ends. Only the render thread writes, any thread may take a snapshot: the write
+ * counter is published after the sample, and samples which may have been overwritten while
+ * copying are dropped, so no lock is ever taken.
+ *
+ * The innermost stage is kept per thread, so the allocation counting (see allocs.cpp) knows where
+ * it is. Stages are exclusive for the allocations, but inclusive for the times.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+
+//--------------------------------------------------------------------------------------------------
+
+bool profiler_enabled = false;
+
+const char* const profile_stage_names[stage_count] = {
+    "frame", "journal_command", "draw_book", "draw_settings", "draw_elements", "draw_chapters",
+    "draw_saveas", "draw_load", "draw_nearby", "draw_timeline"
+};
+
+/// About 17 seconds at 60 FPS
+static std::array<profile_sample_t, 1024> ring;
+static std::atomic<std::uint64_t> written { 0 };
+static profile_sample_t current = {};
+
+//--------------------------------------------------------------------------------------------------
+
+std::uint64_t
+profile_ticks ()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds> (steady_clock::now ().time_since_epoch ()).count ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static thread_local profile_stage_t innermost = stage_count;
+
+profile_stage_t
+profile_scope_t::current_stage ()
+{
+    return innermost;
+}
+
+void
+profile_scope_t::enter (profile_stage_t stage)
+{
+    this->stage = stage;
+    outer = innermost;
+    innermost = stage;
+    start = profile_ticks ();
+}
+
+void
+profile_scope_t::leave ()
+{
+    current.ms[stage] += (profile_ticks () - start) * 1e-6f;
+    innermost = outer;
+    if (stage != stage_frame)
+        return;
+
+    if (alloc_tracking.load (std::memory_order_relaxed))
+        ++alloc_tracked_frames;
+    auto n = written.load (std::memory_order_relaxed);
+    current.frame = n;
+    ring[n % ring.size ()] = current;
+    written.store (n + 1, std::memory_order_release);
+    current = profile_sample_t {};
+}
+
+void
+profile_note_allocation (profile_stage_t stage, std::size_t size)
+{
+    current.allocs[stage]++;
+    current.alloc_bytes[stage] += std::uint32_t (size);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+profile_snapshot (std::vector<profile_sample_t>& out)
+{
+    out.clear ();
+    auto n = written.load (std::memory_order_acquire);
+    auto first = n > ring.size () ? n - ring.size () : 0;
+    for (auto i = first; i < n; ++i)
+        out.push_back (ring[i % ring.size ()]);
+
+    // Slots the writer reached meanwhile, or may be writing right now, are not trusted
+    auto m = written.load (std::memory_order_acquire) + 1;
+    auto lost = m > ring.size () ? std::min<std::uint64_t> (m - ring.size (), n) : 0;
+    if (lost > first)
+        out.erase (out.begin (), out.begin () + std::ptrdiff_t (lost - first));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+profile_summary_t const&
+profile_summary ()
+{
+    static profile_summary_t summary;
+    static std::vector<profile_sample_t> samples;
+    static std::vector<float> sorted;
+
+    profile_snapshot (samples);
+    summary.avg_ms.fill (0);
+    summary.p99_ms.fill (0);
+    summary.avg_allocs.fill (0);
+    summary.avg_alloc_bytes.fill (0);
+    summary.frame_ms.clear ();
+    for (auto const& s: samples)
+        summary.frame_ms.push_back (s.ms[stage_frame]);
+    if (samples.empty ())
+        return summary;
+
+    for (int st = 0; st < stage_count; ++st)
+    {
+        sorted.clear ();
+        for (auto const& s: samples)
+            sorted.push_back (s.ms[st]);
+        auto p99 = sorted.begin () + std::ptrdiff_t (sorted.size () * 99 / 100);
+        std::nth_element (sorted.begin (), p99, sorted.end ());
+        summary.p99_ms[st] = *p99;
+        for (auto v: sorted)
+            summary.avg_ms[st] += v;
+        summary.avg_ms[st] /= sorted.size ();
+        for (auto const& s: samples)
+        {
+            summary.avg_allocs[st] += s.allocs[st];
+            summary.avg_alloc_bytes[st] += s.alloc_bytes[st];
+        }
+        summary.avg_allocs[st] /= samples.size ();
+        summary.avg_alloc_bytes[st] /= samples.size ();
+    }
+    return summary;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+export_profile (std::string const& destination)
+{
+    std::vector<profile_sample_t> samples;
+    profile_snapshot (samples);
+
+    std::ofstream of (destination);
+    if (!of.is_open ())
+    {
+        log () << "Unable to open " << destination << " for writting." << std::endl;
+        return false;
+    }
+
+    of << "frame";
+    for (auto name: profile_stage_names)
+        of << ',' << name;
+    for (auto name: profile_stage_names)
+        of << ',' << name << " allocs," << name << " bytes";
+    of << '\n' << std::fixed << std::setprecision (4);
+    for (auto const& s: samples)
+    {
+        of << s.frame;
+        for (auto v: s.ms)
+            of << ',' << v;
+        for (int st = 0; st < stage_count; ++st)
+            of << ',' << s.allocs[st] << ',' << s.alloc_bytes[st];
+        of << '\n';
+    }
+    return bool (of);
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -32,8 +32,6 @@
 
 //--------------------------------------------------------------------------------------------------
 
-auto constexpr lite_tint = IM_COL32 (191, 157, 111,  64);
-auto constexpr dark_tint = IM_COL32 (191, 157, 111,  96);
 auto constexpr frame_col = IM_COL32 (192, 157, 111, 192);
 using namespace std::string_literals;
 
@@ -42,41 +40,45 @@ journal_t journal = {};
 //--------------------------------------------------------------------------------------------------
 
 ImVec2 button_t::wpos = {};
-ImVec2 button_t::wsz = {};
 
-void button_t::init (
-        const char* label,
-        float tlx, float tly, float szx, float szy,
-        std::uint32_t hover, float ax, float ay)
+void
+button_t::init (skin_button_t const& skin)
+{
+    label = skin.label + "##" + skin.key;
+    label_size = skin.label.size ();
+    rect = skin.rect;
+    align = skin.align;
+    hover_tint = skin.hover_tint;
+}
+
+void
+button_t::layout (ImVec2 const& wsz, std::array<float, 4> const& uv)
 {
-    this->align = ImVec2 { ax, ay };
-    this->label = label;
-    label_end = std::strchr (label, '#');
-    tl.x = tlx, tl.y = tly, sz.x = szx, sz.y = szy;
-    hover_tint = hover;
+    pos  = ImVec2 { wsz.x * rect[0], wsz.y * rect[1] };
+    size = ImVec2 { wsz.x * rect[2], wsz.y * rect[3] };
+    auto txtsz = imgui.igCalcTextSize (label.c_str (), label.c_str () + label_size, false, -1.f);
+    text_pos = ImVec2 { pos.x + align.x * (size.x - txtsz.x),
+                        pos.y + align.y * (size.y - txtsz.y) };
+    float du = uv[2] - uv[0], dv = uv[3] - uv[1];
+    uv0 = ImVec2 { uv[0] + du * rect[0], uv[1] + dv * rect[1] };
+    uv1 = ImVec2 { uv[0] + du * (rect[0] + rect[2]), uv[1] + dv * (rect[1] + rect[3]) };
 }
 
-bool button_t::draw ()
+bool
+button_t::draw ()
 {
     imgui.igPushFont (journal.button_font.imfont);
     imgui.igPushStyleColorU32 (ImGuiCol_Text, journal.button_font.color);
-    ImVec2 ptl { wsz.x * tl.x, wsz.y * tl.y },
-           psz { wsz.x * sz.x, wsz.y * sz.y };
-    imgui.igSetCursorPos (ptl);
-    bool pressed = imgui.igInvisibleButton (label, psz);
-    bool hovered = imgui.igIsItemHovered (0);
-    if (hovered)
-    {
-        constexpr float vmax = .7226f; // The Background Y pixels reach ~72% of a 2k texture
+    imgui.igSetCursorPos (pos);
+    bool pressed = imgui.igInvisibleButton (label.c_str (), size);
+    if (imgui.igIsItemHovered (0))
         imgui.ImDrawList_AddImage (imgui.igGetWindowDrawList (), journal.background,
-            ImVec2 { wpos.x + ptl.x,         wpos.y + ptl.y         },
-            ImVec2 { wpos.x + ptl.x + psz.x, wpos.y + ptl.y + psz.y },
-            ImVec2 { tl.x, tl.y*vmax }, ImVec2 { tl.x + sz.x, (tl.y + sz.y)*vmax }, hover_tint);
-    }
-    auto txtsz = imgui.igCalcTextSize (label, label_end, false, -1.f);
-    imgui.igSetCursorPos (ImVec2 { ptl.x + align.x * (psz.x - txtsz.x),
-                                   ptl.y + align.y * (psz.y - txtsz.y) });
-    imgui.igTextUnformatted (label, label_end);
+            ImVec2 { wpos.x + pos.x,          wpos.y + pos.y          },
+            ImVec2 { wpos.x + pos.x + size.x, wpos.y + pos.y + size.y }, uv0, uv1, hover_tint);
+    imgui.igSetCursorPos (text_pos);
+    begin_font_shader (journal.button_font);
+    imgui.igTextUnformatted (label.c_str (), label.c_str () + label_size);
+    end_font_shader (journal.button_font);
     imgui.igPopFont ();
     imgui.igPopStyleColor (1);
     return pressed;
@@ -87,36 +89,47 @@ bool button_t::draw ()
 bool
 setup ()
 {
+    // Startup is always traced, but kept only if the settings say so
+    trace_enabled = true;
+    auto trace_end = gsl::finally ([] {
+        if (!journal.trace)
+            trace_enabled = false, clear_trace ();
+    });
+    trace_span_t span ("setup");
+
     load_settings (); // File may not exist yet
+    open_travel ();
     journal.variables = make_variables (); // Loading vars, needs these
     load_variables ();
 
-    if (!sseimgui.ddsfile_texture (journal.background_file.c_str (), nullptr, &journal.background))
+    // A missing or broken skin should not leave the journal without any
+    if (!use_skin (journal.skin_file.c_str (), false))
     {
-        log () << "Unable to load DDS." << std::endl;
-        return false;
+        log () << "Falling back to the built-in skin." << std::endl;
+        if (!use_skin (nullptr, false))
+            return false;
     }
-
-    auto& j = journal;
-    j.button_prev     .init ("Prev##B"    ,   0.f, 0, .050f,   1.f, lite_tint);
-    j.button_settings .init ("Settings##B", .070f, 0, .128f, .060f, dark_tint, .5f, .85f);
-    j.button_elements .init ("Elements##B", .212f, 0, .128f, .060f, dark_tint, .5f, .85f);
-    j.button_chapters .init ("Chapters##B", .354f, 0, .128f, .060f, dark_tint, .5f, .85f);
-    j.button_save     .init ("Save##B"    , .528f, 0, .128f, .060f, dark_tint, .5f, .85f);
-    j.button_saveas   .init ("Save As##B" , .670f, 0, .128f, .060f, dark_tint, .5f, .85f);
-    j.button_load     .init ("Load##B"    , .812f, 0, .128f, .060f, dark_tint, .5f, .85f);
-    j.button_next     .init ("Next##B"    ,  .95f, 0, .050f,   1.f, lite_tint);
+    refresh_skin ();
 
     // Fun experiment: ~half a second to load/save 1000 pages with 40k symbols each.
     // This is like ~40MB file, or something like 40 fat books of 500 pages each one. Should be
     // bearable in practice for lower spec machines. The ImGui is well responsive btw.
 
-    load_book (default_book); // This one also may not exist
+    load_book (default_book.c_str ()); // This one also may not exist
     if (journal.pages.size () < 3)
         journal.pages.resize (2);
     if (journal.current_page+2 >= journal.pages.size ())
         journal.current_page = 0;
 
+    // The book glyphs are noted while loading, the rest of the shown text is here
+    for (auto const& v: journal.variables)
+        note_glyphs (v.name), note_glyphs (v.params), note_glyphs (v.info);
+    note_glyphs (logfile_path);
+    note_glyphs (books_directory);
+
+    if (!build_fonts ())
+        return false;
+
     return true;
 }
 
@@ -141,25 +154,34 @@ append_input (std::string& text, std::string const& suffix)
     text.insert (sz, suffix);
 }
 
+/// Grows the strings, and notes the glyphs of what is typed or pasted, not of the whole text
+
 static int
-imgui_text_resize (ImGuiInputTextCallbackData* data)
+imgui_text_callback (ImGuiInputTextCallbackData* data)
 {
+    static alloc_site_t site ("imgui_text_callback");
+    alloc_scope_t allocs (site);
     if (data->EventFlag == ImGuiInputTextFlags_CallbackResize)
     {
         auto str = reinterpret_cast<std::string*> (data->UserData);
         str->resize (next_pow2 (data->BufSize) - 1); // likely to avoid the internal pow2 of resize
         data->Buf = const_cast<char*> (str->c_str ());
     }
+    else if (data->EventFlag == ImGuiInputTextFlags_CallbackCharFilter)
+        note_glyph (data->EventChar);
     return 0;
 }
 
+constexpr ImGuiInputTextFlags imgui_text_flags =
+    ImGuiInputTextFlags_CallbackResize | ImGuiInputTextFlags_CallbackCharFilter;
+
 /// Shared
 bool
 imgui_input_text (const char* label, std::string& text, ImGuiInputTextFlags flags = 0)
 {
     return imgui.igInputText (
             label, const_cast<char*> (text.c_str ()), text.size () + 1,
-            flags | ImGuiInputTextFlags_CallbackResize, imgui_text_resize, &text);
+            flags | imgui_text_flags, imgui_text_callback, &text);
 }
 
 /// Shared
@@ -169,7 +191,21 @@ imgui_input_multiline (
 {
     return imgui.igInputTextMultiline (
             label, const_cast<char*> (text.c_str ()), text.size () + 1,
-            size, flags | ImGuiInputTextFlags_CallbackResize, imgui_text_resize, &text);
+            size, flags | imgui_text_flags, imgui_text_callback, &text);
+}
+
+/// Enters the child window of a multiline text box ahead of it, with the same id and size as in
+/// igInputTextMultiline(), which then appends to it. The cursor is put back for the text box.
+
+static ImDrawList*
+multiline_draw_list (const char* label, ImVec2 const& size)
+{
+    auto cursor = imgui.igGetCursorPos ();
+    imgui.igBeginChildFrame (imgui.igGetIDStr (label), size, 0);
+    auto dl = imgui.igGetWindowDrawList ();
+    imgui.igEndChildFrame ();
+    imgui.igSetCursorPos (cursor);
+    return dl;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -191,46 +227,154 @@ popup_error (bool begin, const char* name)
 
 //--------------------------------------------------------------------------------------------------
 
-/// This must be called before the main window begin()
+/// Paths of the files picked in the UI are needed only for the click, see #frame_arena
+
+static frame_string_t
+frame_path (std::string const& directory, const char* name, const char* extension)
+{
+    frame_string_t path (directory.c_str (), directory.size ());
+    return path.append (name).append (extension);
+}
+
+static inline frame_string_t
+frame_path (std::string const& directory, std::string const& name, const char* extension)
+{
+    return frame_path (directory, name.c_str (), extension);
+}
+//--------------------------------------------------------------------------------------------------
+
+/// Mod commands run also while the journal is hidden, what they ask of the window waits for it
 
+static bool book_window_wanted = false;
+
+void
+show_book_window ()
+{
+    book_window_wanted = true;
+}
+
+/// Right before the book window begins
 static void
-journal_command ()
+book_window_requests ()
 {
-    if (journal_message.empty ())
+    if (!book_window_wanted)
         return;
-    auto clear = gsl::finally ([] { journal_message.clear (); });
+    book_window_wanted = false;
+    if (journal.show_titlebar)
+        imgui.igSetNextWindowCollapsed (false, 0);
+    imgui.igSetNextWindowFocus ();
+}
 
-    auto pos = journal_message.find_last_of ('@');
-    if (pos != std::string::npos)
-    {
-        auto book = books_directory + journal_message.substr (pos + 1) + ".json";
-        if (!load_book (book))
-        {
-            log () << "Unable to load mod requested book " << book << std::endl;
-            return;
-        }
-        journal_message.erase (journal_message.begin () + pos);
-    }
+//--------------------------------------------------------------------------------------------------
 
+/// Finds waiting for their book to be read in the background
+
+static struct
+{
+    std::string book, text;
+}
+pending_find;
+
+static void
+show_found (std::string const& text)
+{
     auto it = std::find_if (journal.pages.cbegin (), journal.pages.cend (),
-            [] (page_t const& p)
+            [&text] (page_t const& p)
             {
-                return p.title.find (journal_message) != std::string::npos
-                  || p.content.find (journal_message) != std::string::npos;
+                return p.title.find (text) != std::string::npos
+                  || p.content.find (text) != std::string::npos;
             });
 
     if (it == journal.pages.cend ())
     {
-        log () << "Unable to find mod requested string " << journal_message << std::endl;
+        static log_limit_t limit (5);
+        log (log_warning, &limit) << "Unable to find mod requested string " << text << std::endl;
         return;
     }
 
     auto page = std::distance (journal.pages.cbegin (), it);
     journal.current_page = std::min (std::size_t (page), journal.pages.size () - 2);
+    show_book_window ();
+}
 
-    if (journal.show_titlebar)
-        imgui.igSetNextWindowCollapsed (false, 0);
-    imgui.igSetNextWindowFocus ();
+/// SSE-MapTrack request: switch the book, if given after the last @, and show the found page
+
+static void
+find_command (std::string& text)
+{
+    pending_find = {};
+    auto pos = text.find_last_of ('@');
+    if (pos != std::string::npos)
+    {
+        std::string book = frame_path (books_directory, text.c_str () + pos + 1, ".json").c_str ();
+        text.erase (text.begin () + pos, text.end ());
+        if (!open_book (book))
+        {
+            pending_find.book = std::move (book);
+            pending_find.text = std::move (text);
+            return;
+        }
+    }
+    show_found (text);
+}
+
+/// A book asked for from the Load window failed to read, for its popup on the next shown frame
+static bool load_failed = false;
+
+/// Swaps in a book read in the background, and finishes the find which waited for it
+
+static void
+journal_books ()
+{
+    auto read = poll_books ();
+    if (read == book_reading)
+        return;
+    if (pending_find.book.empty ())
+        load_failed = load_failed || read == book_failed;
+    else if (read == book_installed && pending_find.book == journal.book_file)
+        show_found (pending_find.text);
+    else if (read == book_failed)
+    {
+        static log_limit_t limit (5);
+        log (log_warning, &limit) << "Unable to find mod requested string " << pending_find.text
+            << " in book " << pending_find.book << std::endl;
+    }
+    pending_find = {};
+}
+
+/// Every frame, shown or not, so the queue never fills up while the journal is hidden
+
+static void
+journal_command ()
+{
+    profile_scope_t profile (stage_command);
+
+    // Bounded, so a burst can't stall a frame, the rest waits in the queue for the next ones
+    constexpr std::size_t max_per_frame = 32;
+    static std::vector<command_t> batch;
+    take_commands (batch, max_per_frame);
+    for (auto& c: batch)
+    {
+        switch (c.type)
+        {
+            case command_find: find_command (c.text); break;
+            case command_batch: apply_batch (c.text); break;
+            case command_query: run_query (c); break;
+        }
+    }
+    static std::vector<std::shared_ptr<provider_t>> providers;
+    take_providers (providers);
+    for (auto& p: providers)
+        add_provider (std::move (p));
+
+    static std::uint64_t reported = 0;
+    auto dropped = command_stats ().dropped;
+    if (dropped != reported)
+    {
+        log (log_warning) << "Dropped " << dropped - reported
+                          << " mod commands, the queue was full." << std::endl;
+        reported = dropped;
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -238,18 +382,29 @@ journal_command ()
 void SSEIMGUI_CCONV
 render (int active)
 {
+    auto reset_arena = gsl::finally ([] { frame_arena.reset (); });
+    tick_travel (); // Shown or not
+    journal_books ();
+    journal_command ();
     if (!active)
         return;
 
+    profile_scope_t profile (stage_frame);
+    refresh_fonts (); // Before any of the journal fonts is pushed this frame
+    refresh_skin ();
+    sample_game_state (); // Once for all the variables shown this frame
+
     imgui.igSetNextWindowSize (ImVec2 { 800, 600 }, ImGuiCond_FirstUseEver);
+    begin_input_frame (); // May size the window too, hence after the default
+    auto input_end = gsl::finally ([] { end_input_frame (); });
     imgui.igPushFont (journal.default_font.imfont);
 
-    journal_command ();
-
+    book_window_requests ();
     if (imgui.igBegin ("SSE Journal", nullptr,
             !journal.show_titlebar * (ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoCollapse)
              | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoBackground))
     {
+        input_book_window ();
         extern void draw_book ();
         draw_book ();
     }
@@ -271,32 +426,73 @@ render (int active)
     extern void draw_load ();
     if (journal.show_load)
         draw_load ();
+    extern void draw_profiler ();
+    if (journal.show_profiler)
+        draw_profiler ();
+    extern void draw_nearby ();
+    if (journal.show_nearby)
+        draw_nearby ();
+    extern void draw_timeline ();
+    if (journal.show_timeline)
+        draw_timeline ();
 }
 
 //--------------------------------------------------------------------------------------------------
 
+/// Frames for a clicked expansion to hand the focus over to its template
+constexpr int page_text_focus = 3;
+
+/**
+ * A page text with placeholders shows their values, until clicked. Then its template is shown
+ * and focused instead, and stays so while edited. The two have distinct IDs, otherwise ImGui
+ * would go on editing its copy of the expansion.
+ *
+ * @param edit state per text: zero when shown as is, positive while focusing, negative if edited
+ * @returns the expansion to show read-only, or nullptr for the template
+ */
+
+static std::string const*
+begin_page_text (int& edit, std::string const& text)
+{
+    if (!edit)
+        return expanded_text (text);
+    if (edit > 0 && edit-- == page_text_focus)
+        imgui.igSetKeyboardFocusHere (0);
+    return nullptr;
+}
+
+static void
+end_page_text (int& edit, std::string const* view)
+{
+    if (imgui.igIsItemActive ())
+        edit = view ? page_text_focus : -1;
+    else if (edit < 0)
+        edit = 0;
+}
+
 void
 draw_book ()
 {
+    profile_scope_t profile (stage_book);
+    static bool save_failed = false;
+    popup_error (save_failed, "Saving book failed"); // Also on the replayed frames
+    popup_error (load_failed, "Load book failed");
+    save_failed = load_failed = false;
+    if (replay_book ())
+        return;
+    begin_book_capture ();
     imgui.igPushStyleColorU32 (ImGuiCol_FrameBg, 0);
     imgui.igPushStyleVarFloat (ImGuiStyleVar_FrameBorderSize, 0);
 
     auto wpos = button_t::wpos = imgui.igGetWindowPos ();
-    auto wsz  = button_t::wsz  = imgui.igGetWindowSize ();
+    auto wsz  = imgui.igGetWindowSize ();
+    layout_book (wsz);
+    auto const& layout = journal.layout;
+    auto const& bguv = journal.skin.background_uv;
 
     imgui.ImDrawList_AddImage (imgui.igGetWindowDrawList (), journal.background,
-            wpos, ImVec2 {wpos.x+wsz.x, wpos.y+wsz.y}, ImVec2 {0,0}, ImVec2 {1,.7226f},
-            IM_COL32_WHITE);
-
-    // Ratio, ratio multiplied by pixel size and the absolute positions summed with these
-    // are used all below. It may be pulled off as more capsulated and less dublication.
-    const float text_width    = .412f * wsz.x;
-    const float text_height   = .800f * wsz.y;
-
-    const float left_page  = .070f * wsz.x;
-    const float right_page = .528f * wsz.x;
-    const float title_top  = .090f * wsz.y;
-    const float text_top   = .159f * wsz.y;
+            wpos, ImVec2 {wpos.x+wsz.x, wpos.y+wsz.y}, ImVec2 {bguv[0],bguv[1]},
+            ImVec2 {bguv[2],bguv[3]}, IM_COL32_WHITE);
 
     // Port/larboard/ladebord
     // Starboard/steobord
@@ -312,10 +508,8 @@ draw_book ()
     if (journal.button_load.draw ())
         journal.show_load = !journal.show_load;
 
-    bool action_ok = true;
     if (journal.button_save.draw ())
-        action_ok = save_book (default_book);
-    popup_error (!action_ok, "Saving book failed");
+        save_failed = !save_book (default_book.c_str ());
 
     extern void previous_page ();
     if (journal.button_prev.draw ())
@@ -327,23 +521,33 @@ draw_book ()
     imgui.igPushFont (journal.chapter_font.imfont);
     imgui.igPushStyleColorU32 (ImGuiCol_Text, journal.chapter_font.color);
 
-    imgui.igSetNextItemWidth (text_width);
-    imgui.igSetCursorPos (ImVec2 { left_page, title_top });
-    imgui_input_text ("##Left title", journal.pages[journal.current_page].title);
-    if (imgui.igIsItemHovered (0) && !imgui.igIsItemActive ())
-        imgui.ImDrawList_AddRect (imgui.igGetWindowDrawList (),
-                ImVec2 { wpos.x+left_page, wpos.y+title_top },
-                ImVec2 { wpos.x+left_page+text_width, wpos.y+title_top+imgui.igGetFrameHeight () },
-                frame_col, 0, ImDrawCornerFlags_All, 2.f);
-
-    imgui.igSetCursorPos (ImVec2 { right_page, title_top });
-    imgui.igSetNextItemWidth (text_width);
-    imgui_input_text ("##Right title", journal.pages[journal.current_page+1].title);
-    if (imgui.igIsItemHovered (0) && !imgui.igIsItemActive ())
-        imgui.ImDrawList_AddRect (imgui.igGetWindowDrawList (),
-                ImVec2 { wpos.x+right_page, wpos.y+title_top },
-                ImVec2 { wpos.x+right_page+text_width, wpos.y+title_top+imgui.igGetFrameHeight () },
-                frame_col, 0, ImDrawCornerFlags_All, 2.f);
+    static const char* const title_ids[] = { "##Left title", "##Right title" };
+    static const char* const text_ids[] = { "##Left text", "##Right text" };
+    static const char* const title_views[] = { "##Left title view", "##Right title view" };
+    static const char* const text_views[] = { "##Left text view", "##Right text view" };
+    static int edits[4] = {}; // Titles, then texts
+
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        auto const& r = layout.titles[i];
+        auto& title = journal.pages[journal.current_page+i].title;
+        imgui.igSetCursorPos (r.pos);
+        imgui.igSetNextItemWidth (r.size.x);
+        begin_font_shader (journal.chapter_font);
+        auto view = begin_page_text (edits[i], title);
+        if (view)
+            imgui.igInputText (title_views[i], const_cast<char*> (view->c_str ()),
+                    view->size () + 1, ImGuiInputTextFlags_ReadOnly, nullptr, nullptr);
+        else
+            imgui_input_text (title_ids[i], title);
+        end_page_text (edits[i], view);
+        end_font_shader (journal.chapter_font);
+        if (imgui.igIsItemHovered (0) && !imgui.igIsItemActive ())
+            imgui.ImDrawList_AddRect (imgui.igGetWindowDrawList (),
+                    ImVec2 { wpos.x+r.pos.x, wpos.y+r.pos.y },
+                    ImVec2 { wpos.x+r.pos.x+r.size.x, wpos.y+r.pos.y+imgui.igGetFrameHeight () },
+                    frame_col, 0, ImDrawCornerFlags_All, 2.f);
+    }
 
     imgui.igPopFont ();
     imgui.igPopStyleColor (1);
@@ -355,67 +559,70 @@ draw_book ()
     imgui.igPushStyleColorU32 (ImGuiCol_ScrollbarGrabHovered, IM_COL32_BLACK_TRANS);
     imgui.igPushStyleColorU32 (ImGuiCol_ScrollbarGrabActive, IM_COL32_BLACK_TRANS);
 
-    auto& left_image = journal.pages[journal.current_page].image;
-    if (left_image.ref)
-    {
-        imgui.ImDrawList_AddImage (imgui.igGetWindowDrawList (), left_image.ref,
-            ImVec2 { wpos.x + left_page + text_width * left_image.xy[0],
-                     wpos.y + text_top + text_height * left_image.xy[1]},
-            ImVec2 { wpos.x + left_page + text_width * left_image.xy[2],
-                     wpos.y + text_top + text_height * left_image.xy[3] },
-            ImVec2 { left_image.uv[0], left_image.uv[1] },
-            ImVec2 { left_image.uv[2], left_image.uv[3] },
-            left_image.tint);
-    }
-    if (!left_image.ref || left_image.background)
-    {
-        imgui.igSetCursorPos (ImVec2 { left_page, text_top });
-        imgui_input_multiline ("##Left text",
-                journal.pages[journal.current_page].content, ImVec2 { text_width, text_height });
-        if (imgui.igIsItemHovered (0) && !imgui.igIsItemActive ())
-            imgui.ImDrawList_AddRect (imgui.igGetWindowDrawList (),
-                    ImVec2 { wpos.x+left_page, wpos.y+text_top },
-                    ImVec2 { wpos.x+left_page+text_width, wpos.y+text_top+text_height },
-                    frame_col, 0, ImDrawCornerFlags_All, 2.f);
-    }
-
-    auto& right_image = journal.pages[journal.current_page+1].image;
-    if (right_image.ref)
-    {
-        imgui.ImDrawList_AddImage (imgui.igGetWindowDrawList (), right_image.ref,
-            ImVec2 { wpos.x + right_page + text_width * right_image.xy[0],
-                     wpos.y + text_top + text_height * right_image.xy[1]},
-            ImVec2 { wpos.x + right_page + text_width * right_image.xy[2],
-                     wpos.y + text_top + text_height * right_image.xy[3] },
-            ImVec2 { right_image.uv[0], right_image.uv[1] },
-            ImVec2 { right_image.uv[2], right_image.uv[3] },
-            right_image.tint);
-    }
-    if (!right_image.ref || right_image.background)
+    for (unsigned i = 0; i < 2; ++i)
     {
-        imgui.igSetCursorPos (ImVec2 { right_page, text_top });
-        imgui_input_multiline ("##Right text",
-                journal.pages[journal.current_page+1].content, ImVec2 { text_width, text_height });
-        if (imgui.igIsItemHovered (0) && !imgui.igIsItemActive ())
-            imgui.ImDrawList_AddRect (imgui.igGetWindowDrawList (),
-                    ImVec2 { wpos.x+right_page, wpos.y+text_top },
-                    ImVec2 { wpos.x+right_page+text_width, wpos.y+text_top+text_height },
-                    frame_col, 0, ImDrawCornerFlags_All, 2.f);
+        auto const& r = layout.texts[i];
+        auto& page = journal.pages[journal.current_page+i];
+        auto& image = page.image;
+        if (image.ref)
+        {
+            imgui.ImDrawList_AddImage (imgui.igGetWindowDrawList (), image.ref,
+                ImVec2 { wpos.x + r.pos.x + r.size.x * image.xy[0],
+                         wpos.y + r.pos.y + r.size.y * image.xy[1]},
+                ImVec2 { wpos.x + r.pos.x + r.size.x * image.xy[2],
+                         wpos.y + r.pos.y + r.size.y * image.xy[3] },
+                ImVec2 { image.uv[0], image.uv[1] },
+                ImVec2 { image.uv[2], image.uv[3] },
+                image.tint);
+        }
+        if (!image.ref || image.background)
+        {
+            imgui.igSetCursorPos (r.pos);
+            auto& edit = edits[2+i];
+            auto view = begin_page_text (edit, page.content);
+            auto id = view ? text_views[i] : text_ids[i];
+            auto child = multiline_draw_list (id, r.size);
+            begin_font_shader (journal.text_font, child);
+            if (view)
+                imgui.igInputTextMultiline (text_views[i], const_cast<char*> (view->c_str ()),
+                        view->size () + 1, r.size, ImGuiInputTextFlags_ReadOnly, nullptr, nullptr);
+            else if (imgui_input_multiline (text_ids[i], page.content, r.size)
+                    && (!page.place.tagged || !page.written))
+                stamp_page (page); // Older or blank pages, when first written
+            end_page_text (edit, view);
+            end_font_shader (journal.text_font, child);
+            capture_book_child (child);
+            if (imgui.igIsItemHovered (0) && !imgui.igIsItemActive ())
+                imgui.ImDrawList_AddRect (imgui.igGetWindowDrawList (),
+                        ImVec2 { wpos.x+r.pos.x, wpos.y+r.pos.y },
+                        ImVec2 { wpos.x+r.pos.x+r.size.x, wpos.y+r.pos.y+r.size.y },
+                        frame_col, 0, ImDrawCornerFlags_All, 2.f);
+        }
     }
 
     imgui.igPopFont ();
     imgui.igPopStyleColor (5);
     imgui.igPopStyleVar (1);
     imgui.igPopStyleColor (1);
+    end_book_capture ();
 }
 
 //--------------------------------------------------------------------------------------------------
 
-static std::string greedy_word_wrap (std::string const& source, unsigned width);
+/// A new size needs a new atlas, so it is applied once the dragging ends
+
+static void
+drag_font_size (const char* label, font_t& font)
+{
+    imgui.igDragFloat (label, &font.size, .25f, 8.f, 96.f, "%.0f", 1);
+    if (imgui.igIsItemDeactivatedAfterEdit ())
+        add_font (font);
+}
 
 void
 draw_settings ()
 {
+    profile_scope_t profile (stage_settings);
     imgui.igPushFont (journal.default_font.imfont);
     if (imgui.igBegin ("SSE Journal: Settings", &journal.show_settings, 0))
     {
@@ -430,19 +637,23 @@ draw_settings ()
         if (imgui.igColorEdit4 ("Color##Buttons", (float*) &button_c, cflags))
             journal.button_font.color = imgui.igGetColorU32Vec4 (button_c);
         imgui.igSliderFloat ("Scale##Buttons", &journal.button_font.imfont->Scale,.5f,2.f,"%.2f",1);
+        drag_font_size ("Size##Buttons", journal.button_font);
 
         imgui.igText ("Titles font:");
         if (imgui.igColorEdit4 ("Color##Titles", (float*) &chapter_c, cflags))
             journal.chapter_font.color = imgui.igGetColorU32Vec4 (chapter_c);
         imgui.igSliderFloat ("Scale##Titles", &journal.chapter_font.imfont->Scale,.5f,2.f,"%.2f",1);
+        drag_font_size ("Size##Titles", journal.chapter_font);
 
         imgui.igText ("Text font:");
         if (imgui.igColorEdit4 ("Color##Text", (float*) &text_c, cflags))
             journal.text_font.color = imgui.igGetColorU32Vec4 (text_c);
         imgui.igSliderFloat ("Scale##Text", &journal.text_font.imfont->Scale, .5f, 2.f, "%.2f", 1);
+        drag_font_size ("Size##Text", journal.text_font);
 
         imgui.igText ("Default font:");
         imgui.igSliderFloat ("Scale", &journal.default_font.imfont->Scale, .5f, 2.f, "%.2f", 1);
+        drag_font_size ("Size", journal.default_font);
 
         static int wrap_width = 60;
         imgui.igDummy (ImVec2 { 1, imgui.igGetFrameHeight () });
@@ -456,6 +667,52 @@ draw_settings ()
 
         imgui.igDummy (ImVec2 { 1, imgui.igGetFrameHeight () });
         imgui.igCheckbox ("Show titlebar (allows show & hide)", &journal.show_titlebar);
+        if (imgui.igCheckbox ("Show profiler (records frame timings)", &journal.show_profiler))
+            profiler_enabled = journal.show_profiler;
+        bool trace_ok = true;
+        if (imgui.igCheckbox ("Trace loading and saving", &journal.trace))
+        {
+            trace_enabled = journal.trace;
+            if (!journal.trace)
+                trace_ok = save_trace (trace_location);
+        }
+        if (imgui.igIsItemHovered (0))
+            imgui.igSetTooltip ("Saved to %s once unchecked", trace_location.c_str ());
+        popup_error (!trace_ok, "Saving trace failed");
+        static const char* log_levels[] = { "Debug", "Info", "Warning", "Error" };
+        int log_level = log_threshold;
+        if (imgui.igCombo ("Log level", &log_level, log_levels, IM_ARRAYSIZE (log_levels), -1))
+            log_threshold = log_level;
+        imgui.igDummy (ImVec2 { 1, imgui.igGetFrameHeight () });
+
+        bool travel_ok = true;
+        imgui.igCheckbox ("Show pages written nearby", &journal.show_nearby);
+        imgui.igCheckbox ("Show timeline of the pages", &journal.show_timeline);
+        imgui.igDragFloat ("Nearby (units)", &journal.nearby_radius, 64, 512, 65536, "%.0f", 1);
+        journal.nearby_radius = nearby_radius_of (journal.nearby_radius); // Not on Ctrl+click
+        imgui.igDummy (ImVec2 { 1, imgui.igGetFrameHeight () });
+
+        imgui.igText ("Travel log:");
+        if (imgui.igCheckbox ("Record where and when", &journal.travel_log) && !journal.travel_log)
+            travel_ok = flush_travel ();
+        if (imgui.igIsItemHovered (0))
+            imgui.igSetTooltip ("Appended to %s in batches", travel_location.c_str ());
+        imgui.igDragFloat ("Cadence (seconds)", &journal.travel_cadence, .1f, 1.f, 60.f, "%.1f", 1);
+        if (imgui.igButton ("Append travel summary", ImVec2 {}))
+            append_input (journal.pages[journal.current_page].content, travel_summary ());
+        if (imgui.igIsItemHovered (0))
+            imgui.igSetTooltip ("The places arrived in this session, to the left page");
+        popup_error (!travel_ok, "Writing the travel log failed");
+        imgui.igDummy (ImVec2 { 1, imgui.igGetFrameHeight () });
+
+        bool skin_ok = true;
+        imgui.igText ("Skin:");
+        imgui_input_text ("File##Skin", journal.skin_file);
+        if (imgui.igButton ("Load skin", ImVec2 {}))
+            skin_ok = use_skin (journal.skin_file.c_str (), true);
+        if (imgui.igIsItemHovered (0))
+            imgui.igSetTooltip ("Applies the fonts given by the skin too");
+        popup_error (!skin_ok, "Loading skin failed");
         imgui.igDummy (ImVec2 { 1, imgui.igGetFrameHeight () });
 
         bool save_ok = true;
@@ -467,7 +724,7 @@ draw_settings ()
 
         bool load_ok = true;
         if (imgui.igButton ("Load settings", ImVec2 {}))
-            load_ok = load_settings ();
+            load_ok = load_settings () && use_skin (journal.skin_file.c_str (), false);
         popup_error (!load_ok, "Loading settings failed");
     }
     imgui.igEnd ();
@@ -514,6 +771,7 @@ draw_variables ()
         auto& v = journal.variables[varsel];
         v.params = params;
         output = v ();
+        note_glyphs (output);
     }
     imgui_input_text ("##Output", output);
     if (imgui.igListBoxFnPtr ("##Variables", &varsel, extract_variable_text,
@@ -526,6 +784,7 @@ draw_variables ()
             else params_flags |= ImGuiInputTextFlags_ReadOnly;
             params = v.params;
             output = v ();
+            note_glyphs (output);
         }
     }
 
@@ -567,7 +826,9 @@ draw_variables ()
     if (imgui.igButton ("Info", ImVec2 {-1, 0}))
         if (varsel >= 0)
         {
-            info_text = journal.variables[varsel].info;
+            auto const& v = journal.variables[varsel];
+            auto key = v.deletable || v.key.empty () ? placeholder_key (v.name) : v.key;
+            info_text = "In the pages as {" + key + "} or {" + key + ":parameters}\n\n" + v.info;
             info_size = imgui.igCalcTextSize (info_text.c_str (), nullptr, false, -1.f);
             imgui.igOpenPopup (info_popup);
         }
@@ -609,52 +870,44 @@ draw_variables ()
 
 //--------------------------------------------------------------------------------------------------
 
-template<class T>
 bool
-enumerate_files (T wildcard, std::vector<std::string>& out)
+extract_vector_string (void* data, int idx, const char** out_text)
 {
-    std::wstring w;
-    if (!utf8_to_utf16 (wildcard, w))
-        return false;
-    out.clear ();
-    WIN32_FIND_DATA fd;
-    auto h = ::FindFirstFile (w.c_str (), &fd);
-    if (h == INVALID_HANDLE_VALUE)
-        return false;
-    do
-    {
-        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-            continue;
-        std::string s;
-        if (!utf16_to_utf8 (fd.cFileName, s))
-            break;
-        out.emplace_back (std::move (s));
-    }
-    while (::FindNextFile (h, &fd));
-    auto e = ::GetLastError ();
-    ::FindClose (h);
-    return e == ERROR_NO_MORE_FILES;
+    auto vars = reinterpret_cast<std::vector<std::string> const*> (data);
+    *out_text = vars->at (idx).c_str ();
+    return true;
 }
 
-void
-enumerate_filenames (std::string const& wildcard, std::vector<std::string>& out)
-{
-    enumerate_files (wildcard.c_str (), out);
-    for (auto& name: out)
-        name.erase (name.find_last_of ('.'));
-}
+/// Opens on first use, then keeps the selection on the same name as the watched list changes
 
-bool
-extract_vector_string (void* data, int idx, const char** out_text)
+static void
+update_watch (directory_watch_t& watch, std::string const& directory, const char* extension,
+        int& selection, std::string const& selected)
 {
-    auto vars = reinterpret_cast<std::vector<std::string>*> (data);
-    *out_text = vars->at (idx).c_str ();
-    return true;
+    static alloc_site_t site ("update_watch");
+    alloc_scope_t allocs (site);
+    if (!watch.is_open ())
+    {
+        watch.open (directory, extension);
+        for (auto const& n: watch.names ())
+            note_glyphs (n);
+    }
+    if (!watch.poll ())
+        return;
+    for (auto const& e: watch.events ())
+        note_glyphs (e.name);
+
+    auto const& names = watch.names ();
+    auto it = std::lower_bound (names.cbegin (), names.cend (), selected);
+    if (it != names.cend () && *it == selected)
+        selection = int (std::distance (names.cbegin (), it));
+    else
+        selection = -1;
 }
 
 //--------------------------------------------------------------------------------------------------
 
-static void
+void
 release_image (image_t& img)
 {
     auto it = journal.images.find (img.ref);
@@ -671,17 +924,20 @@ release_image (image_t& img)
 //--------------------------------------------------------------------------------------------------
 
 bool
-obtain_image (std::string const& file, image_t& img)
+obtain_image (const char* file, image_t& img)
 {
+    trace_span_t span ("obtain_image", file);
+    static alloc_site_t site ("obtain_image");
+    alloc_scope_t allocs (site);
     auto it = std::find_if (journal.images.begin (), journal.images.end (),
             [&file] (auto const& kv) { return kv.second.file == file; });
 
     if (it == journal.images.end ())
     {
         ID3D11ShaderResourceView* ref = nullptr;
-        if (!sseimgui.ddsfile_texture (file.c_str (), nullptr, &ref))
+        if (!sseimgui.ddsfile_texture (file, nullptr, &ref))
             return false;
-        it = journal.images.emplace (ref, journal_t::image_source_t { 1, std::move (file) }).first;
+        it = journal.images.emplace (ref, journal_t::image_source_t { 1, file }).first;
     }
     else if (img.ref == it->first)
     {
@@ -720,9 +976,8 @@ imgui_range_widget (const char* label, float& l, float& r)
 static void
 draw_images ()
 {
-    static std::vector<std::string> names = [] {
-        std::vector<std::string> n; enumerate_filenames (images_directory + "*.dds", n); return n;
-    } ();
+    static directory_watch_t watch;
+    static std::string selected;
     static int namesel = -1;
     static float items = 7.25f;
     static ImVec4 left_tint, right_tint;
@@ -731,6 +986,9 @@ draw_images ()
         | ImGuiColorEditFlags_DisplayHSV | ImGuiColorEditFlags_InputRGB
         | ImGuiColorEditFlags_PickerHueBar;
 
+    update_watch (watch, images_directory, ".dds", namesel, selected);
+    auto const& names = watch.names ();
+
     auto& left_image = journal.pages[journal.current_page].image;
     auto& right_image = journal.pages[journal.current_page+1].image;
 
@@ -738,15 +996,17 @@ draw_images ()
     float sidew = width *.3f;
 
     imgui.igSetNextItemWidth (width * .40f);
-    imgui.igListBoxFnPtr ("##Image files", &namesel, extract_vector_string,
-            &names, static_cast<int> (names.size ()), items);
+    if (imgui.igListBoxFnPtr ("##Image files", &namesel, extract_vector_string,
+            (void*) &names, static_cast<int> (names.size ()), items) && namesel >= 0)
+        selected = names[namesel];
     imgui.igSameLine (0, -1);
     imgui.igPushItemWidth (sidew);
     imgui.igBeginGroup ();
 
     imgui.igBeginGroup ();
     if (imgui.igButton ("Show##left", ImVec2 {sidew, 0}) && namesel >= 0)
-        if (!obtain_image (images_directory + names[namesel] + ".dds"s, left_image))
+        if (!obtain_image (frame_path (images_directory, names[namesel], ".dds").c_str (),
+                    left_image))
             namesel = -1;
     if (imgui.igButton ("Hide##left", ImVec2 {sidew, 0}))
         release_image (left_image);
@@ -766,7 +1026,8 @@ draw_images ()
 
     imgui.igBeginGroup ();
     if (imgui.igButton ("Show##right", ImVec2 {sidew, 0}) && namesel >= 0)
-        if (!obtain_image (images_directory + names[namesel] + ".dds"s, right_image))
+        if (!obtain_image (frame_path (images_directory, names[namesel], ".dds").c_str (),
+                    right_image))
             namesel = -1;
     if (imgui.igButton ("Hide##right", ImVec2 {sidew, 0}))
         release_image (right_image);
@@ -792,6 +1053,7 @@ draw_images ()
 void
 draw_elements ()
 {
+    profile_scope_t profile (stage_elements);
     imgui.igPushFont (journal.default_font.imfont);
     if (imgui.igBegin ("SSE Journal: Elements", &journal.show_elements, 0))
         if (imgui.igBeginTabBar ("##Elements", 0))
@@ -839,6 +1101,7 @@ extract_chapter_title (void* data, int idx, const char** out_text)
 void
 draw_chapters ()
 {
+    profile_scope_t profile (stage_chapters);
     static float items = 7.25f;
     static int selection = -1;
 
@@ -862,13 +1125,13 @@ draw_chapters ()
         {
             if (selection >= 0 && selection < int (journal.pages.size ()))
                 adjust = true,
-                journal.pages.insert (journal.pages.begin () + selection, page_t {});
+                stamp_page (*journal.pages.insert (journal.pages.begin () + selection, page_t {}));
         }
         if (imgui.igButton ("Insert after", ImVec2 {-1, 0}))
         {
             if (selection >= 0 && selection < int (journal.pages.size ()))
-                adjust = true,
-                journal.pages.insert (journal.pages.begin () + selection + 1, page_t {});
+                adjust = true, stamp_page (
+                    *journal.pages.insert (journal.pages.begin () + selection + 1, page_t {}));
         }
         if (imgui.igButton ("Delete", ImVec2 {-1, 0}))
             if (selection >= 0 && selection < int (journal.pages.size ()))
@@ -887,6 +1150,8 @@ draw_chapters ()
 
         if (adjust)
         {
+            invalidate_places ();
+            invalidate_chronology ();
             if (journal.pages.size () < 2)
                 journal.pages.resize (2);
             while (journal.current_page+2 > journal.pages.size ())
@@ -904,6 +1169,7 @@ draw_chapters ()
 void
 draw_saveas ()
 {
+    profile_scope_t profile (stage_saveas);
     static std::string name;
     static int typesel = 0;
     static std::array<const char*, 2> types = { "Journal book (*.json)", "Plain text (*.txt)" };
@@ -920,9 +1186,8 @@ draw_saveas ()
         if (imgui.igButton ("Save", ImVec2 {}))
         {
             bool ok = true;
-            auto root = books_directory + name.c_str ();
-            if (typesel == 0) ok = save_book (root + ".json");
-            if (typesel == 1) ok = save_text (root + ".txt");
+            if (typesel == 0) ok = save_book (frame_path (books_directory, name, ".json").c_str ());
+            if (typesel == 1) ok = save_text (frame_path (books_directory, name, ".txt").c_str ());
             popup_error (!ok, "Save As failed");
             if (ok) journal.show_saveas = false;
         }
@@ -936,19 +1201,18 @@ draw_saveas ()
 void
 draw_load ()
 {
+    profile_scope_t profile (stage_load);
     static int typesel = 0;
     static int namesel = -1;
     static std::array<const char*, 2> types = { "Journal book (*.json)", "Take Notes (*.xml)" };
-    static std::array<const char*, 2> filters = { "*.json", "*.xml" };
-    static std::vector<std::string> names;
-    static bool reload_names = false;
+    static std::array<const char*, 2> filters = { ".json", ".xml" };
+    static std::array<directory_watch_t, 2> watches;
+    static std::string selected;
     static float items = -1;
 
-    if (journal.show_load != reload_names)
-    {
-        reload_names = journal.show_load;
-        enumerate_filenames (books_directory + filters[typesel], names);
-    }
+    auto& watch = watches[typesel];
+    update_watch (watch, books_directory, filters[typesel], namesel, selected);
+    auto const& names = watch.names ();
 
     imgui.igPushFont (journal.default_font.imfont);
     if (imgui.igBegin ("SSE Journal: Load", &journal.show_load, 0))
@@ -956,18 +1220,23 @@ draw_load ()
         imgui.igText (books_directory.c_str ());
         imgui.igBeginGroup ();
         if (imgui.igCombo ("##Type", &typesel, types.data (), int (types.size ()), -1))
-            enumerate_filenames (books_directory + filters[typesel], names);
-        imgui.igListBoxFnPtr ("##Names",
-                &namesel, extract_vector_string, &names, int (names.size ()), items);
+            namesel = -1; // Next frame picks the other list
+        if (imgui.igListBoxFnPtr ("##Names", &namesel, extract_vector_string,
+                    (void*) &names, int (names.size ()), items) && namesel >= 0)
+            selected = names[namesel];
         imgui.igEndGroup ();
         imgui.igSameLine (0, -1);
         imgui.igBeginGroup ();
         if (imgui.igButton ("Load", ImVec2 {-1, 0}) && unsigned (namesel) < names.size ())
         {
             bool ok = true;
-            auto target = books_directory + names[namesel];
-            if (typesel == 0) ok = load_book (target + ".json");
-            if (typesel == 1) ok = load_takenotes (target + ".xml");
+            auto target = frame_path (books_directory, names[namesel], filters[typesel]);
+            // Unless cached, the book shows up in a few frames, a failure pops up over it
+            if (typesel == 0 && journal.book_file == target.c_str ())
+                reload_book (journal.book_file);
+            else if (typesel == 0)
+                open_book (target.c_str ());
+            if (typesel == 1) ok = load_takenotes (target.c_str ());
             popup_error (!ok, "Load book failed");
             if (ok) journal.show_load = false;
         }
@@ -982,6 +1251,205 @@ draw_load ()
 
 //--------------------------------------------------------------------------------------------------
 
+void
+draw_profiler ()
+{
+    imgui.igPushFont (journal.default_font.imfont);
+    if (imgui.igBegin ("SSE Journal: Profiler", &journal.show_profiler,
+                ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        imgui.igCheckbox ("Record", &profiler_enabled);
+        imgui.igSameLine (0, -1);
+        bool tracking = alloc_tracking;
+        if (imgui.igCheckbox ("Count allocations", &tracking))
+            alloc_tracking = tracking;
+        imgui.igSameLine (0, -1);
+        imgui.igCheckbox ("Retain idle book", &retained_book);
+        auto const& sum = profile_summary ();
+
+        imgui.igColumns (5, nullptr, false);
+        imgui.igText ("Stage"); imgui.igNextColumn ();
+        imgui.igText ("Avg ms"); imgui.igNextColumn ();
+        imgui.igText ("P99 ms"); imgui.igNextColumn ();
+        imgui.igText ("Allocs"); imgui.igNextColumn ();
+        imgui.igText ("Bytes"); imgui.igNextColumn ();
+        for (int st = 0; st < stage_count; ++st)
+        {
+            imgui.igTextUnformatted (profile_stage_names[st], nullptr); imgui.igNextColumn ();
+            imgui.igText ("%.3f", sum.avg_ms[st]); imgui.igNextColumn ();
+            imgui.igText ("%.3f", sum.p99_ms[st]); imgui.igNextColumn ();
+            imgui.igText ("%.1f", sum.avg_allocs[st]); imgui.igNextColumn ();
+            imgui.igText ("%.0f", sum.avg_alloc_bytes[st]); imgui.igNextColumn ();
+        }
+        imgui.igColumns (1, nullptr, false);
+
+        imgui.igPlotLines ("##Frame", sum.frame_ms.data (), int (sum.frame_ms.size ()), 0,
+                "Frame time", 0, sum.p99_ms[stage_frame] * 1.5f, ImVec2 { 0, 80 }, sizeof (float));
+
+        bool export_ok = true;
+        if (imgui.igButton ("Export CSV", ImVec2 {}))
+            export_ok = export_profile (profile_location);
+        if (imgui.igIsItemHovered (0))
+            imgui.igSetTooltip ("%s", profile_location.c_str ());
+        popup_error (!export_ok, "Exporting profile failed");
+
+        auto is = input_status ();
+        bool input_ok = true;
+        if (is.mode == input_idle)
+        {
+            if (imgui.igButton ("Record input", ImVec2 {}))
+                input_ok = start_input_recording ();
+            imgui.igSameLine (0, -1);
+            if (imgui.igButton ("Replay input", ImVec2 {}))
+                input_ok = start_input_replay ();
+            if (imgui.igIsItemHovered (0))
+                imgui.igSetTooltip ("%s\nTimings into %s", input_location.c_str (),
+                        input_timings_location.c_str ());
+        }
+        else
+        {
+            if (imgui.igButton (is.mode == input_recording ? "Stop recording" : "Stop replay",
+                        ImVec2 {}))
+                input_ok = stop_input ();
+            imgui.igSameLine (0, -1);
+            imgui.igText ("Frame %u of %u", unsigned (is.frame), unsigned (is.frames));
+        }
+        popup_error (!input_ok, "Input record failed");
+
+        auto cs = command_stats ();
+        imgui.igText ("Mod commands: %llu posted, %llu dropped, %llu waiting",
+                (unsigned long long) cs.posted, (unsigned long long) cs.dropped,
+                (unsigned long long) (cs.posted - cs.taken));
+
+        auto bs = book_cache_stats ();
+        imgui.igText ("Books cache: %u books, %.0f of %.0f KiB", unsigned (bs.books),
+                bs.bytes / 1024.f, book_cache_limit / 1024.f);
+
+        if (alloc_tracking)
+        {
+            static std::vector<alloc_site_t const*> sites;
+            top_alloc_sites (sites);
+            auto frames = float (std::max<std::uint64_t> (alloc_tracked_frames, 1));
+            imgui.igText ("Top allocation sites, per frame:");
+            for (std::size_t i = 0; i < sites.size () && i < 10; ++i)
+                imgui.igText ("%8.1f %10.0f  %s", sites[i]->count / frames,
+                        sites[i]->bytes / frames, sites[i]->name);
+
+            bool dump_ok = true;
+            if (imgui.igButton ("Dump allocations", ImVec2 {}))
+                dump_ok = dump_allocations (allocations_location);
+            if (imgui.igIsItemHovered (0))
+                imgui.igSetTooltip ("%s", allocations_location.c_str ());
+            popup_error (!dump_ok, "Dumping allocations failed");
+            imgui.igSameLine (0, -1);
+            if (imgui.igButton ("Reset", ImVec2 {}))
+                reset_alloc_sites ();
+        }
+    }
+    imgui.igEnd ();
+    imgui.igPopFont ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Queried every frame, as the player moves, but only a few grid squares get looked at
+void
+draw_nearby ()
+{
+    profile_scope_t profile (stage_nearby);
+    static std::vector<place_hit_t> hits;
+    pages_near_player (journal.nearby_radius, hits);
+
+    imgui.igPushFont (journal.default_font.imfont);
+    if (imgui.igBegin ("SSE Journal: Nearby", &journal.show_nearby, 0))
+    {
+        if (hits.empty ())
+            imgui.igTextUnformatted ("No pages written near here", nullptr);
+        for (auto const& h: hits)
+        {
+            auto const& p = journal.pages[h.page];
+            imgui.igPushIDInt (int (h.page));
+            if (imgui.igButton ("Open", ImVec2 {}))
+                journal.current_page = std::min (h.page, unsigned (journal.pages.size ()) - 2);
+            imgui.igPopID ();
+            imgui.igSameLine (0, -1);
+            imgui.igText ("%.0f  %s", h.distance,
+                    p.title.c_str ()[0] ? p.title.c_str () : p.place.cell.c_str ());
+        }
+    }
+    imgui.igEnd ();
+    imgui.igPopFont ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Only the rows in view get formatted and drawn, tens of thousands of pages or not
+void
+draw_timeline ()
+{
+    profile_scope_t profile (stage_timeline);
+    static bool all_years = true;
+    static int year = 201, month = 0;
+    static std::array<const char*, 13> months = {};
+    if (!months[0])
+    {
+        months[0] = "Whole year";
+        for (int m = 0; m < 12; ++m)
+            months[m+1] = game_month_name (m);
+    }
+
+    imgui.igPushFont (journal.default_font.imfont);
+    if (imgui.igBegin ("SSE Journal: Timeline", &journal.show_timeline, 0))
+    {
+        imgui.igCheckbox ("All years", &all_years);
+        if (!all_years)
+        {
+            imgui.igSameLine (0, -1);
+            imgui.igPushItemWidth (imgui.igGetFontSize () * 6);
+            imgui.igInputInt ("Year##Timeline", &year, 1, 10, 0);
+            imgui.igSameLine (0, -1);
+            imgui.igCombo ("##Month", &month, months.data (), int (months.size ()), -1);
+            imgui.igPopItemWidth ();
+        }
+
+        auto range = std::make_pair (std::size_t (0), chronology ().size ());
+        if (!all_years)
+        {
+            float from, to, unused;
+            game_month_range (year, month ? month-1 : 0, from, to);
+            if (!month)
+                game_month_range (year, 11, unused, to);
+            range = chronology_range (from, to);
+        }
+        auto const& entries = chronology ();
+        imgui.igText ("%zu pages", range.second - range.first);
+
+        if (imgui.igBeginChild ("##Timeline", ImVec2 {}, false, 0))
+        {
+            ImGuiListClipper clipper = {};
+            imgui.ImGuiListClipper_Begin (&clipper, int (range.second - range.first),
+                    imgui.igGetTextLineHeightWithSpacing ());
+            char label[256];
+            while (imgui.ImGuiListClipper_Step (&clipper))
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+                {
+                    auto const& e = entries[range.first + i];
+                    auto date = game_date (e.time, "%Y %lm %md, %h:%m");
+                    std::snprintf (label, sizeof (label), "%.*s  %s##%u", int (date.size ()),
+                            date.data (), journal.pages[e.page].title.c_str (), e.page);
+                    if (imgui.igSelectable (label, e.page == journal.current_page, 0, ImVec2 {}))
+                        journal.current_page = std::min (e.page,
+                                unsigned (journal.pages.size ()) - 2);
+                }
+        }
+        imgui.igEndChild ();
+    }
+    imgui.igEnd ();
+    imgui.igPopFont ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void
 previous_page ()
 {
@@ -1007,6 +1475,7 @@ next_page ()
                 || visible_symbols (journal.pages.back ().content))
         {
             journal.pages.push_back (page_t {});
+            stamp_page (journal.pages.back ());
             journal.current_page++;
         }
     }
@@ -1014,7 +1483,7 @@ next_page ()
 
 //--------------------------------------------------------------------------------------------------
 
-static std::string
+std::string
 greedy_word_wrap (std::string const& source, unsigned width)
 {
     auto n = std::strlen (source.c_str ());
@@ -0,0 +1,252 @@
+/**
+ * @file retained.cpp
+ * @brief Replays the cached geometry of the open book while nothing about it changes
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * A spread drawn in a frame without any input is recorded: the commands, vertices and indices it
+ * added to the book window, followed by the whole lists of the two multiline child windows. While
+ * the next frames are as quiet and the key (window, page, text buffers, fonts) is the same, the
+ * widgets are not submitted at all and the record is appended back into the book window list.
+ * The key covers the expanded placeholders of the shown texts as well, see placeholders.cpp.
+ * The children are flattened into the parent, their clip rectangles travel with their commands.
+ *
+ * Only a quiet frame records, so whatever input changed (even after draw_book() in the same
+ * frame, e.g. loading a book) is seen by one more full frame before any replay.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+//--------------------------------------------------------------------------------------------------
+
+bool retained_book = true;
+
+/// What must stay the same for the recorded spread to be valid
+struct book_key_t
+{
+    ImVec2 wpos, wsz;
+    unsigned page;
+    std::array<const char*, 4> text;
+    std::array<std::size_t, 4> size;
+    std::array<ID3D11ShaderResourceView*, 3> views;
+    std::array<ImFont*, 3> fonts;
+    std::array<std::uint32_t, 3> colors;
+    std::uint64_t placeholders;     ///< Their values change while idle too
+
+    bool operator== (book_key_t const& o) const
+    {
+        return wpos.x == o.wpos.x && wpos.y == o.wpos.y && wsz.x == o.wsz.x && wsz.y == o.wsz.y
+            && page == o.page && text == o.text && size == o.size && views == o.views
+            && fonts == o.fonts && colors == o.colors && placeholders == o.placeholders;
+    }
+};
+
+/// Indices are relative to the first vertex of the command
+struct retained_cmd_t
+{
+    ImVec4 clip;
+    ImTextureID texture;
+    ImDrawCallback callback;
+    void* callback_data;
+    unsigned idx_count, vtx_count;
+};
+
+static struct
+{
+    bool valid, capturing;
+    book_key_t key;
+    ImDrawList* list;
+    int idx_start;
+    ImGuiMouseCursor cursor;
+    std::vector<retained_cmd_t> cmds;
+    std::vector<ImDrawVert> vtx;
+    std::vector<ImDrawIdx> idx;
+    std::vector<ImDrawList const*> children;
+}
+book = {};
+
+//--------------------------------------------------------------------------------------------------
+
+void
+invalidate_retained_book ()
+{
+    book.valid = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static book_key_t
+make_key ()
+{
+    auto const& l = journal.pages[journal.current_page];
+    auto const& r = journal.pages[journal.current_page+1];
+    for (auto t: { &l.title, &r.title, &l.content, &r.content })
+        expanded_text (*t); // Refreshed, as the widgets would
+    return book_key_t {
+        imgui.igGetWindowPos (), imgui.igGetWindowSize (), journal.current_page,
+        {{ l.title.data (), r.title.data (), l.content.data (), r.content.data () }},
+        {{ l.title.size (), r.title.size (), l.content.size (), r.content.size () }},
+        {{ journal.background, l.image.ref, r.image.ref }},
+        {{ journal.button_font.imfont, journal.chapter_font.imfont, journal.text_font.imfont }},
+        {{ journal.button_font.color, journal.chapter_font.color, journal.text_font.color }},
+        placeholders_generation ()
+    };
+}
+
+/// Nothing which could change what the widgets draw, or what they do
+static bool
+quiet_input ()
+{
+    auto io = imgui.igGetIO ();
+    if (io->MouseDelta.x || io->MouseDelta.y || io->MouseWheel || io->MouseWheelH
+            || io->InputQueueCharacters.Size)
+        return false;
+    for (int i = 0; i < 5; ++i)
+        if (io->MouseDown[i] || io->MouseReleased[i])
+            return false;
+    for (auto down: io->KeysDown)
+        if (down)
+            return false;
+    for (auto nav: io->NavInputs)
+        if (nav > 0)
+            return false;
+    return !imgui.igIsAnyItemActive ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Appends what @param dl got past the given index offset
+
+static void
+record_list (ImDrawList const* dl, int idx_start)
+{
+    unsigned offset = 0;
+    for (int i = 0; i < dl->CmdBuffer.Size; ++i)
+    {
+        auto const& c = dl->CmdBuffer.Data[i];
+        unsigned begin = std::max<unsigned> (offset, idx_start), end = offset + c.ElemCount;
+        offset = end;
+        if (c.UserCallback)
+        {
+            if (offset >= unsigned (idx_start))
+                book.cmds.push_back (retained_cmd_t {
+                        c.ClipRect, c.TextureId, c.UserCallback, c.UserCallbackData, 0, 0 });
+            continue;
+        }
+        if (begin >= end)
+            continue;
+
+        auto first = dl->IdxBuffer.Data + begin, last = dl->IdxBuffer.Data + end;
+        unsigned lo = *std::min_element (first, last), hi = *std::max_element (first, last);
+        for (auto p = first; p != last; ++p)
+            book.idx.push_back (ImDrawIdx (*p - lo));
+        book.vtx.insert (book.vtx.end (), dl->VtxBuffer.Data + lo, dl->VtxBuffer.Data + hi + 1);
+        book.cmds.push_back (retained_cmd_t {
+                c.ClipRect, c.TextureId, nullptr, nullptr, end - begin, hi - lo + 1 });
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+replay_book ()
+{
+    if (!retained_book || !book.valid || !quiet_input () || !(make_key () == book.key))
+        return false;
+
+    auto dl = imgui.igGetWindowDrawList ();
+    if (dl->_VtxCurrentIdx + book.vtx.size () > (1u << 8*sizeof (ImDrawIdx)))
+        return false;
+
+    auto vtx = book.vtx.data ();
+    auto idx = book.idx.data ();
+    for (auto const& c: book.cmds)
+    {
+        if (c.callback)
+        {
+            imgui.ImDrawList_AddCallback (dl, c.callback, c.callback_data);
+            continue;
+        }
+        imgui.ImDrawList_PushClipRect (dl,
+                ImVec2 { c.clip.x, c.clip.y }, ImVec2 { c.clip.z, c.clip.w }, false);
+        imgui.ImDrawList_PushTextureID (dl, c.texture);
+        imgui.ImDrawList_PrimReserve (dl, int (c.idx_count), int (c.vtx_count));
+        std::memcpy (dl->_VtxWritePtr, vtx, c.vtx_count * sizeof (ImDrawVert));
+        for (unsigned i = 0; i < c.idx_count; ++i)
+            dl->_IdxWritePtr[i] = ImDrawIdx (dl->_VtxCurrentIdx + idx[i]);
+        dl->_VtxWritePtr += c.vtx_count;
+        dl->_IdxWritePtr += c.idx_count;
+        dl->_VtxCurrentIdx += c.vtx_count;
+        vtx += c.vtx_count;
+        idx += c.idx_count;
+        imgui.ImDrawList_PopTextureID (dl);
+        imgui.ImDrawList_PopClipRect (dl);
+    }
+    imgui.igSetMouseCursor (book.cursor);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+begin_book_capture ()
+{
+    book.valid = false;
+    book.capturing = retained_book && quiet_input ();
+    if (!book.capturing)
+        return;
+    book.key = make_key ();
+    book.list = imgui.igGetWindowDrawList ();
+    book.idx_start = book.list->IdxBuffer.Size;
+    book.cmds.clear ();
+    book.vtx.clear ();
+    book.idx.clear ();
+    book.children.clear ();
+}
+
+void
+capture_book_child (ImDrawList const* dl)
+{
+    if (book.capturing)
+        book.children.push_back (dl);
+}
+
+/// The parent goes first, the children follow, as in the order ImGui renders them
+
+void
+end_book_capture ()
+{
+    if (!book.capturing)
+        return;
+    book.capturing = false;
+    record_list (book.list, book.idx_start);
+    for (auto dl: book.children)
+        record_list (dl, 0);
+    book.cursor = imgui.igGetMouseCursor ();
+    book.valid = book.vtx.size () < (1u << 8*sizeof (ImDrawIdx));
+}
+
+//--------------------------------------------------------------------------------------------------
+
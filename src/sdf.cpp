@@ -0,0 +1,144 @@
+/**
+ * @file sdf.cpp
+ * @brief CPU side signed distance field generation for the font atlas
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * Distances are found with the 8-points signed sequential Euclidean distance transform (8SSEDT)
+ * over the thresholded coverage, while the anti-aliased edge pixels keep their sub-pixel estimate
+ * from the coverage itself. Nothing here touches ImGui or D3D, it works on plain Alpha8 buffers.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+struct offset_t
+{
+    int dx, dy;
+    inline int dist2 () const { return dx*dx + dy*dy; }
+};
+
+constexpr offset_t far_away = { 9999, 9999 };
+
+/// Each cell ends up with the offset to the nearest seed cell
+class edt_grid_t
+{
+    int w, h;
+    std::vector<offset_t> cells;
+
+    inline offset_t& at (int x, int y) { return cells[std::size_t (y) * w + x]; }
+
+    inline void compare (offset_t& p, int x, int y, int ox, int oy)
+    {
+        if (x+ox < 0 || y+oy < 0 || x+ox >= w || y+oy >= h)
+            return;
+        offset_t o = at (x+ox, y+oy);
+        o.dx += ox, o.dy += oy;
+        if (o.dist2 () < p.dist2 ())
+            p = o;
+    }
+
+public:
+    template<class Seed>
+    edt_grid_t (int w, int h, Seed&& seed) : w (w), h (h), cells (std::size_t (w) * h)
+    {
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                at (x, y) = seed (x, y) ? offset_t {0, 0} : far_away;
+    }
+
+    void transform ()
+    {
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                auto& p = at (x, y);
+                compare (p, x, y, -1,  0);
+                compare (p, x, y,  0, -1);
+                compare (p, x, y, -1, -1);
+                compare (p, x, y,  1, -1);
+            }
+            for (int x = w-1; x >= 0; --x)
+                compare (at (x, y), x, y, 1, 0);
+        }
+        for (int y = h-1; y >= 0; --y)
+        {
+            for (int x = w-1; x >= 0; --x)
+            {
+                auto& p = at (x, y);
+                compare (p, x, y,  1,  0);
+                compare (p, x, y,  0,  1);
+                compare (p, x, y, -1,  1);
+                compare (p, x, y,  1,  1);
+            }
+            for (int x = 0; x < w; ++x)
+                compare (at (x, y), x, y, -1, 0);
+        }
+    }
+
+    inline float distance (int x, int y) { return std::sqrt (float (at (x, y).dist2 ())); }
+};
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+
+void
+make_sdf (unsigned char const* src, unsigned char* dst, int stride,
+        int x, int y, int width, int height, int spread)
+{
+    if (width <= 0 || height <= 0 || spread <= 0)
+        return;
+
+    auto coverage = [=] (int cx, int cy) { return src[std::size_t (y+cy) * stride + x+cx]; };
+    edt_grid_t to_inside  (width, height, [&] (int cx, int cy) { return coverage (cx, cy) >= 128; });
+    edt_grid_t to_outside (width, height, [&] (int cx, int cy) { return coverage (cx, cy) <  128; });
+    to_inside.transform ();
+    to_outside.transform ();
+
+    const float unit = 127.f / spread;
+    for (int cy = 0; cy < height; ++cy)
+        for (int cx = 0; cx < width; ++cx)
+        {
+            int c = coverage (cx, cy);
+            float d; // Positive inside, in pixels
+            if (c > 0 && c < 255)
+                d = c / 255.f - .5f;
+            else if (c >= 128)
+                d = to_outside.distance (cx, cy) - .5f;
+            else
+                d = .5f - to_inside.distance (cx, cy);
+            dst[std::size_t (y+cy) * stride + x+cx] =
+                static_cast<unsigned char> (std::min (255.f, std::max (0.f, 128.f + d * unit)));
+        }
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,187 @@
+/**
+ * @file skin.cpp
+ * @brief Book art and the layout resolved from it
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * A skin gives everything as fractions of the book window, so any background art fits any
+ * window size. These are turned into pixels only when the window size, the skin or the buttons
+ * font changes, the frames in between just use the result (incl. the measured button labels).
+ *
+ * A new skin is swapped in between frames, like the fonts, since the current frame may still
+ * draw with the old background texture.
+ */
+
+#include "sse-journal.hpp"
+
+//--------------------------------------------------------------------------------------------------
+
+auto constexpr lite_tint = IM_COL32 (191, 157, 111,  64);
+auto constexpr dark_tint = IM_COL32 (191, 157, 111,  96);
+
+/// In the order of skin_t::buttons
+static button_t journal_t::* const skin_buttons[] = {
+    &journal_t::button_prev, &journal_t::button_next,
+    &journal_t::button_settings, &journal_t::button_elements, &journal_t::button_chapters,
+    &journal_t::button_save, &journal_t::button_saveas, &journal_t::button_load
+};
+
+static struct
+{
+    bool ready, fonts;
+    skin_t skin;
+    ID3D11ShaderResourceView* view;
+}
+pending = {};
+
+/// Bumped on anything which needs #layout_book() to resolve again
+static unsigned generation = 1;
+
+//--------------------------------------------------------------------------------------------------
+
+skin_t
+default_skin ()
+{
+    skin_t s;
+    s.background_file = journal.background_file.empty ()
+        ? journal_directory + "book.dds" : journal.background_file;
+    s.background_uv = {{ 0, 0, 1, .7226f }}; // The Background Y pixels reach ~72% of a 2k texture
+    s.titles = {{ {{ .070f, .090f, .412f, 0 }}, {{ .528f, .090f, .412f, 0 }} }};
+    s.texts  = {{ {{ .070f, .159f, .412f, .800f }}, {{ .528f, .159f, .412f, .800f }} }};
+    s.buttons = {{
+        { "prev"    , "Prev"    , {{   0.f, 0, .050f,   1.f }}, lite_tint, ImVec2 { .5f, .5f  } },
+        { "next"    , "Next"    , {{  .95f, 0, .050f,   1.f }}, lite_tint, ImVec2 { .5f, .5f  } },
+        { "settings", "Settings", {{ .070f, 0, .128f, .060f }}, dark_tint, ImVec2 { .5f, .85f } },
+        { "elements", "Elements", {{ .212f, 0, .128f, .060f }}, dark_tint, ImVec2 { .5f, .85f } },
+        { "chapters", "Chapters", {{ .354f, 0, .128f, .060f }}, dark_tint, ImVec2 { .5f, .85f } },
+        { "save"    , "Save"    , {{ .528f, 0, .128f, .060f }}, dark_tint, ImVec2 { .5f, .85f } },
+        { "saveas"  , "Save As" , {{ .670f, 0, .128f, .060f }}, dark_tint, ImVec2 { .5f, .85f } },
+        { "load"    , "Load"    , {{ .812f, 0, .128f, .060f }}, dark_tint, ImVec2 { .5f, .85f } }
+    }};
+    s.fonts = {};
+    return s;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+use_skin (const char* file, bool fonts)
+{
+    skin_t skin = default_skin ();
+    if (file && !load_skin (file, skin))
+        return false;
+
+    ID3D11ShaderResourceView* view = nullptr;
+    {
+        trace_span_t span ("ddsfile_texture", skin.background_file.c_str ());
+        if (!sseimgui.ddsfile_texture (skin.background_file.c_str (), nullptr, &view))
+        {
+            log () << "Unable to load DDS " << skin.background_file << '.' << std::endl;
+            return false;
+        }
+    }
+
+    if (pending.view)
+        pending.view->Release ();
+    pending.ready = true;
+    pending.fonts = fonts;
+    pending.skin = std::move (skin);
+    pending.view = view;
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+refresh_skin ()
+{
+    if (!pending.ready)
+        return;
+    pending.ready = false;
+
+    if (journal.background)
+        journal.background->Release ();
+    journal.background = pending.view;
+    pending.view = nullptr;
+    journal.skin = std::move (pending.skin);
+
+    for (std::size_t i = 0; i < journal.skin.buttons.size (); ++i)
+        (journal.*skin_buttons[i]).init (journal.skin.buttons[i]);
+
+    font_t* fonts[] = { &journal.button_font, &journal.chapter_font, &journal.text_font };
+    for (std::size_t i = 0; pending.fonts && i < journal.skin.fonts.size (); ++i)
+    {
+        auto const& sf = journal.skin.fonts[i];
+        if (!sf.given)
+            continue;
+        fonts[i]->file = sf.file;
+        fonts[i]->size = sf.size;
+        fonts[i]->color = sf.color;
+        fonts[i]->sdf = sf.sdf;
+        add_font (*fonts[i]);
+    }
+
+    relayout_book ();
+    invalidate_retained_book ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+relayout_book ()
+{
+    ++generation;
+}
+
+void
+layout_book (ImVec2 const& wsz)
+{
+    static ImVec2 last_wsz = {};
+    static unsigned last_generation = 0;
+    static float last_scale = 0;
+
+    auto font = journal.button_font.imfont;
+    if (wsz.x == last_wsz.x && wsz.y == last_wsz.y && generation == last_generation
+            && font->Scale == last_scale)
+        return;
+    last_wsz = wsz;
+    last_generation = generation;
+    last_scale = font->Scale;
+
+    imgui.igPushFont (font);
+    for (auto b: skin_buttons)
+        (journal.*b).layout (wsz, journal.skin.background_uv);
+    imgui.igPopFont ();
+
+    auto pixels = [&wsz] (skin_rect_t const& r) {
+        return layout_rect_t { ImVec2 { r[0] * wsz.x, r[1] * wsz.y },
+                               ImVec2 { r[2] * wsz.x, r[3] * wsz.y } };
+    };
+    for (std::size_t i = 0; i < journal.layout.titles.size (); ++i)
+    {
+        journal.layout.titles[i] = pixels (journal.skin.titles[i]);
+        journal.layout.texts[i]  = pixels (journal.skin.texts[i]);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
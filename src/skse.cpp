@@ -29,10 +29,9 @@
 #include <sse-gui/sse-gui.h>
 #include <sse-hooks/sse-hooks.h>
 #include <utils/winutils.hpp>
+#include "sse-journal.hpp"
 
-#include <fstream>
-#include <iomanip>
-#include <chrono>
+#include <cstring>
 #include <array>
 #include <cstdint>
 typedef std::uint32_t UInt32;
@@ -47,9 +46,6 @@ static PluginHandle plugin = 0;
 /// To communicate with the other SKSE plugins.
 static SKSEMessagingInterface* messages = nullptr;
 
-/// Log file in pre-defined location
-static std::ofstream logfile;
-
 /// [shared] Local initialization
 sseimgui_api sseimgui = {};
 
@@ -59,47 +55,6 @@ sseh_api sseh = {};
 /// [shared] Table with pointers
 imgui_api imgui = {};
 
-/// [shared] Reports current log file path (for user friendly messages)
-std::string logfile_path;
-
-/// [shared] Kind of message queue to be polled from the renderer for custom commands execution
-std::string journal_message;
-
-//--------------------------------------------------------------------------------------------------
-
-static void
-open_log ()
-{
-    logfile_path = "";
-    if (known_folder_path (FOLDERID_Documents, logfile_path))
-    {
-        // Before plugins are loaded, SKSE takes care to create the directiories
-        logfile_path += "\\My Games\\Skyrim Special Edition\\SKSE\\";
-    }
-    logfile_path += "sse-journal.log";
-    logfile.open (logfile_path);
-}
-
-//--------------------------------------------------------------------------------------------------
-
-decltype(logfile)&
-log ()
-{
-    // MinGW 4.9.1 have no std::put_time()
-    using std::chrono::system_clock;
-    auto now_c = system_clock::to_time_t (system_clock::now ());
-    auto loc_c = std::localtime (&now_c);
-    logfile << '['
-            << 1900 + loc_c->tm_year
-            << '-' << std::setw (2) << std::setfill ('0') << loc_c->tm_mon
-            << '-' << std::setw (2) << std::setfill ('0') << loc_c->tm_mday
-            << ' ' << std::setw (2) << std::setfill ('0') << loc_c->tm_hour
-            << ':' << std::setw (2) << std::setfill ('0') << loc_c->tm_min
-            << ':' << std::setw (2) << std::setfill ('0') << loc_c->tm_sec
-        << "] ";
-    return logfile;
-}
-
 //--------------------------------------------------------------------------------------------------
 
 void
@@ -123,7 +78,11 @@ handle_journal_message (SKSEMessagingInterface::Message* m)
 {
     if (m->type != 1 || m->dataLen < 1)
         return;
-    journal_message = reinterpret_cast<const char*> (m->data);
+    auto text = reinterpret_cast<const char*> (m->data);
+    command_t c = {};
+    c.type = command_find;
+    c.text.assign (text, strnlen (text, m->dataLen));
+    post_command (std::move (c));
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -181,17 +140,25 @@ handle_sseh_message (SKSEMessagingInterface::Message* m)
 
 //--------------------------------------------------------------------------------------------------
 
-/// Post Load ensure SSE-ImGui and Co. are loaded and can accept listeners
+/// Post Load ensure SSE-ImGui and Co. are loaded and can accept listeners, while on Post Post
+/// Load the other plugins are listening to us already
 
 static void
 handle_skse_message (SKSEMessagingInterface::Message* m)
 {
-    if (m->type != SKSEMessagingInterface::kMessage_PostLoad)
-        return;
-    log () << "SKSE Post Load." << std::endl;
-    messages->RegisterListener (plugin, "SSEH", handle_sseh_message);
-    messages->RegisterListener (plugin, "SSEIMGUI", handle_sseimgui_message);
-    messages->RegisterListener (plugin, "sse-maptrack", handle_journal_message);
+    if (m->type == SKSEMessagingInterface::kMessage_PostLoad)
+    {
+        log () << "SKSE Post Load." << std::endl;
+        messages->RegisterListener (plugin, "SSEH", handle_sseh_message);
+        messages->RegisterListener (plugin, "SSEIMGUI", handle_sseimgui_message);
+        messages->RegisterListener (plugin, "sse-maptrack", handle_journal_message);
+    }
+    else if (m->type == SKSEMessagingInterface::kMessage_PostPostLoad)
+    {
+        static ssejournal_api api = make_journal_api ();
+        messages->Dispatch (plugin, SSEJOURNAL_API_VERSION, &api, sizeof (api), nullptr);
+        log () << "Sent SSEJOURNAL interface v" << SSEJOURNAL_API_VERSION << std::endl;
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
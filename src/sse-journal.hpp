@@ -29,13 +29,20 @@
 #define SSEJOURNAL_HPP
 
 #include <sse-imgui/sse-imgui.h>
+#include <sse-journal/sse-journal.h>
 #include <utils/winutils.hpp>
 
 #include <d3d11.h>
 
+#include <array>
+#include <atomic>
+#include <bitset>
 #include <memory>
 #include <fstream>
+#include <sstream>
+#include <chrono>
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <utility>
@@ -47,50 +54,379 @@
 
 void journal_version (int* maj, int* min, int* patch, const char** timestamp);
 
-extern std::ofstream& log ();
-extern std::string logfile_path;
-extern std::string journal_message;
-
 extern imgui_api imgui;
 extern sseimgui_api sseimgui;
 
 //--------------------------------------------------------------------------------------------------
 
+// commands.cpp
+
+/// Bounded lock-free queue for many producers and a single consumer, see commands.cpp
+template<class T, std::size_t N>
+class mpsc_queue_t
+{
+    static_assert ((N & (N - 1)) == 0, "Capacity must be a power of two");
+
+    struct cell_t
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::array<cell_t, N> cells;
+    alignas (64) std::atomic<std::size_t> tail { 0 };
+    alignas (64) std::size_t head = 0;
+
+public:
+    mpsc_queue_t ()
+    {
+        for (std::size_t i = 0; i < N; ++i)
+            cells[i].sequence.store (i, std::memory_order_relaxed);
+    }
+
+    /// Any thread, false if full
+    bool push (T&& v)
+    {
+        auto pos = tail.load (std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& c = cells[pos & (N - 1)];
+            auto seq = c.sequence.load (std::memory_order_acquire);
+            auto dif = std::intptr_t (seq) - std::intptr_t (pos);
+            if (dif == 0)
+            {
+                if (tail.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+                {
+                    c.data = std::move (v);
+                    c.sequence.store (pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0)
+                return false;
+            else pos = tail.load (std::memory_order_relaxed);
+        }
+    }
+
+    /// Consumer thread only, false if empty (or the next one is not published yet)
+    bool pop (T& v)
+    {
+        auto& c = cells[head & (N - 1)];
+        if (c.sequence.load (std::memory_order_acquire) != head + 1)
+            return false;
+        v = std::move (c.data);
+        c.sequence.store (head + N, std::memory_order_release);
+        ++head;
+        return true;
+    }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+// logger.cpp
+
+enum log_level_t
+{
+    log_debug,
+    log_info,
+    log_warning,
+    log_error
+};
+
+/// Lines below it are dropped by #log() already, set from the settings
+extern std::atomic<int> log_threshold;
+extern std::string logfile_path;
+
+/// Starts the writer thread, before that the lines just wait in the queue
+void open_log ();
+
+/// Per call site budget, e.g. `static log_limit_t limit (5); log (log_warning, &limit) << ...`
+struct log_limit_t
+{
+    explicit log_limit_t (unsigned per_second) : per_second (per_second) {}
+    unsigned const per_second;
+    std::atomic<std::int64_t> second { -1 };
+    std::atomic<unsigned> count { 0 }, suppressed { 0 };
+};
+
+/// One line, queued as a whole at the end of the statement which composed it
+class log_line_t
+{
+    log_level_t level;
+    std::ostringstream* out = nullptr;  ///< None if filtered out or rate limited
+    std::unique_ptr<std::ostringstream> own;
+    bool* owner = nullptr;          ///< The thread buffer to give back
+
+public:
+    log_line_t (log_level_t level, log_limit_t* limit);
+    log_line_t (log_line_t const&) = delete;
+    log_line_t& operator= (log_line_t const&) = delete;
+    ~log_line_t ();
+
+    template<class T>
+    log_line_t& operator<< (T const& v) {
+        if (out) *out << v;
+        return *this;
+    }
+    log_line_t& operator<< (std::ostream& (*manip) (std::ostream&)) {
+        if (out) manip (*out);
+        return *this;
+    }
+    log_line_t& operator<< (std::ios_base& (*manip) (std::ios_base&)) {
+        if (out) manip (*out);
+        return *this;
+    }
+};
+
+/// Any thread, never blocks nor touches the file
+inline log_line_t
+log (log_level_t level = log_info, log_limit_t* limit = nullptr) {
+    return log_line_t (level, limit);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 // fileio.cpp
 
-bool save_text (std::string const& destination);
-bool save_book (std::string const& destination);
-bool load_book (std::string const& source);
-bool load_takenotes (std::string const& source);
+bool save_text (const char* destination);
+bool save_book (const char* destination);
+/// Thread-safe parsing only, #install_book() does the rest on the render thread
+struct book_t;
+bool read_book (const char* source, book_t& book);
+/// Blocking #read_book() and #install_book()
+bool load_book (const char* source);
+bool load_takenotes (const char* source);
 bool save_settings ();
 bool load_settings ();
 bool save_variables ();
 bool load_variables ();
+/// Whatever the file gives overrides what is in @param skin already
+struct skin_t;
+bool load_skin (const char* source, skin_t& skin);
 
 extern std::string journal_directory;
 extern std::string books_directory;
 extern std::string default_book;
 extern std::string settings_location;
+extern std::string skins_directory;
+extern std::string default_skin_location;
 extern std::string images_directory;
+extern std::string fonts_cache_location;
+extern std::string profile_location;
+extern std::string trace_location;
+extern std::string allocations_location;
+extern std::string input_location;
+extern std::string input_timings_location;
+extern std::string travel_location;
 
 //--------------------------------------------------------------------------------------------------
 
 // variables.cpp
 
+/// Parameters of a variable compiled into literal runs and tokens, see #compile_format()
+struct format_t
+{
+    static constexpr std::uint32_t literal = ~0u;
+    struct op_t
+    {
+        std::uint32_t token;    ///< Index in the token table, or #literal
+        std::uint32_t offset, size; ///< Of the literal in #source
+    };
+    std::string source;         ///< What got compiled, recompiled when the parameters differ
+    std::vector<op_t> ops;
+    bool compiled = false;
+    std::string out;            ///< Last expansion, keeps its memory for the next
+};
+
 struct variable_t
 {
     bool deletable;
     int fuid;   ///< Unique identifier of functions, allows loading of custom vars
     std::string name, params, info;
-    std::function<std::string (variable_t*)> apply;   ///< Avoids inheritance, dynamic mem & etc.
-    inline std::string operator () () { return apply (this); }
+    std::string key;            ///< Of the placeholders, besides the one made of the #name
+    /// Avoids inheritance, dynamic mem & etc., the view is valid until the next call
+    std::function<std::string_view (variable_t*)> apply;
+    format_t format;            ///< Of #params, kept by #apply, and its output
+    inline std::string_view operator () () { return apply (this); }
 };
 
+/// Longest matching "%token" wins, unknown ones stay as text
+void compile_format (format_t& format, std::string const& source,
+        const char* const* tokens, std::size_t count);
+
+/// Into @param out, reusing its memory, @param values being indexed as the tokens
+void expand_format (format_t const& format, std::string_view const* values, std::string& out);
+
 /// @see https://en.cppreference.com/w/cpp/chrono/c/strftime
 std::string local_time (const char* format);
 
+/// What the variables show of the game, read and validated at once by #sample_game_state()
+struct game_state_t
+{
+    std::uint64_t sample;           ///< Zero if none taken yet
+    bool time_ok, position_ok;      ///< Otherwise the fields below are left zero
+    float time;                     ///< Days since the game start, see variables.cpp
+    float position[3];
+    char cell[128], worldspace[128];    ///< Copied, empty if none
+};
+
+/// Where the game memory is safe to read, i.e. each frame in render()
+void sample_game_state ();
+
+/// The last sample, from any thread
+game_state_t game_state ();
+
+/// Of a #game_state_t::time, formatted as the "Game time" variable is, e.g. "%Y %lm %md", the
+/// view is valid until the next call
+std::string_view game_date (float time, const char* format);
+
+/// E.g. "Frostfall" for 9, empty if not a month from 0 to 11
+const char* game_month_name (int month);
+
+/// Game times of a month, [@param from, @param to), e.g. of Frostfall 4E201 for 201 and 9
+void game_month_range (int year, int month, float& from, float& to);
+
 std::vector<variable_t> make_variables ();
 
+/// A source of variables registered by another plugin, see sse-journal/sse-journal.h
+struct provider_t
+{
+    std::string name, info, params;
+    float ttl;                  ///< Seconds
+    ssejournal_evaluate_t evaluate;
+    void* context;
+    struct cached_t
+    {
+        std::string params, value;  ///< Both keep their memory for the next evaluations
+        std::uint64_t expires;      ///< In #profile_ticks()
+        bool ok;
+    };
+    std::vector<cached_t> cache;    ///< Few entries, one per copy of the variable
+};
+
+/// Render thread, adds the variable of @param provider, or rebinds the one of the same name
+void add_provider (std::shared_ptr<provider_t> provider);
+
+//--------------------------------------------------------------------------------------------------
+
+// watcher.cpp
+
+/// Keeps a sorted list of file names (sans extension) in a directory, updated incrementally
+class directory_watch_t
+{
+public:
+    enum action_t { added, removed, renamed };
+    struct event_t
+    {
+        action_t action;
+        std::string name, old_name; ///< The old one is set only on renames
+    };
+
+    directory_watch_t () = default;
+    directory_watch_t (directory_watch_t const&) = delete;
+    directory_watch_t& operator= (directory_watch_t const&) = delete;
+    ~directory_watch_t () { close (); }
+
+    /// Initial scan, then native change notifications if possible, or periodic rescans if not
+    bool open (std::string const& directory, std::string const& extension);
+    void close ();
+    inline bool is_open () const { return opened; }
+
+    /// Non-blocking, to be called from the render loop. True if #names() changed.
+    bool poll ();
+
+    inline std::vector<std::string> const& names () const { return files; }
+    /// What changed during the last #poll(), in order of arrival
+    inline std::vector<event_t> const& events () const { return changes; }
+
+    /// Rescan period used when no native notifications are available
+    unsigned poll_interval_ms = 1000;
+
+private:
+    bool matches (std::string const& filename) const;
+    bool insert (std::string name);   ///< False if already listed
+    bool erase (std::string const& name);
+    bool rescan ();
+    bool native_open ();
+    bool native_poll ();
+    void native_close ();
+
+    bool opened = false;
+    std::string directory, extension;
+    std::vector<std::string> files;
+    std::vector<event_t> changes;
+    std::uint64_t last_scan = 0;
+    void* native = nullptr; ///< Platform specific watch state, null if polling
+};
+
+/// Plain one-shot directory listing (sans extensions), sorted
+bool enumerate_filenames (
+        std::string const& directory, std::string const& extension, std::vector<std::string>& out);
+
+//--------------------------------------------------------------------------------------------------
+
+// skin.cpp
+
+/// Left, top, width and height as fractions of the book window
+using skin_rect_t = std::array<float, 4>;
+
+struct skin_button_t
+{
+    const char* key;        ///< Name in the skin file, also makes the ImGui id
+    std::string label;
+    skin_rect_t rect;
+    std::uint32_t hover_tint;
+    ImVec2 align;           ///< Of the label inside #rect
+};
+
+/// Only what the skin file gives overrides the settings, and only when picked from the UI
+struct skin_font_t
+{
+    bool given;
+    std::string file;
+    float size;
+    std::uint32_t color;
+    bool sdf;
+};
+
+/// Background art and where everything sits on it, see #use_skin()
+struct skin_t
+{
+    std::string background_file;
+    std::array<float, 4> background_uv;    ///< Part of the texture stretched over the window
+    std::array<skin_rect_t, 2> titles;      ///< Left and right page, height is the font one
+    std::array<skin_rect_t, 2> texts;
+    std::array<skin_button_t, 8> buttons;   ///< Same order as in #default_skin()
+    std::array<skin_font_t, 3> fonts;       ///< Button, chapter and text ones
+};
+
+/// Pixel geometry of a rectangle relative to the window
+struct layout_rect_t
+{
+    ImVec2 pos, size;
+};
+
+/// The skin resolved for the current book window size, see #layout_book()
+struct book_layout_t
+{
+    std::array<layout_rect_t, 2> titles, texts;
+};
+
+/// The hard-coded one, used for anything missing in a skin file
+skin_t default_skin ();
+
+/// Loads the background and queues the skin for #refresh_skin(), @param fonts applies its fonts
+bool use_skin (const char* file, bool fonts);
+
+/// Call between frames, swaps in a queued skin
+void refresh_skin ();
+
+/// Resolves the skin to pixels, if any of the window size, skin or buttons font changed
+void layout_book (ImVec2 const& wsz);
+
+/// Makes the next #layout_book() resolve again, e.g. after the fonts were rebuilt
+void relayout_book ();
+
 //--------------------------------------------------------------------------------------------------
 
 // render.cpp
@@ -98,20 +434,26 @@ std::vector<variable_t> make_variables ();
 /// Wraps up common logic for drawing a button
 class button_t
 {
-    ImVec2 tl, sz, align;
-    const char *label, *label_end;
+    std::string label;          ///< Followed by the ImGui id
+    std::size_t label_size;     ///< Of the shown part only
+    skin_rect_t rect;
+    ImVec2 align;
     std::uint32_t hover_tint;
+    ImVec2 pos, size, text_pos, uv0, uv1; ///< Resolved by #layout()
 
 public:
-    static ImVec2 wpos, wsz;
+    static ImVec2 wpos;
 
-    void init (const char* label,
-            float tlx, float tly, float szx, float szy,
-            std::uint32_t hover, float ax = .5f, float ay = .5f);
+    void init (skin_button_t const& skin);
+    /// Needs the buttons font pushed, as the label is measured with it
+    void layout (ImVec2 const& wsz, std::array<float, 4> const& background_uv);
 
     bool draw ();
 };
 
+/// Uncollapses and focuses the book window, once it is shown (mod commands run while hidden)
+void show_book_window ();
+
 struct image_t
 {
     bool background;    ///< Will be there text above it?
@@ -121,10 +463,20 @@ struct image_t
     ID3D11ShaderResourceView* ref;
 };
 
+/// Where a page was written, see places.cpp
+struct geotag_t
+{
+    bool tagged;
+    std::string worldspace, cell;   ///< The cell is the space of interiors, without a worldspace
+    float position[3];
+};
+
 struct page_t
 {
     std::string title, content;
     image_t image;
+    geotag_t place;
+    float written;  ///< Game time of the creation (see #game_state_t::time), zero if unknown
 };
 
 struct font_t
@@ -137,10 +489,477 @@ struct font_t
     std::string glyphs;
     std::vector<ImWchar> ranges;
     const char* default_data;
+    bool sdf;       ///< Signed distance field rendering, sharp at any size and scale
     ImFont* imfont; ///< Actual font with its settings (apart from #color)
 };
 
-extern bool obtain_image (std::string const& file, image_t& img);
+extern bool obtain_image (const char* file, image_t& img);
+extern void release_image (image_t& img);
+
+/// Breaks the lines longer than @param width at their last space, as the Settings "Wrap" does
+std::string greedy_word_wrap (std::string const& source, unsigned width);
+
+//--------------------------------------------------------------------------------------------------
+
+// fonts.cpp
+
+/// Registers the font with the journal atlas, actual loading happens in #build_fonts()
+void add_font (font_t& font);
+
+/// Blocking (re)creation of all fonts and their texture, invalidates any previous font_t::imfont
+bool build_fonts ();
+
+/// Call between frames: swaps in a finished background build, or starts one for pending changes
+void refresh_fonts ();
+
+/// Makes the code points in a UTF-8 text available for the fonts in the "used" glyphs mode
+void note_glyphs (const char* text, const char* text_end = nullptr);
+/// Same for a single code point, as typed
+void note_glyph (unsigned c);
+
+inline void note_glyphs (std::string const& text) {
+    note_glyphs (text.data (), text.data () + text.size ());
+}
+
+/// Brackets text drawn with a SDF font in @param dl (else the current window), no-ops for the rest
+void begin_font_shader (font_t const& font, ImDrawList* dl = nullptr);
+void end_font_shader (font_t const& font, ImDrawList* dl = nullptr);
+
+//--------------------------------------------------------------------------------------------------
+
+// sdf.cpp
+
+/// Alpha8 coverage to signed distance field, 128 is the edge and @param spread pixels are +-127
+void make_sdf (unsigned char const* src, unsigned char* dst, int stride,
+        int x, int y, int width, int height, int spread);
+
+//--------------------------------------------------------------------------------------------------
+
+// truetype.cpp
+
+/// A TrueType font data at one size, its glyphs surrounded by @ref padding empty pixels
+struct atlas_face_t
+{
+    std::vector<char> const* ttf;
+    float size;
+    ImWchar const* ranges;  ///< ImGui format, zero terminated pairs of inclusive bounds
+    int padding;
+};
+
+/// As ImGui 1.70 would lay out the face, with the oversampling defaults
+struct atlas_font_t
+{
+    float ascent, descent;
+    std::vector<ImFontGlyph> glyphs;
+};
+
+struct atlas_pixels_t
+{
+    std::vector<unsigned char> alpha8;
+    int width, height;
+    ImVec2 uv_white, uv_scale;
+};
+
+/// The ImGui binary_to_compressed_c output (base85 of stb_compress) back to the font data
+bool decompress_base85_ttf (const char* base85, std::vector<char>& ttf);
+
+/// Tells apart the fonts rasterize_atlas() can read (TrueType outlines)
+bool is_truetype (std::vector<char> const& ttf);
+
+/// Makes no ImGui call, can run on any thread; false if a face is unreadable, the rest is done
+bool rasterize_atlas (std::vector<atlas_face_t> const& faces, std::vector<atlas_font_t>& fonts,
+        atlas_pixels_t& atlas);
+
+//--------------------------------------------------------------------------------------------------
+
+// profiler.cpp
+
+enum profile_stage_t
+{
+    stage_frame, stage_command, stage_book, stage_settings, stage_elements, stage_chapters,
+    stage_saveas, stage_load, stage_nearby, stage_timeline, stage_count
+};
+extern const char* const profile_stage_names[stage_count];
+
+/// Off by default, then each scope costs a branch only
+extern bool profiler_enabled;
+
+std::uint64_t profile_ticks ();
+
+/// Times the rest of the enclosing scope, the #stage_frame one closes the frame sample
+class profile_scope_t
+{
+    profile_stage_t stage = stage_count, outer;
+    std::uint64_t start;
+    void enter (profile_stage_t stage);
+    void leave ();
+public:
+    explicit inline profile_scope_t (profile_stage_t stage) { if (profiler_enabled) enter (stage); }
+    inline ~profile_scope_t () { if (stage != stage_count) leave (); }
+    profile_scope_t (profile_scope_t const&) = delete;
+    profile_scope_t& operator= (profile_scope_t const&) = delete;
+
+    /// Innermost stage entered on the calling thread, #stage_count if none
+    static profile_stage_t current_stage ();
+};
+
+struct profile_sample_t
+{
+    std::uint64_t frame;
+    std::array<float, stage_count> ms;
+    std::array<std::uint32_t, stage_count> allocs;  ///< Only while #alloc_tracking
+    std::array<std::uint32_t, stage_count> alloc_bytes;
+};
+
+struct profile_summary_t
+{
+    std::array<float, stage_count> avg_ms, p99_ms, avg_allocs, avg_alloc_bytes;
+    std::vector<float> frame_ms;    ///< Oldest first
+};
+
+void profile_note_allocation (profile_stage_t stage, std::size_t size);
+
+/// Copies of the recorded frames, oldest first, safe to call from any thread
+void profile_snapshot (std::vector<profile_sample_t>& out);
+/// Over all recorded frames, render thread only as the result is reused
+profile_summary_t const& profile_summary ();
+bool export_profile (std::string const& destination);
+
+//--------------------------------------------------------------------------------------------------
+
+// allocs.cpp
+
+/// Off by default, it needs the profiler recording too
+extern std::atomic<bool> alloc_tracking;
+extern std::uint64_t alloc_tracked_frames;
+
+/// A named place to attribute allocations to, to be declared function static
+struct alloc_site_t
+{
+    const char* name;
+    std::uint64_t count = 0, bytes = 0;
+    alloc_site_t* next;
+    static alloc_site_t* first;
+    explicit alloc_site_t (const char* name);
+};
+
+/// Allocations in the rest of the scope go to the site instead of the profiled stage
+class alloc_scope_t
+{
+    alloc_site_t* outer;
+public:
+    static thread_local alloc_site_t* current;
+    explicit inline alloc_scope_t (alloc_site_t& site) : outer (current) { current = &site; }
+    inline ~alloc_scope_t () { current = outer; }
+    alloc_scope_t (alloc_scope_t const&) = delete;
+    alloc_scope_t& operator= (alloc_scope_t const&) = delete;
+};
+
+/// Sites with any allocation, most allocating first
+void top_alloc_sites (std::vector<alloc_site_t const*>& out);
+void reset_alloc_sites ();
+bool dump_allocations (std::string const& destination);
+
+//--------------------------------------------------------------------------------------------------
+
+// trace.cpp
+
+/// Switchable at any time, from any thread
+extern std::atomic<bool> trace_enabled;
+
+void trace_record (const char* name, const char* detail, std::uint64_t start);
+/// Writes what was recorded as Chrome trace JSON, then forgets it
+bool save_trace (std::string const& destination);
+void clear_trace ();
+
+/// Records the rest of the enclosing scope, @param detail (e.g. a file) must outlive it
+class trace_span_t
+{
+    const char *name, *detail;
+    std::uint64_t start;
+public:
+    explicit inline trace_span_t (const char* name, const char* detail = nullptr)
+        : name (name), detail (detail)
+        , start (trace_enabled.load (std::memory_order_relaxed) ? profile_ticks () : 0) {}
+    inline ~trace_span_t () { if (start) trace_record (name, detail, start); }
+    trace_span_t (trace_span_t const&) = delete;
+    trace_span_t& operator= (trace_span_t const&) = delete;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+// arena.cpp
+
+/// Render thread only, whatever is allocated from it is gone once render() returns
+class frame_arena_t
+{
+    struct block_t
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+    std::vector<block_t> blocks;
+    std::size_t current = 0, used = 0;
+
+public:
+    static constexpr std::size_t block_size = 64 * 1024;
+    void* allocate (std::size_t size, std::size_t align);
+    void reset ();
+};
+
+extern frame_arena_t frame_arena;
+
+template<class T>
+struct frame_allocator_t
+{
+    using value_type = T;
+    frame_allocator_t () = default;
+    template<class U> frame_allocator_t (frame_allocator_t<U> const&) {}
+    inline T* allocate (std::size_t n) {
+        return static_cast<T*> (frame_arena.allocate (n * sizeof (T), alignof (T)));
+    }
+    inline void deallocate (T*, std::size_t) {}
+    template<class U> bool operator== (frame_allocator_t<U> const&) const { return true; }
+    template<class U> bool operator!= (frame_allocator_t<U> const&) const { return false; }
+};
+
+/// Transient text, don't keep it past the frame it was made in
+using frame_string_t = std::basic_string<char, std::char_traits<char>, frame_allocator_t<char>>;
+
+//--------------------------------------------------------------------------------------------------
+
+// commands.cpp (cont.)
+
+enum command_type_t
+{
+    command_find,   ///< SSE-MapTrack: text to find, optionally ended by @ and a book name
+    command_batch,  ///< Records of the public API, already validated, see #apply_batch()
+    command_query,  ///< Public API page reading, see #run_query()
+};
+
+struct command_t
+{
+    command_type_t type;
+    std::string text;                   ///< Or the bytes of a batch
+    ssejournal_page_callback callback;  ///< The rest is for #command_query only
+    void* user;
+    std::int32_t first, count;
+};
+
+struct command_stats_t
+{
+    std::uint64_t posted, dropped, taken;
+};
+
+/// Any thread, never blocks. False if the queue is full: the command is dropped and counted.
+bool post_command (command_t&& cmd);
+
+/// Render thread only, replaces @param out with up to @param max commands in order of posting
+void take_commands (std::vector<command_t>& out, std::size_t max);
+
+/// Any thread, never blocks nor drops, unlike the commands
+void post_provider (std::shared_ptr<provider_t> provider);
+
+/// Render thread only, replaces @param out with all the providers posted, in order of posting
+void take_providers (std::vector<std::shared_ptr<provider_t>>& out);
+
+command_stats_t command_stats ();
+
+//--------------------------------------------------------------------------------------------------
+
+// api.cpp
+
+/// The table sent to the other plugins, see sse-journal/sse-journal.h
+ssejournal_api make_journal_api ();
+
+/// Render thread, from the commands queue
+void apply_batch (std::string const& batch);
+void run_query (command_t const& query);
+
+//--------------------------------------------------------------------------------------------------
+
+// retained.cpp
+
+/// Replay the last spread while the book sits idle, otherwise it is rebuilt every frame
+extern bool retained_book;
+
+/// Called from draw_book(), true if the recorded spread was appended instead of drawing it
+bool replay_book ();
+void begin_book_capture ();
+/// The child window of a multiline text box, recorded after the parent at the end
+void capture_book_child (ImDrawList const* dl);
+void end_book_capture ();
+
+/// Forces a full draw, for changes of what is shown which did not come through the input
+void invalidate_retained_book ();
+
+//--------------------------------------------------------------------------------------------------
+
+// books.cpp
+
+/// A book out of journal_t, either being read or kept in the cache
+struct book_t
+{
+    std::string file;
+    std::vector<page_t> pages;
+    std::vector<std::string> image_files; ///< Per page, obtained on the render thread
+    unsigned current_page;
+    std::string messages;   ///< For the log, from the reading thread
+    bool ok;
+    std::size_t bytes;      ///< Accounted in the cache
+};
+
+/// Bytes of text the cached books may hold, not counting the current one
+extern std::size_t book_cache_limit;
+
+/// Makes @param book current, the previous one goes into the cache
+void install_book (book_t&& book);
+
+/// Puts the current book into the cache (or drops it if it has no file) leaving none
+void stash_book ();
+
+/// Drops the cached copy, if any, of a file which changed on disk
+void forget_book (std::string const& file);
+
+/// True if current already or swapped in from the cache, else read in the background
+bool open_book (std::string const& file);
+
+/// Read from disk in the background, regardless of the cache
+void reload_book (std::string const& file);
+
+/// What became of the wanted book, as of #poll_books()
+enum book_read_t { book_reading, book_installed, book_failed };
+
+/// Render thread, between frames: makes current the wanted book once read
+book_read_t poll_books ();
+
+struct book_cache_stats_t
+{
+    std::size_t books, bytes;
+};
+
+book_cache_stats_t book_cache_stats ();
+
+//--------------------------------------------------------------------------------------------------
+
+// input.cpp
+
+/// What ImGui got as input in one frame, and where the book window was
+struct input_frame_t
+{
+    float delta_time;
+    ImVec2 display_size, mouse_pos;
+    float wheel, wheel_h;
+    std::uint8_t mouse_down;    ///< Bit per button
+    std::uint8_t modifiers;     ///< Bits: ctrl, shift, alt, super
+    std::bitset<512> keys;
+    std::vector<ImWchar> chars;
+    ImVec2 window_pos, window_size;
+};
+
+input_frame_t capture_input (ImGuiIO const& io);
+bool write_input_record (std::string const& destination, std::vector<input_frame_t> const& frames);
+bool read_input_record (std::string const& source, std::vector<input_frame_t>& frames);
+
+enum input_mode_t { input_idle, input_recording, input_replaying };
+
+struct input_status_t
+{
+    input_mode_t mode;
+    std::size_t frame, frames;
+};
+
+/// Into #input_location, until stopped
+bool start_input_recording ();
+/// From #input_location, the frame timings go into #input_timings_location once done
+bool start_input_replay ();
+/// Saves what is being recorded or the timings of the replay so far
+bool stop_input ();
+input_status_t input_status ();
+
+/// Around render(): after the book window is given its default size, once it began, at the end
+void begin_input_frame ();
+void input_book_window ();
+void end_input_frame ();
+
+//--------------------------------------------------------------------------------------------------
+
+// places.cpp
+
+/// Stamps where the player is, if known, on a page just created or first written
+bool geotag_page (page_t& page);
+
+/// Page indices changed, rebuilds the index on the next query
+void invalidate_places ();
+
+struct place_hit_t
+{
+    unsigned page;
+    float distance;
+};
+
+/// Into the [512, 65536] units of the settings, the default 8192 if not a number
+float nearby_radius_of (float radius);
+
+/// Tagged pages within @param radius of the last #game_state(), nearest first
+void pages_near_player (float radius, std::vector<place_hit_t>& hits);
+
+//--------------------------------------------------------------------------------------------------
+
+// chronology.cpp
+
+/// The game time and place onto a page just created or first written, unless already there
+void stamp_page (page_t& page);
+
+/// Page indices or stamps changed, rebuilds the index on its next use
+void invalidate_chronology ();
+
+struct chronology_entry_t
+{
+    float time;
+    unsigned page;
+};
+
+/// The stamped pages, oldest first
+std::vector<chronology_entry_t> const& chronology ();
+
+/// Positions in #chronology() of the pages written in [@param from, @param to)
+std::pair<std::size_t, std::size_t> chronology_range (float from, float to);
+
+//--------------------------------------------------------------------------------------------------
+
+// placeholders.cpp
+
+/// Of a variable named @param name, e.g. game_time for "Game time (fixed)"
+std::string placeholder_key (std::string const& name);
+
+/// Into @param out, false if @param source has no {key} or {key:parameters} of a variable
+bool expand_placeholders (std::string const& source, std::string& out);
+
+/// Render thread, the cached expansion of a shown page text, nullptr if it has no placeholders
+std::string const* expanded_text (std::string const& text);
+
+/// Changes whenever an expanded text did, for what was drawn of them to be redrawn
+std::uint64_t placeholders_generation ();
+
+/// The variables changed, e.g. a provider got registered again
+void invalidate_placeholders ();
+
+//--------------------------------------------------------------------------------------------------
+
+// travel.cpp
+
+/// Flushes the last samples at exit
+void open_travel ();
+
+/// Every frame, shown or not, samples the game as often as the settings say
+void tick_travel ();
+
+/// The samples not yet written, appended to #travel_location
+bool flush_travel ();
+
+/// A line per place arrived in this session, e.g. "Arrived in Whiterun, 4E201 Last Seed 17"
+std::string travel_summary ();
 
 //--------------------------------------------------------------------------------------------------
 
@@ -148,7 +967,13 @@ extern bool obtain_image (std::string const& file, image_t& img);
 struct journal_t
 {
     bool show_titlebar;
-    std::string background_file;
+    bool trace;     ///< Keep recording the I/O spans after the startup
+    bool travel_log;
+    float travel_cadence;   ///< Seconds between the travel samples
+    std::string skin_file;
+    std::string background_file;    ///< Of the settings, for skins without any
+    skin_t skin;
+    book_layout_t layout;
     ID3D11ShaderResourceView* background;
 
     font_t button_font, chapter_font, text_font, default_font;
@@ -156,9 +981,12 @@ struct journal_t
     button_t button_prev, button_next,
              button_settings, button_elements, button_chapters,
              button_save, button_saveas, button_load;
-    bool show_settings, show_elements, show_chapters, show_saveas, show_load;
+    bool show_settings, show_elements, show_chapters, show_saveas, show_load, show_profiler;
+    bool show_nearby, show_timeline;
+    float nearby_radius;    ///< Game units of the pages listed as written nearby
 
     std::vector<variable_t> variables;
+    std::vector<variable_t> unclaimed_variables;    ///< Saved, of providers not registered yet
 
     struct image_source_t {
         unsigned refcount;
@@ -167,6 +995,7 @@ struct journal_t
     /// Kinda garbage collection, allows sharing of textures across the book
     std::map<ID3D11ShaderResourceView*, image_source_t> images;
 
+    std::string book_file;  ///< Empty for a book not read from or saved into a file
     std::vector<page_t> pages;
     unsigned current_page;
 };
@@ -0,0 +1,136 @@
+/**
+ * @file trace.cpp
+ * @brief Timed spans of the startup and I/O paths, saved as Chrome trace events
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * Each span becomes a "complete" event (ph X) with its own start and duration, so nesting is
+ * recovered by the viewer from the times on the same thread, and spans may end in any order.
+ * Spans are few (whole files, not frames), hence a plain mutex guards the list. The output loads
+ * in chrome://tracing or https://ui.perfetto.dev.
+ */
+
+#include "sse-journal.hpp"
+
+#include <mutex>
+#include <iomanip>
+
+//--------------------------------------------------------------------------------------------------
+
+std::atomic<bool> trace_enabled { false };
+
+struct trace_event_t
+{
+    const char* name;
+    std::string detail;
+    std::uint64_t start, end;
+    unsigned tid;
+};
+
+static std::mutex trace_mutex;
+static std::vector<trace_event_t> events;
+
+/// Small sequential ids read better in the viewer than the OS ones
+static unsigned
+thread_index ()
+{
+    static std::atomic<unsigned> next { 1 };
+    thread_local unsigned id = next++;
+    return id;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+trace_record (const char* name, const char* detail, std::uint64_t start)
+{
+    trace_event_t e { name, detail ? detail : "", start, profile_ticks (), thread_index () };
+    std::lock_guard<std::mutex> lock (trace_mutex);
+    events.push_back (std::move (e));
+}
+
+void
+clear_trace ()
+{
+    std::lock_guard<std::mutex> lock (trace_mutex);
+    events.clear ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+write_json_string (std::ostream& os, std::string const& s)
+{
+    os << '"';
+    for (unsigned char c: s)
+    {
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (c < 0x20)
+            os << "\\u" << std::hex << std::setw (4) << std::setfill ('0') << unsigned (c)
+               << std::dec;
+        else os << c;
+    }
+    os << '"';
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+save_trace (std::string const& destination)
+{
+    std::vector<trace_event_t> copy;
+    {
+        std::lock_guard<std::mutex> lock (trace_mutex);
+        copy.swap (events);
+    }
+
+    std::ofstream of (destination);
+    if (!of.is_open ())
+    {
+        log () << "Unable to open " << destination << " for writting." << std::endl;
+        return false;
+    }
+
+    // Microseconds are the unit, the fraction keeps the nanoseconds
+    of << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::fixed << std::setprecision (3);
+    for (std::size_t i = 0; i < copy.size (); ++i)
+    {
+        auto const& e = copy[i];
+        of << (i ? ",\n" : "\n") << "{\"ph\":\"X\",\"cat\":\"journal\",\"pid\":1,\"tid\":" << e.tid
+           << ",\"ts\":" << e.start * 1e-3 << ",\"dur\":" << (e.end - e.start) * 1e-3
+           << ",\"name\":";
+        write_json_string (of, e.name);
+        if (!e.detail.empty ())
+        {
+            of << ",\"args\":{\"detail\":";
+            write_json_string (of, e.detail);
+            of << '}';
+        }
+        of << '}';
+    }
+    of << "\n]}\n";
+    return bool (of);
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,325 @@
+/**
+ * @file travel.cpp
+ * @brief Automatic log of where and when the player went, written in batches
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * SSE-ImGui calls render() every frame, shown or not, hence #tick_travel() is there. Most frames
+ * it only compares a tick count. Every #journal_t::travel_cadence seconds it samples the game
+ * state, and keeps the sample if the cell or the worldspace changed, if the player moved far
+ * enough, or if the game time jumped (waiting, sleeping, fast travel).
+ *
+ * A kept sample is a byte of flags, the changed names, then zigzag varints of the differences
+ * in game seconds and in each coordinate: five to ten bytes when only walking. Samples go into
+ * a batch, which starts from zero so it decodes on its own. A full or old batch is appended to
+ * #travel_location, and kept in a ring of the recent ones for the summaries. The log past
+ * #log_bytes is moved aside, with one older generation kept, and the last batch is flushed at
+ * exit.
+ */
+
+#include "sse-journal.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr char travel_magic[4] = { 'S', 'J', 'T', 'L' };
+constexpr std::uint32_t travel_version = 1;
+
+constexpr std::size_t batch_bytes = 4096;       ///< Flushed once this big
+constexpr double batch_seconds = 300;           ///< Or this old, not to lose much on a crash
+constexpr std::size_t ring_bytes = 64 * 1024;   ///< Of flushed batches kept in memory
+constexpr std::streamoff log_bytes = 4 << 20;   ///< Then the log goes to ".1", replacing it
+constexpr float travel_distance = 1024;         ///< Game units, a cell is 4096
+constexpr std::int64_t travel_jump = 3600;      ///< Game seconds
+
+enum : std::uint8_t
+{
+    changed_cell        = 1 << 0,
+    changed_worldspace  = 1 << 1
+};
+
+/// Quantized, as encoded
+struct travel_point_t
+{
+    std::int64_t time;          ///< Game seconds
+    std::int32_t position[3];
+    std::string cell, worldspace;
+};
+
+static struct
+{
+    std::uint64_t next_ticks;
+    std::uint64_t batch_ticks;  ///< When the batch got its first sample
+    std::string batch;
+    std::uint32_t count;        ///< Samples in the batch
+    travel_point_t last;        ///< Encoded last, what the next is a delta of
+    bool have_last;             ///< Else the next sample is kept whatever it is
+    std::deque<std::pair<std::uint32_t, std::string>> ring;
+    std::size_t ring_size;
+}
+travel = {};
+
+//--------------------------------------------------------------------------------------------------
+
+static inline void
+put_varint (std::string& out, std::uint64_t v)
+{
+    for (; v >= 0x80; v >>= 7)
+        out += char (v | 0x80);
+    out += char (v);
+}
+
+static inline void
+put_signed (std::string& out, std::int64_t v)
+{
+    put_varint (out, (std::uint64_t (v) << 1) ^ std::uint64_t (v >> 63));
+}
+
+static inline void
+put_name (std::string& out, std::string const& name)
+{
+    put_varint (out, name.size ());
+    out += name;
+}
+
+static inline bool
+get_varint (const char*& p, const char* end, std::uint64_t& v)
+{
+    v = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7)
+    {
+        auto b = std::uint8_t (*p++);
+        v |= std::uint64_t (b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static inline bool
+get_signed (const char*& p, const char* end, std::int64_t& v)
+{
+    std::uint64_t u;
+    if (!get_varint (p, end, u))
+        return false;
+    v = std::int64_t (u >> 1) ^ -std::int64_t (u & 1);
+    return true;
+}
+
+static inline bool
+get_name (const char*& p, const char* end, std::string& name)
+{
+    std::uint64_t n;
+    if (!get_varint (p, end, n) || n > std::uint64_t (end - p))
+        return false;
+    name.assign (p, std::size_t (n));
+    p += n;
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+encode_point (travel_point_t const& t, travel_point_t const& prev, std::string& out)
+{
+    std::uint8_t flags = (t.cell != prev.cell ? changed_cell : 0)
+                       | (t.worldspace != prev.worldspace ? changed_worldspace : 0);
+    out += char (flags);
+    if (flags & changed_cell)
+        put_name (out, t.cell);
+    if (flags & changed_worldspace)
+        put_name (out, t.worldspace);
+    put_signed (out, t.time - prev.time);
+    for (int i = 0; i < 3; ++i)
+        put_signed (out, std::int64_t (t.position[i]) - prev.position[i]);
+}
+
+static bool
+decode_point (const char*& p, const char* end, travel_point_t& t)
+{
+    if (p >= end)
+        return false;
+    auto flags = std::uint8_t (*p++);
+    if ((flags & changed_cell) && !get_name (p, end, t.cell))
+        return false;
+    if ((flags & changed_worldspace) && !get_name (p, end, t.worldspace))
+        return false;
+    std::int64_t d;
+    if (!get_signed (p, end, d))
+        return false;
+    t.time += d;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!get_signed (p, end, d))
+            return false;
+        t.position[i] += std::int32_t (d);
+    }
+    return true;
+}
+
+/// Appends to @param points, each batch starts over from zero
+static void
+decode_batch (std::string const& batch, std::uint32_t count, std::vector<travel_point_t>& points)
+{
+    const char* p = batch.data (), *end = p + batch.size ();
+    travel_point_t t = {};
+    for (std::uint32_t i = 0; i < count && decode_point (p, end, t); ++i)
+        points.push_back (t);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+flush_travel ()
+{
+    if (travel.batch.empty ())
+        return true;
+
+    std::string head;
+    std::ifstream fi (travel_location, std::ios::binary | std::ios::ate);
+    std::streamoff size = fi.is_open () ? std::streamoff (fi.tellg ()) : 0;
+    fi.close ();
+    if (size > log_bytes)
+    {
+        auto older = travel_location + ".1";
+        std::remove (older.c_str ());
+        if (std::rename (travel_location.c_str (), older.c_str ()) == 0)
+            size = 0;
+    }
+    if (size <= 0)
+    {
+        head.assign (travel_magic, sizeof (travel_magic));
+        head.append (reinterpret_cast<const char*> (&travel_version), sizeof (travel_version));
+    }
+    std::uint32_t sizes[2] = { std::uint32_t (travel.batch.size ()), travel.count };
+    head.append (reinterpret_cast<const char*> (sizes), sizeof (sizes));
+
+    std::ofstream of (travel_location, std::ios::binary | std::ios::app);
+    of << head << travel.batch;
+    bool ok = bool (of);
+    if (!ok)
+        log (log_warning) << "Unable to append the travel log to " << travel_location << '.'
+                          << std::endl;
+
+    travel.ring_size += travel.batch.size ();
+    travel.ring.emplace_back (travel.count, std::move (travel.batch));
+    while (travel.ring_size > ring_bytes && travel.ring.size () > 1)
+    {
+        travel.ring_size -= travel.ring.front ().second.size ();
+        travel.ring.pop_front ();
+    }
+    travel.batch.clear ();
+    travel.count = 0;
+    travel.have_last = false; // The next batch starts from zero
+    return ok;
+}
+
+static void
+close_travel ()
+{
+    flush_travel ();
+}
+
+void
+open_travel ()
+{
+    // After open_log(), so flushed before the log is closed
+    std::atexit (close_travel);
+}
+
+void
+tick_travel ()
+{
+    if (!journal.travel_log)
+        return;
+    auto now = profile_ticks ();
+    if (now < travel.next_ticks)
+        return;
+    travel.next_ticks = now + std::uint64_t (std::max (journal.travel_cadence, .1f) * 1e9);
+
+    if (!travel.batch.empty () && (travel.batch.size () >= batch_bytes
+                || (now - travel.batch_ticks) * 1e-9 >= batch_seconds))
+        flush_travel ();
+
+    sample_game_state ();
+    auto state = game_state ();
+    if (!state.time_ok || !state.position_ok)
+        return;
+
+    travel_point_t t;
+    t.time = std::int64_t (std::llround (double (state.time) * 86400));
+    for (int i = 0; i < 3; ++i)
+        t.position[i] = std::int32_t (std::lround (state.position[i]));
+    t.cell = state.cell;
+    t.worldspace = state.worldspace;
+
+    auto const& last = travel.last;
+    if (travel.have_last)
+    {
+        float dx = float (t.position[0] - last.position[0]),
+              dy = float (t.position[1] - last.position[1]),
+              dz = float (t.position[2] - last.position[2]);
+        bool moved = dx*dx + dy*dy + dz*dz >= travel_distance * travel_distance;
+        bool jumped = std::abs (t.time - last.time) >= travel_jump;
+        if (!moved && !jumped && t.cell == last.cell && t.worldspace == last.worldspace)
+            return;
+    }
+
+    if (travel.batch.empty ())
+        travel.batch_ticks = now;
+    encode_point (t, travel.have_last ? last : travel_point_t {}, travel.batch);
+    travel.last = std::move (t);
+    travel.have_last = true;
+    ++travel.count;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string
+travel_summary ()
+{
+    std::vector<travel_point_t> points;
+    for (auto const& b: travel.ring)
+        decode_batch (b.second, b.first, points);
+    decode_batch (travel.batch, travel.count, points);
+
+    std::string summary, place, last_place;
+    for (auto const& t: points)
+    {
+        place = t.cell.empty () ? t.worldspace : t.cell;
+        if (place.empty () || place == last_place)
+            continue;
+        last_place = place;
+        summary += "Arrived in " + place + ", ";
+        summary += game_date (float (t.time / 86400.), "%Y %lm %md");
+        summary += '\n';
+    }
+    return summary;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,731 @@
+/**
+ * @file truetype.cpp
+ * @brief TrueType faces rasterized into an Alpha8 atlas, apart from ImGui
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * Every ImGui allocation counts itself in the current context, hence its atlas can only be built
+ * on the render thread. This is the part of the ImGui build which takes the time, done on any
+ * thread: the glyphs are read from the "glyf" outlines, rasterized with exact area coverage (as
+ * stb_truetype does), and placed with the same metrics, horizontal oversampling and filtering as
+ * the ImGui 1.70 defaults, so the render thread only adds the finished glyphs to its ImFonts.
+ *
+ * Only TrueType outlines are read, the CFF ones (OpenType .otf) are refused. The built-in fonts
+ * are decoded as ImGui does for its binary_to_compressed_c output: base85, then stb_compress.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//--------------------------------------------------------------------------------------------------
+
+constexpr int oversample_h = 3;     ///< ImFontConfig::OversampleH default, vertical is one
+constexpr int max_composite = 8;    ///< Nesting of composite glyphs
+
+namespace {
+
+/// Big endian reads, zero past the end, so a broken file gives broken glyphs but no crash
+struct ttf_reader_t
+{
+    unsigned char const* p;
+    std::size_t size;
+
+    inline bool has (std::size_t off, std::size_t n) const {
+        return off <= size && n <= size - off;
+    }
+    inline std::uint8_t u8 (std::size_t off) const { return has (off, 1) ? p[off] : 0; }
+    inline std::uint16_t u16 (std::size_t off) const {
+        return has (off, 2) ? std::uint16_t (p[off] << 8 | p[off+1]) : 0;
+    }
+    inline std::int16_t s16 (std::size_t off) const { return std::int16_t (u16 (off)); }
+    inline std::uint32_t u32 (std::size_t off) const {
+        return std::uint32_t (u16 (off)) << 16 | u16 (off + 2);
+    }
+};
+
+struct outline_point_t
+{
+    float x, y;
+    bool on;
+};
+
+using contour_t = std::vector<outline_point_t>;
+
+class ttf_face_t
+{
+    ttf_reader_t r = {};
+    std::size_t cmap = 0, loca = 0, glyf = 0, hmtx = 0;
+    unsigned glyphs = 0, long_metrics = 0;
+    bool long_loca = false;
+
+    std::size_t
+    table (std::size_t font, const char* tag) const
+    {
+        for (unsigned i = 0, n = r.u16 (font + 4); i < n; ++i)
+        {
+            auto rec = font + 12 + 16 * i;
+            if (r.has (rec, 16) && !std::memcmp (r.p + rec, tag, 4))
+                return r.u32 (rec + 8);
+        }
+        return 0;
+    }
+
+    /// Byte range of the outline, empty for a glyph without any (e.g. space)
+    bool
+    glyph_range (unsigned g, std::size_t& from, std::size_t& to) const
+    {
+        if (g >= glyphs)
+            return false;
+        from = glyf + (long_loca ? r.u32 (loca + 4*g) : r.u16 (loca + 2*g) * 2u);
+        to   = glyf + (long_loca ? r.u32 (loca + 4*g + 4) : r.u16 (loca + 2*g + 2) * 2u);
+        return to > from && r.has (from, 10);
+    }
+
+    void
+    simple_outline (std::size_t at, int contours, std::vector<contour_t>& out) const
+    {
+        std::vector<unsigned> ends (contours);
+        for (int c = 0; c < contours; ++c)
+            ends[c] = r.u16 (at + 10 + 2*c);
+        unsigned count = contours ? ends.back () + 1 : 0;
+        auto p = at + 10 + 2*contours;
+        p += 2 + r.u16 (p); // The hinting instructions
+
+        std::vector<std::uint8_t> flags (count);
+        for (unsigned i = 0; i < count; )
+        {
+            auto f = r.u8 (p++);
+            unsigned repeat = f & 8 ? r.u8 (p++) : 0;
+            for (unsigned k = 0; k <= repeat && i < count; ++k)
+                flags[i++] = f;
+        }
+        std::vector<outline_point_t> points (count);
+        int v = 0;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            auto f = flags[i];
+            if (f & 2)
+                v += f & 16 ? r.u8 (p) : -r.u8 (p), p += 1;
+            else if (!(f & 16))
+                v += r.s16 (p), p += 2;
+            points[i].x = float (v);
+            points[i].on = f & 1;
+        }
+        v = 0;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            auto f = flags[i];
+            if (f & 4)
+                v += f & 32 ? r.u8 (p) : -r.u8 (p), p += 1;
+            else if (!(f & 32))
+                v += r.s16 (p), p += 2;
+            points[i].y = float (v);
+        }
+
+        unsigned first = 0;
+        for (auto end: ends)
+        {
+            if (end < first || end >= count)
+                break;
+            out.emplace_back (points.begin () + first, points.begin () + end + 1);
+            first = end + 1;
+        }
+    }
+
+    void
+    composite_outline (std::size_t p, int depth, std::vector<contour_t>& out) const
+    {
+        for (std::uint16_t flags = 0x20; flags & 0x20; )
+        {
+            flags = r.u16 (p);
+            unsigned g = r.u16 (p + 2);
+            p += 4;
+            float dx = 0, dy = 0;
+            if (flags & 1)
+            {
+                if (flags & 2)
+                    dx = r.s16 (p), dy = r.s16 (p + 2);
+                p += 4;
+            }
+            else
+            {
+                if (flags & 2)
+                    dx = std::int8_t (r.u8 (p)), dy = std::int8_t (r.u8 (p + 1));
+                p += 2;
+            }
+            // Matched points (no ARGS_ARE_XY_VALUES) are not supported, as by stb_truetype
+
+            auto f2dot14 = [this] (std::size_t at) { return r.s16 (at) / 16384.f; };
+            float a = 1, b = 0, c = 0, d = 1;
+            if (flags & 8)
+                a = d = f2dot14 (p), p += 2;
+            else if (flags & 0x40)
+                a = f2dot14 (p), d = f2dot14 (p + 2), p += 4;
+            else if (flags & 0x80)
+                a = f2dot14 (p), b = f2dot14 (p + 2), c = f2dot14 (p + 4), d = f2dot14 (p + 6),
+                p += 8;
+
+            auto from = out.size ();
+            outline (g, depth + 1, out);
+            for (auto i = from; i < out.size (); ++i)
+                for (auto& q: out[i])
+                {
+                    float x = q.x, y = q.y;
+                    q.x = a * x + c * y + dx;
+                    q.y = b * x + d * y + dy;
+                }
+        }
+    }
+
+public:
+    int ascent = 0, descent = 0;    ///< Of "hhea", in font units
+
+    bool
+    open (std::vector<char> const& ttf)
+    {
+        r = ttf_reader_t { reinterpret_cast<unsigned char const*> (ttf.data ()), ttf.size () };
+        std::size_t font = 0;
+        if (r.has (0, 4) && !std::memcmp (r.p, "ttcf", 4))
+            font = r.u32 (12); // The first of a collection, as ImGui takes
+        auto version = r.u32 (font);
+        if (version != 0x00010000 && version != 0x74727565) // 1.0 or "true", not "OTTO" (CFF)
+            return false;
+
+        cmap = table (font, "cmap");
+        loca = table (font, "loca");
+        glyf = table (font, "glyf");
+        hmtx = table (font, "hmtx");
+        auto head = table (font, "head"), hhea = table (font, "hhea"), maxp = table (font, "maxp");
+        if (!cmap || !loca || !glyf || !hmtx || !head || !hhea || !maxp)
+            return false;
+
+        long_loca = r.s16 (head + 50) != 0;
+        ascent = r.s16 (hhea + 4);
+        descent = r.s16 (hhea + 6);
+        long_metrics = r.u16 (hhea + 34);
+        glyphs = r.u16 (maxp + 4);
+
+        // As stb_truetype, the last Unicode subtable wins
+        std::size_t map = 0;
+        for (unsigned i = 0, n = r.u16 (cmap + 2); i < n; ++i)
+        {
+            auto rec = cmap + 4 + 8*i;
+            auto platform = r.u16 (rec), encoding = r.u16 (rec + 2);
+            if (platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10)))
+                map = cmap + r.u32 (rec + 4);
+        }
+        cmap = map;
+        return cmap && ascent != descent && long_metrics;
+    }
+
+    /// Zero if not in the font
+    unsigned
+    glyph_index (unsigned c) const
+    {
+        auto format = r.u16 (cmap);
+        if (format == 0)
+            return c < 256 ? r.u8 (cmap + 6 + c) : 0;
+        if (format == 6)
+        {
+            unsigned first = r.u16 (cmap + 6), n = r.u16 (cmap + 8);
+            return c >= first && c < first + n ? r.u16 (cmap + 10 + 2*(c - first)) : 0;
+        }
+        if (format == 4)
+        {
+            unsigned segments = r.u16 (cmap + 6) / 2;
+            auto ends = cmap + 14, starts = ends + 2*segments + 2;
+            auto deltas = starts + 2*segments, offsets = deltas + 2*segments;
+            unsigned lo = 0, hi = segments; // First segment ending at or after c
+            while (lo < hi)
+            {
+                auto mid = (lo + hi) / 2;
+                if (r.u16 (ends + 2*mid) < c)
+                    lo = mid + 1;
+                else hi = mid;
+            }
+            if (lo == segments || r.u16 (starts + 2*lo) > c)
+                return 0;
+            unsigned delta = r.u16 (deltas + 2*lo), offset = r.u16 (offsets + 2*lo);
+            if (!offset)
+                return (c + delta) & 0xffff;
+            unsigned g = r.u16 (offsets + 2*lo + offset + 2*(c - r.u16 (starts + 2*lo)));
+            return g ? (g + delta) & 0xffff : 0;
+        }
+        if (format == 12)
+        {
+            std::uint32_t lo = 0, hi = r.u32 (cmap + 12);
+            while (lo < hi)
+            {
+                auto mid = (lo + hi) / 2;
+                auto group = cmap + 16 + 12*std::size_t (mid);
+                if (c < r.u32 (group))
+                    hi = mid;
+                else if (c > r.u32 (group + 4))
+                    lo = mid + 1;
+                else return r.u32 (group + 8) + c - r.u32 (group);
+            }
+        }
+        return 0;
+    }
+
+    int
+    advance (unsigned g) const
+    {
+        return r.u16 (hmtx + 4 * std::min (g, long_metrics - 1));
+    }
+
+    /// The box of the outline in font units, false if it has none
+    bool
+    box (unsigned g, int& x0, int& y0, int& x1, int& y1) const
+    {
+        std::size_t from, to;
+        if (!glyph_range (g, from, to))
+            return false;
+        x0 = r.s16 (from + 2), y0 = r.s16 (from + 4);
+        x1 = r.s16 (from + 6), y1 = r.s16 (from + 8);
+        return x1 > x0 && y1 > y0;
+    }
+
+    void
+    outline (unsigned g, int depth, std::vector<contour_t>& out) const
+    {
+        std::size_t from, to;
+        if (depth > max_composite || !glyph_range (g, from, to))
+            return;
+        auto contours = r.s16 (from);
+        if (contours >= 0)
+            simple_outline (from, contours, out);
+        else composite_outline (from + 10, depth, out);
+    }
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/// Signed area coverage accumulated per cell, summed along the rows (as in font-rs or stb)
+class coverage_t
+{
+    int w, h, stride;
+    std::vector<float> cells;
+
+public:
+    coverage_t (int w, int h) : w (w), h (h), stride (w + 2), cells (std::size_t (stride) * h) {}
+
+    void
+    line (float x0, float y0, float x1, float y1)
+    {
+        if (y0 == y1)
+            return;
+        float dir = 1;
+        if (y0 > y1)
+            std::swap (x0, x1), std::swap (y0, y1), dir = -1;
+        float dxdy = (x1 - x0) / (y1 - y0);
+        float x = x0;
+        if (y0 < 0)
+            x -= y0 * dxdy;
+        for (int y = std::max (0, int (y0)), end = std::min (h, int (std::ceil (y1))); y < end; ++y)
+        {
+            auto row = &cells[std::size_t (y) * stride];
+            float dy = std::min (float (y + 1), y1) - std::max (float (y), y0);
+            float xnext = x + dxdy * dy;
+            float d = dy * dir;
+            float xa = std::clamp (std::min (x, xnext), 0.f, float (w));
+            float xb = std::clamp (std::max (x, xnext), 0.f, float (w));
+            x = xnext;
+
+            float xa_floor = std::floor (xa), xb_ceil = std::ceil (xb);
+            int ia = int (xa_floor), ib = int (xb_ceil);
+            if (ib <= ia + 1)
+            {
+                float xm = .5f * (xa + xb) - xa_floor;
+                row[ia] += d - d * xm;
+                row[ia + 1] += d * xm;
+                continue;
+            }
+            float s = 1.f / (xb - xa);
+            float fa = xa - xa_floor;
+            float a0 = .5f * s * (1 - fa) * (1 - fa);
+            float fb = xb - xb_ceil + 1;
+            float am = .5f * s * fb * fb;
+            row[ia] += d * a0;
+            if (ib == ia + 2)
+                row[ia + 1] += d * (1 - a0 - am);
+            else
+            {
+                float a1 = s * (1.5f - fa);
+                row[ia + 1] += d * (a1 - a0);
+                for (int i = ia + 2; i < ib - 1; ++i)
+                    row[i] += d * s;
+                float a2 = a1 + (ib - ia - 3) * s;
+                row[ib - 1] += d * (1 - a2 - am);
+            }
+            row[ib] += d * am;
+        }
+    }
+
+    void
+    quad (float x0, float y0, float cx, float cy, float x1, float y1)
+    {
+        float dx = x0 - 2*cx + x1, dy = y0 - 2*cy + y1;
+        float dev = dx*dx + dy*dy;
+        if (dev < .333f)
+        {
+            line (x0, y0, x1, y1);
+            return;
+        }
+        int n = 1 + int (std::sqrt (std::sqrt (3 * dev)));
+        float px = x0, py = y0;
+        for (int i = 1; i <= n; ++i)
+        {
+            float t = float (i) / n, u = 1 - t;
+            float qx = u*u*x0 + 2*u*t*cx + t*t*x1, qy = u*u*y0 + 2*u*t*cy + t*t*y1;
+            line (px, py, qx, qy);
+            px = qx, py = qy;
+        }
+    }
+
+    void
+    write (unsigned char* dst, int dst_stride) const
+    {
+        for (int y = 0; y < h; ++y)
+        {
+            auto row = &cells[std::size_t (y) * stride];
+            float sum = 0;
+            for (int x = 0; x < w; ++x)
+            {
+                sum += row[x];
+                dst[std::size_t (y) * dst_stride + x] =
+                    static_cast<unsigned char> (std::min (255.f, std::fabs (sum) * 255 + .5f));
+            }
+        }
+    }
+};
+
+/// Quadratic B-splines with implied on-curve points, as TrueType draws its contours
+template<class F>
+static void
+for_each_curve (contour_t const& contour, F&& transform, coverage_t& out)
+{
+    auto n = contour.size ();
+    if (n < 2)
+        return;
+    std::size_t first = 0;
+    while (first < n && !contour[first].on)
+        ++first;
+    auto mid = [] (outline_point_t a, outline_point_t b) {
+        return outline_point_t { (a.x + b.x) / 2, (a.y + b.y) / 2, true };
+    };
+    // Without any on-curve point, starts in between the first two
+    outline_point_t start = first < n ? contour[first] : mid (contour[0], contour[1]);
+    if (first == n)
+        first = 0;
+
+    auto cur = transform (start), ctrl = cur;
+    bool curved = false;
+    for (std::size_t k = 1; k <= n; ++k)
+    {
+        auto q = contour[(first + k) % n];
+        auto t = transform (q);
+        if (q.on)
+        {
+            if (curved)
+                out.quad (cur.x, cur.y, ctrl.x, ctrl.y, t.x, t.y);
+            else out.line (cur.x, cur.y, t.x, t.y);
+            cur = t, curved = false;
+        }
+        else if (curved)
+        {
+            outline_point_t m { (ctrl.x + t.x) / 2, (ctrl.y + t.y) / 2, true };
+            out.quad (cur.x, cur.y, ctrl.x, ctrl.y, m.x, m.y);
+            cur = m, ctrl = t;
+        }
+        else ctrl = t, curved = true;
+    }
+    if (curved)
+        out.quad (cur.x, cur.y, ctrl.x, ctrl.y, transform (start).x, transform (start).y);
+}
+
+/// Box filter over the oversampled columns, the last ones taking the spill of the glyph
+static void
+h_prefilter (unsigned char* p, int w, int h, int stride)
+{
+    for (int y = 0; y < h; ++y, p += stride)
+    {
+        unsigned window[oversample_h] = {};
+        unsigned total = 0;
+        for (int x = 0; x < w; ++x)
+        {
+            total += p[x] - window[x % oversample_h];
+            window[x % oversample_h] = p[x];
+            p[x] = static_cast<unsigned char> (total / oversample_h);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// A glyph on its way to the atlas
+struct placed_glyph_t
+{
+    unsigned codepoint, index;
+    std::size_t font;
+    float advance;
+    int ix0, iy0, w, h;     ///< Oversampled bitmap box, the width includes the filter spill
+    int x, y;               ///< In the atlas, once packed
+};
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+
+static inline unsigned
+decode85_byte (char c)
+{
+    return c >= '\\' ? c - 36 : c - 35;
+}
+
+static std::uint32_t
+adler32 (unsigned char const* p, std::size_t n)
+{
+    std::uint32_t a = 1, b = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        a = (a + p[i]) % 65521, b = (b + a) % 65521;
+    return b << 16 | a;
+}
+
+bool
+decompress_base85_ttf (const char* base85, std::vector<char>& ttf)
+{
+    ttf.clear ();
+    std::vector<unsigned char> in ((std::strlen (base85) + 4) / 5 * 4);
+    for (std::size_t i = 0; i < in.size (); i += 4, base85 += 5)
+    {
+        std::uint32_t v = decode85_byte (base85[0]) + 85 * (decode85_byte (base85[1])
+                + 85 * (decode85_byte (base85[2]) + 85 * (decode85_byte (base85[3])
+                + 85 * decode85_byte (base85[4]))));
+        for (int k = 0; k < 4; ++k)
+            in[i + k] = static_cast<unsigned char> (v >> 8*k);
+    }
+
+    // stb_compress: a header, then literal and match tokens, then the Adler-32 of the output
+    ttf_reader_t r { in.data (), in.size () };
+    if (r.u32 (0) != 0x57bc0000 || r.u32 (4) != 0)
+        return false;
+    std::size_t size = r.u32 (8);
+    std::vector<unsigned char> out;
+    out.reserve (size);
+    auto lit = [&] (std::size_t at, std::size_t n) {
+        if (!r.has (at, n) || out.size () + n > size)
+            return false;
+        out.insert (out.end (), in.begin () + at, in.begin () + at + n);
+        return true;
+    };
+    auto match = [&] (std::size_t distance, std::size_t n) {
+        if (distance > out.size () || out.size () + n > size)
+            return false;
+        for (auto from = out.size () - distance; n; --n)
+            out.push_back (out[from++]); // Overlapping on purpose, for runs
+        return true;
+    };
+    auto u24 = [&r] (std::size_t at) { return r.u8 (at) << 16 | r.u16 (at + 1); };
+
+    std::size_t i = 16;
+    for (bool ok = true; ok; )
+    {
+        unsigned t = r.u8 (i);
+        if (t >= 0x80)
+            ok = match (r.u8 (i+1) + 1u, t - 0x80 + 1u), i += 2;
+        else if (t >= 0x40)
+            ok = match (r.u16 (i) - 0x4000u + 1, r.u8 (i+2) + 1u), i += 3;
+        else if (t >= 0x20)
+            ok = lit (i+1, t - 0x20 + 1u), i += 1 + t - 0x20 + 1;
+        else if (t >= 0x18)
+            ok = match (u24 (i) - 0x180000u + 1, r.u8 (i+3) + 1u), i += 4;
+        else if (t >= 0x10)
+            ok = match (u24 (i) - 0x100000u + 1, r.u16 (i+3) + 1u), i += 5;
+        else if (t >= 0x08)
+            ok = lit (i+2, r.u16 (i) - 0x0800u + 1), i += 2 + r.u16 (i) - 0x0800 + 1;
+        else if (t == 0x07)
+            ok = lit (i+3, r.u16 (i+1) + 1u), i += 3 + r.u16 (i+1) + 1;
+        else if (t == 0x06)
+            ok = match (u24 (i+1) + 1u, r.u8 (i+4) + 1u), i += 5;
+        else if (t == 0x04)
+            ok = match (u24 (i+1) + 1u, r.u16 (i+4) + 1u), i += 6;
+        else if (t == 0x05 && r.u8 (i+1) == 0xfa)
+        {
+            if (out.size () != size || adler32 (out.data (), size) != r.u32 (i+2))
+                return false;
+            ttf.assign (out.begin (), out.end ());
+            return true;
+        }
+        else ok = false;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+is_truetype (std::vector<char> const& ttf)
+{
+    return ttf_face_t ().open (ttf);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+rasterize_atlas (std::vector<atlas_face_t> const& faces, std::vector<atlas_font_t>& fonts,
+        atlas_pixels_t& atlas)
+{
+    bool ok = true;
+    std::vector<ttf_face_t> ttfs (faces.size ());
+    std::vector<placed_glyph_t> placed;
+    std::vector<float> scales (faces.size ());
+    fonts.assign (faces.size (), atlas_font_t {});
+    std::vector<bool> seen (0x10000);
+    for (std::size_t f = 0; f < faces.size (); ++f)
+    {
+        auto& face = faces[f];
+        auto& ttf = ttfs[f];
+        if (!face.ttf || !ttf.open (*face.ttf))
+        {
+            ok = false;
+            continue;
+        }
+        // As ImGui: the height is from the ascent to the descent, rounded away from the baseline
+        float scale = scales[f] = face.size / float (ttf.ascent - ttf.descent);
+        fonts[f].ascent = std::floor (ttf.ascent * scale + (ttf.ascent > 0 ? 1 : -1));
+        fonts[f].descent = std::floor (ttf.descent * scale + (ttf.descent > 0 ? 1 : -1));
+
+        std::fill (seen.begin (), seen.end (), false);
+        for (auto range = face.ranges; range && range[0] && range[1]; range += 2)
+            for (unsigned c = range[0]; c <= range[1] && c < 0x10000; ++c)
+            {
+                auto g = seen[c] ? 0 : ttf.glyph_index (c);
+                seen[c] = true;
+                if (!g)
+                    continue;
+                placed_glyph_t p = { c, g, f, scale * ttf.advance (g), 0, 0, 0, 0, 0, 0 };
+                int x0, y0, x1, y1;
+                if (ttf.box (g, x0, y0, x1, y1))
+                {
+                    p.ix0 = int (std::floor (x0 * scale * oversample_h));
+                    p.iy0 = int (std::floor (-y1 * scale));
+                    p.w = int (std::ceil (x1 * scale * oversample_h)) - p.ix0 + oversample_h - 1;
+                    p.h = int (std::ceil (-y0 * scale)) - p.iy0;
+                }
+                placed.push_back (p);
+            }
+    }
+
+    // Shelves of the tallest glyphs first, on a texture as wide as ImGui would take
+    std::size_t surface = 0;
+    int widest = 0;
+    for (auto const& p: placed)
+    {
+        auto pad = faces[p.font].padding;
+        surface += std::size_t (p.w + 2*pad) * (p.h + 2*pad);
+        widest = std::max (widest, p.w + 2*pad);
+    }
+    auto fits = [surface] (double side) { return surface >= side * .7 * side * .7; };
+    int width = fits (4096) ? 4096 : fits (2048) ? 2048 : fits (1024) ? 1024 : 512;
+    while (width < widest + 4)
+        width *= 2;
+
+    std::vector<placed_glyph_t*> order;
+    for (auto& p: placed)
+        if (p.w > 0 && p.h > 0)
+            order.push_back (&p);
+    std::stable_sort (order.begin (), order.end (), [] (auto a, auto b) { return a->h > b->h; });
+
+    constexpr int white = 3; // A block of it at the top left, sampled at its middle
+    int x = white + 1, y = 0, shelf = white + 1;
+    for (auto p: order)
+    {
+        auto pad = faces[p->font].padding;
+        if (x + pad + p->w + pad > width)
+            x = 0, y += shelf, shelf = 0;
+        p->x = x + pad;
+        p->y = y + pad;
+        x += pad + p->w + pad;
+        shelf = std::max (shelf, pad + p->h + pad);
+    }
+    int height = 1;
+    while (height < y + shelf)
+        height *= 2;
+
+    atlas.width = width;
+    atlas.height = height;
+    atlas.alpha8.assign (std::size_t (width) * height, 0);
+    for (int wy = 0; wy < white; ++wy)
+        std::memset (&atlas.alpha8[std::size_t (wy) * width], 255, white);
+    atlas.uv_scale = ImVec2 { 1.f / width, 1.f / height };
+    atlas.uv_white = ImVec2 { 1.5f / width, 1.5f / height };
+
+    std::vector<contour_t> contours;
+    for (auto const& p: placed)
+    {
+        auto const& ttf = ttfs[p.font];
+        auto scale = scales[p.font];
+        if (p.w > 0 && p.h > 0)
+        {
+            contours.clear ();
+            ttf.outline (p.index, 0, contours);
+            int glyph_w = p.w - (oversample_h - 1);
+            coverage_t coverage (glyph_w, p.h);
+            auto to_bitmap = [&p, scale] (outline_point_t q) {
+                return outline_point_t {
+                    q.x * scale * oversample_h - p.ix0, -q.y * scale - p.iy0, q.on };
+            };
+            for (auto const& c: contours)
+                for_each_curve (c, to_bitmap, coverage);
+            auto dst = &atlas.alpha8[std::size_t (p.y) * width + p.x];
+            coverage.write (dst, width);
+            h_prefilter (dst, p.w, p.h, width);
+        }
+
+        // As stbtt_GetPackedQuad() and ImGui place it, the baseline at the rounded ascent
+        ImFontGlyph g = {};
+        g.Codepoint = ImWchar (p.codepoint);
+        g.AdvanceX = p.advance;
+        if (p.w > 0 && p.h > 0)
+        {
+            constexpr float shift = -(oversample_h - 1) / (2.f * oversample_h);
+            float top = float (int (fonts[p.font].ascent + .5f));
+            g.X0 = float (p.ix0) / oversample_h + shift;
+            g.X1 = float (p.ix0 + p.w) / oversample_h + shift;
+            g.Y0 = float (p.iy0) + top;
+            g.Y1 = float (p.iy0 + p.h) + top;
+            g.U0 = p.x * atlas.uv_scale.x;
+            g.V0 = p.y * atlas.uv_scale.y;
+            g.U1 = (p.x + p.w) * atlas.uv_scale.x;
+            g.V1 = (p.y + p.h) * atlas.uv_scale.y;
+        }
+        fonts[p.font].glyphs.push_back (g);
+    }
+    return ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
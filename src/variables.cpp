@@ -34,7 +34,9 @@
 #include <functional>
 #include <ctime>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
+#include <atomic>
 
 #include <windows.h>
 
@@ -120,60 +122,192 @@ struct relocation<const char*, 3> worldspace_name { 0x2f26ef8, 0x628, 0x28, 0x00
 
 //--------------------------------------------------------------------------------------------------
 
-/// Small utility function
+/**
+ * Double buffered: a sample is written into the slot not published, then published. A reader
+ * copies the published slot and retries in the rare case that it got overwritten meanwhile,
+ * i.e. when two more samples began during the copy.
+ */
+
+static struct
+{
+    game_state_t slots[2];
+    std::atomic<std::uint64_t> published, writing;
+}
+samples = {};
+
 static void
-replace_all (std::string& data, std::string const& search, std::string const& replace)
+copy_name (char (&dest)[128], const char* name)
 {
-    std::size_t n = data.find (search);
-    while (n != std::string::npos)
+    if (!name)
+        name = "";
+    std::size_t n = strnlen (name, sizeof (dest) - 1);
+    std::memcpy (dest, name, n);
+    dest[n] = 0;
+}
+
+void
+sample_game_state ()
+{
+    auto seq = samples.published.load (std::memory_order_relaxed) + 1;
+    samples.writing.store (seq, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    auto& s = samples.slots[seq & 1];
+    s = game_state_t {};
+    s.sample = seq;
+
+    // No game, as in the headless builds, no base address
+    float* epoch = skyrim_base && game_epoch.offsets[0] ? game_epoch.obtain () : nullptr;
+    if ((s.time_ok = epoch && std::isnormal (*epoch) && *epoch >= 0))
+        s.time = *epoch;
+
+    float* pos = skyrim_base && player_pos.offsets[0] ? player_pos.obtain () : nullptr;
+    if ((s.position_ok = pos
+                && std::isfinite (pos[0]) && std::isfinite (pos[1]) && std::isfinite (pos[2])))
     {
-        data.replace (n, search.size (), replace);
-        n = data.find (search, n + replace.size ());
+        std::copy (pos, pos + 3, s.position);
+        copy_name (s.worldspace, worldspace_name.obtain ());
+        copy_name (s.cell, player_cell.obtain ());
+    }
+
+    samples.published.store (seq, std::memory_order_release);
+}
+
+game_state_t
+game_state ()
+{
+    for (;;)
+    {
+        auto seq = samples.published.load (std::memory_order_acquire);
+        game_state_t s = samples.slots[seq & 1];
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (samples.writing.load (std::memory_order_relaxed) < seq + 2)
+            return s;
     }
 }
 
 //--------------------------------------------------------------------------------------------------
 
-/// It is too easy to crash, of the format is freely adjusted by the user
+void
+compile_format (format_t& format, std::string const& source,
+        const char* const* tokens, std::size_t count)
+{
+    format.source = source;
+    format.ops.clear ();
+    format.compiled = true;
+
+    auto literal = [&format] (std::size_t from, std::size_t to) {
+        if (to > from)
+            format.ops.push_back (format_t::op_t {
+                    format_t::literal, std::uint32_t (from), std::uint32_t (to - from) });
+    };
+    std::size_t text = 0;
+    for (std::size_t i = 0; i < source.size (); ++i)
+    {
+        if (source[i] != '%')
+            continue;
+        std::size_t best = count, best_size = 0;
+        for (std::size_t t = 0; t < count; ++t)
+        {
+            auto n = std::strlen (tokens[t]);
+            if (n > best_size && !source.compare (i + 1, n, tokens[t]))
+                best = t, best_size = n;
+        }
+        if (best == count)
+            continue;
+        literal (text, i);
+        format.ops.push_back (format_t::op_t { std::uint32_t (best), 0, 0 });
+        i += best_size;
+        text = i + 1;
+    }
+    literal (text, source.size ());
+}
 
-static std::string
-player_location (std::string format)
+void
+expand_format (format_t const& format, std::string_view const* values, std::string& out)
 {
-    float* pos = player_pos.obtain ();
-    if (!pos || !std::isfinite (pos[0]) || !std::isfinite (pos[1]) || !std::isfinite (pos[2]))
-        return "(n/a)";
+    std::size_t size = 0;
+    for (auto const& op: format.ops)
+        size += op.token == format_t::literal ? op.size : values[op.token].size ();
+    out.resize (size);
 
-    std::array<std::string, 3> sp;
-    for (int i = 0; i < 3; ++i)
+    char* p = &out[0];
+    for (auto const& op: format.ops)
     {
-        sp[i].resize (15);
-        sp[i].resize (std::snprintf (&sp[i][0], sp[i].size (), "%.0f", pos[i]));
+        auto v = op.token == format_t::literal
+            ? std::string_view (format.source.data () + op.offset, op.size) : values[op.token];
+        std::memcpy (p, v.data (), v.size ());
+        p += v.size ();
     }
+}
 
-    replace_all (format, "%x", sp[0]);
-    replace_all (format, "%y", sp[1]);
-    replace_all (format, "%z", sp[2]);
+//--------------------------------------------------------------------------------------------------
 
-    replace_all (format, "%cx", std::to_string (int (std::floor (pos[0]/4096))));
-    replace_all (format, "%cy", std::to_string (int (std::floor (pos[1]/4096))));
+/// Recompiles only if the parameters got edited since
+template<std::size_t N>
+static format_t&
+variable_format (variable_t* self, std::array<const char*, N> const& tokens)
+{
+    if (!self->format.compiled || self->format.source != self->params)
+        compile_format (self->format, self->params, tokens.data (), tokens.size ());
+    return self->format;
+}
 
-    if (auto name = worldspace_name.obtain ())
-         replace_all (format, "%wn", name);
-    else replace_all (format, "%wn", "");
+/// The numbers are printed into small buffers of the caller
+using number_t = char[32];
 
-    if (auto name = player_cell.obtain ())
-         replace_all (format, "%cn", name);
-    else replace_all (format, "%cn", "");
+template<class T>
+static std::string_view
+print (number_t& buf, const char* format, T value)
+{
+    int n = std::snprintf (buf, sizeof (buf), format, value);
+    return std::string_view (buf, std::size_t (std::clamp (n, 0, int (sizeof (buf)) - 1)));
+}
 
-    return format;
+/// Into the output of @param format, it being per variable
+static std::string_view
+expand_variable (format_t& format, std::string_view const* values)
+{
+    expand_format (format, values, format.out);
+    return format.out;
 }
 
 //--------------------------------------------------------------------------------------------------
 
-static std::string
-local_time (const char* format, std::tm& lt)
+/// It is too easy to crash, of the format is freely adjusted by the user
+
+static std::string_view
+player_location (variable_t* self)
+{
+    static alloc_site_t site ("player_location");
+    alloc_scope_t allocs (site);
+    auto state = game_state ();
+    if (!state.position_ok)
+        return "(n/a)";
+    auto const* pos = state.position;
+
+    enum { x, y, z, cx, cy, wn, cn, count };
+    static const std::array<const char*, count> tokens = { "x", "y", "z", "cx", "cy", "wn", "cn" };
+    auto& format = variable_format (self, tokens);
+
+    std::string_view values[count];
+    number_t numbers[5];
+    for (int i = 0; i < 3; ++i)
+        values[x + i] = print (numbers[i], "%.0f", pos[i]);
+    values[cx] = print (numbers[3], "%d", int (std::floor (pos[0]/4096)));
+    values[cy] = print (numbers[4], "%d", int (std::floor (pos[1]/4096)));
+
+    values[wn] = state.worldspace;
+    values[cn] = state.cell;
+
+    return expand_variable (format, values);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void
+local_time (const char* format, std::tm const& lt, std::string& s)
 {
-    std::string s;
     std::size_t n = 16;
     do
     {
@@ -186,7 +320,6 @@ local_time (const char* format, std::tm& lt)
         n *= 2;
     }
     while (n < 512);
-    return s;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -194,83 +327,121 @@ local_time (const char* format, std::tm& lt)
 /**
  * Very simple custom formatted time printing for the Skyrim calendar.
  *
- * Preparses some stuff before calling back strftime()
+ * The format is compiled once per edit of the parameters, then each call is a single pass.
  */
 
-static std::string
-game_time (std::string format)
+/// Token indices of the game time format
+struct game_token
 {
-    float* source = game_epoch.obtain ();
-    if (!source || !std::isnormal (*source) || *source < 0)
-        return "(n/a)";
+    enum { y, Y, lm, bm, am, mo, md, sd, ld, wd, h, m, s, ri, r, count };
+};
+static const std::array<const char*, game_token::count> game_time_names = {
+    "y", "Y", "lm", "bm", "am", "mo", "md", "sd", "ld", "wd", "h", "m", "s", "ri", "r" };
+
+/// Day of the year each month ends with
+static const std::array<int, 12> month_ends = {
+    31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 };
+
+static const std::array<const char*, 12> longmon = {
+    "Morning Star", "Sun's Dawn", "First Seed", "Rain's Hand", "Second Seed", "Midyear",
+    "Sun's Height", "Last Seed", "Hearthfire", "Frostfall", "Sun's Dusk", "Evening Star"
+};
+
+static std::string_view
+expand_game_time (float const* source, format_t& format)
+{
+    using t = game_token;
 
     // Compute the format input
     float hms = *source - int (*source);
-    int h = int (hms *= 24);
+    int hour = int (hms *= 24);
     hms  -= int (hms);
-    int m = int (hms *= 60);
+    int min = int (hms *= 60);
     hms  -= int (hms);
-    int s = int (hms * 60);
+    int sec = int (hms * 60);
 
     // Adjusts for starting date: Sun, 17 Jul 201 (considering that the year starts Wed)
     int d = int (*source) + 228;
-    int y = d / 365 + 201;
+    int year = d / 365 + 201;
     int yd = d % 365 + 1;
-    int wd = (d+3) % 7;
-
-    std::array<int, 12> months = { 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 };
-    auto mit = std::lower_bound (months.cbegin (), months.cend (), yd);
-    int mo = mit - months.cbegin ();
-    int md = (mo ? yd-*(mit-1) : yd);
-
-    // Replace years
-    auto sy = std::to_string (y);
-    auto sY = "4E" + sy;
-    replace_all (format, "%y", sy);
-    replace_all (format, "%Y", sY);
-
-    // Replace months
-    static std::array<std::string, 12> longmon = {
-        "Morning Star", "Sun's Dawn", "First Seed", "Rain's Hand", "Second Seed", "Midyear",
-        "Sun's Height", "Last Seed", "Hearthfire", "Frostfall", "Sun's Dusk", "Evening Star"
-    };
-    static std::array<std::string, 12> birtmon = {
+    int wday = (d+3) % 7;
+
+    auto mit = std::lower_bound (month_ends.cbegin (), month_ends.cend (), yd);
+    int mon = mit - month_ends.cbegin ();
+    int mday = (mon ? yd-*(mit-1) : yd);
+
+    static const std::array<const char*, 12> birtmon = {
         "The Ritual", "The Lover", "The Lord", "The Mage", "The Shadow", "The Steed",
         "The Apprentice", "The Warrior", "The Lady", "The Tower", "The Atronach", "The Thief"
     };
-    static std::array<std::string, 12> argomon = {
+    static const std::array<const char*, 12> argomon = {
         "Vakka (Sun)", "Xeech (Nut)", "Sisei (Sprout)", "Hist-Deek (Hist Sapling)",
         "Hist-Dooka (Mature Hist)", "Hist-Tsoko (Elder Hist)", "Thtithil-Gah (Egg-Basket)",
         "Thtithil (Egg)", "Nushmeeko (Lizard)", "Shaja-Nushmeeko (Semi-Humanoid Lizard)",
         "Saxhleel (Argonian)", "Xulomaht (The Deceased)"
     };
-    replace_all (format, "%lm", longmon[mo]);
-    replace_all (format, "%bm", birtmon[mo]);
-    replace_all (format, "%am", argomon[mo]);
-    replace_all (format, "%mo", std::to_string (mo+1));
-    replace_all (format, "%md", std::to_string (md));
-
-    // Weekdays
-    static std::array<std::string, 7> longwday = {
+    static const std::array<const char*, 7> longwday = {
         "Sundas", "Morndas", "Tirdas", "Middas", "Turdas", "Fredas", "Loredas"
     };
-    static std::array<std::string, 7> shrtwday = {
+    static const std::array<const char*, 7> shrtwday = {
         "Sun", "Mor", "Tir", "Mid", "Tur", "Fre", "Lor"
     };
-    replace_all (format, "%sd", shrtwday[wd]);
-    replace_all (format, "%ld", longwday[wd]);
-    replace_all (format, "%wd", std::to_string (wd+1));
 
-    // Time
-    replace_all (format, "%h", std::to_string (h));
-    replace_all (format, "%m", std::to_string (m));
-    replace_all (format, "%s", std::to_string (s));
+    std::string_view values[t::count];
+    number_t numbers[t::count];
+    values[t::y]  = print (numbers[t::y], "%d", year);
+    values[t::Y]  = print (numbers[t::Y], "4E%d", year);
+    values[t::lm] = longmon[mon];
+    values[t::bm] = birtmon[mon];
+    values[t::am] = argomon[mon];
+    values[t::mo] = print (numbers[t::mo], "%d", mon+1);
+    values[t::md] = print (numbers[t::md], "%d", mday);
+    values[t::sd] = shrtwday[wday];
+    values[t::ld] = longwday[wday];
+    values[t::wd] = print (numbers[t::wd], "%d", wday+1);
+    values[t::h]  = print (numbers[t::h], "%d", hour);
+    values[t::m]  = print (numbers[t::m], "%d", min);
+    values[t::s]  = print (numbers[t::s], "%d", sec);
+    values[t::ri] = print (numbers[t::ri], "%d", d);
+    values[t::r]  = print (numbers[t::r], "%f", double (*source));
+
+    return expand_variable (format, values);
+}
 
-    // Raw
-    replace_all (format, "%ri", std::to_string (d));
-    replace_all (format, "%r", std::to_string (*source));
+static std::string_view
+game_time (variable_t* self)
+{
+    static alloc_site_t site ("game_time");
+    alloc_scope_t allocs (site);
+    auto state = game_state ();
+    if (!state.time_ok)
+        return "(n/a)";
+    return expand_game_time (&state.time, variable_format (self, game_time_names));
+}
 
-    return format;
+/// Render thread, the last format stays compiled as it is likely the same for a whole list
+std::string_view
+game_date (float time, const char* format)
+{
+    static format_t f;
+    if (!f.compiled || f.source != format)
+        compile_format (f, format, game_time_names.data (), game_time_names.size ());
+    return expand_game_time (&time, f);
+}
+
+const char*
+game_month_name (int month)
+{
+    return month >= 0 && month < 12 ? longmon[month] : "";
+}
+
+void
+game_month_range (int year, int month, float& from, float& to)
+{
+    // The inverse of the calendar above, day zero being the 228th of 4E201
+    int d = (year - 201) * 365 + (month ? month_ends[month-1] : 0) - 228;
+    from = float (d);
+    to = float (d + month_ends[month] - (month ? month_ends[month-1] : 0));
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -279,8 +450,17 @@ std::string
 local_time (const char* format)
 {
     std::time_t t = std::time (nullptr);
-    std::tm* lt = std::localtime (&t);
-    return local_time (format, *lt);
+    std::string s;
+    local_time (format, *std::localtime (&t), s);
+    return s;
+}
+
+static std::string_view
+local_time_variable (variable_t* self)
+{
+    std::time_t t = std::time (nullptr);
+    local_time (self->params.c_str (), *std::localtime (&t), self->format.out);
+    return self->format.out;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -288,6 +468,7 @@ local_time (const char* format)
 std::vector<variable_t>
 make_variables ()
 {
+    trace_span_t span ("make_variables");
     skyrim_base = reinterpret_cast<std::uintptr_t> (::GetModuleHandle (nullptr));
     std::vector<variable_t> vars;
 
@@ -310,6 +491,7 @@ make_variables ()
         variable_t gtime;
         gtime.fuid = 1;
         gtime.deletable = false;
+        gtime.key = "game_time";
         gtime.name = "Game time (fixed)";
         gtime.info = "Following substitions starts with %:\n"
             "y is the year number (e.g. 201)\n"
@@ -328,7 +510,7 @@ make_variables ()
             "r is the raw input (aka Papyrus.GetCurrentGameTime ())\n"
             "ri is the integer part of %r (i.e. game days since start)";
         gtime.params = "%h:%m %ld, day %md of %lm, %Y";
-        gtime.apply = [] (variable_t* self) { return game_time (self->params); };
+        gtime.apply = game_time;
         vars.emplace_back (std::move (gtime));
     }
     if (player_pos.offsets[0])
@@ -336,6 +518,7 @@ make_variables ()
         variable_t ppos;
         ppos.fuid = 3;
         ppos.deletable = false;
+        ppos.key = "location";
         ppos.name = "Player position (fixed)";
         ppos.info = "The World/cell/XYZ coordinates of the player.\n"
             "This is the same as the Console \"player.getpos <axis>\"\n"
@@ -344,18 +527,19 @@ make_variables ()
             "%cn current cell name, if any\n"
             "%wn world space name if any";
         ppos.params = "%wn, %cn: %x %y %z";
-        ppos.apply = [] (variable_t* self) { return player_location (self->params); };
+        ppos.apply = player_location;
         vars.emplace_back (std::move (ppos));
     }
 
     variable_t ltime;
     ltime.fuid = 2;
     ltime.deletable = false;
+    ltime.key = "local_time";
     ltime.name = "Local time (fixed)";
     ltime.info = "Look the format specification on\n"
         "https://en.cppreference.com/w/cpp/chrono/c/strftime";
     ltime.params = "%X %x";
-    ltime.apply = [] (variable_t* self) { return local_time (self->params.c_str ()); };
+    ltime.apply = local_time_variable;
     vars.emplace_back (std::move (ltime));
 
     return vars;
@@ -363,3 +547,105 @@ make_variables ()
 
 //--------------------------------------------------------------------------------------------------
 
+/// Stable across sessions, as the saved copies refer to it, and apart from the built-in ones
+static int
+provider_fuid (std::string const& name)
+{
+    std::uint32_t h = 2166136261u; // FNV-1a
+    for (unsigned char c: name)
+        h = (h ^ c) * 16777619u;
+    return int (0x40000000u | (h & 0x3fffffffu));
+}
+
+/// Up to this many parameters cached per provider, i.e. copies of its variable in use
+constexpr std::size_t provider_cache_size = 8;
+
+static std::string_view
+provide (provider_t& p, std::string const& params)
+{
+    static alloc_site_t site ("provider_variable");
+    alloc_scope_t allocs (site);
+
+    auto now = profile_ticks ();
+    auto it = std::find_if (p.cache.begin (), p.cache.end (), [&params] (auto const& c) {
+        return c.params == params;
+    });
+    if (it == p.cache.end ())
+    {
+        if (p.cache.size () < provider_cache_size)
+            it = p.cache.emplace (p.cache.end ());
+        else
+            it = std::min_element (p.cache.begin (), p.cache.end (), [] (auto const& a, auto const& b) {
+                return a.expires < b.expires;
+            });
+        it->params = params;
+        it->expires = 0;
+    }
+    else if (now < it->expires)
+        return it->ok ? std::string_view (it->value) : "(n/a)";
+
+    // The value string is the buffer, grown only when a value did not fit
+    auto& v = it->value;
+    v.resize (std::max<std::size_t> (v.capacity (), 64));
+    auto n = p.evaluate (p.context, params.c_str (), &v[0], std::uint32_t (v.size ()));
+    if (n > std::int32_t (v.size ()))
+    {
+        v.resize (std::size_t (n));
+        n = p.evaluate (p.context, params.c_str (), &v[0], std::uint32_t (v.size ()));
+    }
+    it->ok = n >= 0;
+    v.resize (std::size_t (std::clamp<std::int32_t> (n, 0, std::int32_t (v.size ()))));
+    it->expires = now + std::uint64_t (p.ttl * 1e9);
+    return it->ok ? std::string_view (v) : "(n/a)";
+}
+
+void
+add_provider (std::shared_ptr<provider_t> provider)
+{
+    auto fuid = provider_fuid (provider->name);
+    auto apply = [provider] (variable_t* self) { return provide (*provider, self->params); };
+
+    // Rebinds also the copies made by the user, the variables hold the provider alive
+    bool found = false;
+    for (auto& v: journal.variables)
+        if (v.fuid == fuid)
+        {
+            v.apply = apply;
+            if (!v.deletable)
+                v.info = provider->info, found = true;
+        }
+    invalidate_placeholders ();
+    if (found)
+    {
+        log () << "Variable provider " << provider->name << " registered again." << std::endl;
+        return;
+    }
+
+    variable_t var;
+    var.fuid = fuid;
+    var.deletable = false;
+    var.name = provider->name;
+    var.info = provider->info;
+    var.params = provider->params;
+    var.apply = apply;
+    journal.variables.push_back (var);
+
+    // The copies saved before its plugin got around to register, they go first as when loaded
+    auto& u = journal.unclaimed_variables;
+    auto claimed = std::stable_partition (u.begin (), u.end (), [fuid] (auto const& v) {
+        return v.fuid != fuid;
+    });
+    for (auto i = claimed; i != u.end (); ++i)
+    {
+        i->apply = apply;
+        i->info = provider->info;
+    }
+    journal.variables.insert (journal.variables.begin (),
+            std::make_move_iterator (claimed), std::make_move_iterator (u.end ()));
+    u.erase (claimed, u.end ());
+
+    log () << "Added variable provider " << provider->name << '.' << std::endl;
+}
+
+//--------------------------------------------------------------------------------------------------
+
@@ -0,0 +1,391 @@
+/**
+ * @file watcher.cpp
+ * @brief Incremental directory listings for the images and books pickers
+ * @internal
+ *
+ * This file is part of Skyrim SE Journal mod (aka Journal).
+ *
+ *   Journal is free software: you can redistribute it and/or modify it
+ *   under the terms of the GNU Lesser General Public License as published
+ *   by the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Journal is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with Journal. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @endinternal
+ *
+ * @ingroup Core
+ *
+ * @details
+ * On Windows the directory is watched through overlapped ReadDirectoryChangesW() which is checked
+ * without blocking on each poll, so only the actual changes are applied to the list. Anywhere else,
+ * or if the notification handle can't be obtained, the directory is rescanned periodically and
+ * diffed against the current list, which produces the very same events.
+ */
+
+#include "sse-journal.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <iterator>
+
+#if defined(SSEIMGUI_WINDOWS)
+#  include <windows.h>
+#else
+#  include <dirent.h>
+#  include <sys/stat.h>
+#endif
+
+//--------------------------------------------------------------------------------------------------
+
+static std::uint64_t
+steady_ms ()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds> (steady_clock::now ().time_since_epoch ()).count ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Windows does not care about the letter case, the users neither
+
+static bool
+ends_with_nocase (std::string const& s, std::string const& suffix)
+{
+    if (s.size () < suffix.size ())
+        return false;
+    return std::equal (suffix.cbegin (), suffix.cend (), s.cend () - suffix.size (),
+            [] (char a, char b) {
+                return std::tolower (static_cast<unsigned char> (a))
+                    == std::tolower (static_cast<unsigned char> (b));
+            });
+}
+
+/// A bare extension is no name, for both the listings and the notifications
+static bool
+has_extension (std::string const& filename, std::string const& extension)
+{
+    return filename.size () > extension.size () && ends_with_nocase (filename, extension);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+#if defined(SSEIMGUI_WINDOWS)
+
+static bool
+enumerate_files (std::string const& directory, std::vector<std::string>& out)
+{
+    std::wstring w;
+    if (!utf8_to_utf16 ((directory + "*").c_str (), w))
+        return false;
+    out.clear ();
+    WIN32_FIND_DATA fd;
+    auto h = ::FindFirstFile (w.c_str (), &fd);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+    do
+    {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        std::string s;
+        if (!utf16_to_utf8 (fd.cFileName, s))
+            break;
+        out.emplace_back (std::move (s));
+    }
+    while (::FindNextFile (h, &fd));
+    auto e = ::GetLastError ();
+    ::FindClose (h);
+    return e == ERROR_NO_MORE_FILES;
+}
+
+#else
+
+static bool
+enumerate_files (std::string const& directory, std::vector<std::string>& out)
+{
+    out.clear ();
+    auto d = ::opendir (directory.c_str ());
+    if (!d)
+        return false;
+    while (auto e = ::readdir (d))
+    {
+        struct stat st;
+        if (::stat ((directory + e->d_name).c_str (), &st) == 0 && S_ISREG (st.st_mode))
+            out.emplace_back (e->d_name);
+    }
+    ::closedir (d);
+    return true;
+}
+
+#endif
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+enumerate_filenames (
+        std::string const& directory, std::string const& extension, std::vector<std::string>& out)
+{
+    std::vector<std::string> all;
+    bool ok = enumerate_files (directory, all);
+    out.clear ();
+    for (auto& name: all)
+        if (has_extension (name, extension))
+        {
+            name.erase (name.size () - extension.size ());
+            out.emplace_back (std::move (name));
+        }
+    std::sort (out.begin (), out.end ());
+    return ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+directory_watch_t::open (std::string const& directory, std::string const& extension)
+{
+    close ();
+    this->directory = directory;
+    this->extension = extension;
+    opened = true;
+    bool ok = enumerate_filenames (directory, extension, files);
+    last_scan = steady_ms ();
+    if (!native_open ())
+        log () << "No change notifications for " << directory << ", polling it." << std::endl;
+    return ok;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void
+directory_watch_t::close ()
+{
+    native_close ();
+    opened = false;
+    files.clear ();
+    changes.clear ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+directory_watch_t::matches (std::string const& filename) const
+{
+    return has_extension (filename, extension);
+}
+
+bool
+directory_watch_t::insert (std::string name)
+{
+    auto it = std::lower_bound (files.begin (), files.end (), name);
+    if (it != files.end () && *it == name)
+        return false;
+    files.emplace (it, std::move (name));
+    return true;
+}
+
+bool
+directory_watch_t::erase (std::string const& name)
+{
+    auto it = std::lower_bound (files.begin (), files.end (), name);
+    if (it == files.end () || *it != name)
+        return false;
+    files.erase (it);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/// Fallback, diffs a fresh listing against the current one
+
+bool
+directory_watch_t::rescan ()
+{
+    std::vector<std::string> now;
+    enumerate_filenames (directory, extension, now);
+    last_scan = steady_ms ();
+
+    std::vector<std::string> gone, fresh;
+    std::set_difference (files.cbegin (), files.cend (), now.cbegin (), now.cend (),
+            std::back_inserter (gone));
+    std::set_difference (now.cbegin (), now.cend (), files.cbegin (), files.cend (),
+            std::back_inserter (fresh));
+
+    // A single pair of remove & add within a period is most likely a rename
+    if (gone.size () == 1 && fresh.size () == 1)
+        changes.push_back (event_t { renamed, fresh.front (), gone.front () });
+    else
+    {
+        for (auto& n: gone)
+            changes.push_back (event_t { removed, std::move (n), {} });
+        for (auto& n: fresh)
+            changes.push_back (event_t { added, std::move (n), {} });
+    }
+
+    files = std::move (now);
+    return !changes.empty ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool
+directory_watch_t::poll ()
+{
+    changes.clear ();
+    if (!opened)
+        return false;
+    if (native)
+        return native_poll ();
+    if (steady_ms () - last_scan < poll_interval_ms)
+        return false;
+    return rescan ();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+#if defined(SSEIMGUI_WINDOWS)
+
+struct native_watch_t
+{
+    HANDLE dir;
+    OVERLAPPED ov;
+    std::string pending_rename; ///< Old name in between the two rename notifications
+    alignas (DWORD) std::array<char, 16*1024> buff;
+};
+
+static bool
+issue_read (native_watch_t* w)
+{
+    w->ov = OVERLAPPED {};
+    return ::ReadDirectoryChangesW (w->dir, w->buff.data (), DWORD (w->buff.size ()), FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &w->ov, nullptr);
+}
+
+bool
+directory_watch_t::native_open ()
+{
+    std::wstring w;
+    if (!utf8_to_utf16 (directory.c_str (), w))
+        return false;
+    auto h = ::CreateFileW (w.c_str (), FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+    auto nw = new native_watch_t;
+    nw->dir = h;
+    if (!issue_read (nw))
+    {
+        ::CloseHandle (h);
+        delete nw;
+        return false;
+    }
+    native = nw;
+    return true;
+}
+
+void
+directory_watch_t::native_close ()
+{
+    if (!native)
+        return;
+    auto nw = static_cast<native_watch_t*> (native);
+    ::CancelIo (nw->dir);
+    DWORD n;
+    ::GetOverlappedResult (nw->dir, &nw->ov, &n, TRUE); // The buffer must outlive the request
+    ::CloseHandle (nw->dir);
+    delete nw;
+    native = nullptr;
+}
+
+bool
+directory_watch_t::native_poll ()
+{
+    auto nw = static_cast<native_watch_t*> (native);
+    DWORD n = 0;
+    if (!::GetOverlappedResult (nw->dir, &nw->ov, &n, FALSE))
+    {
+        if (::GetLastError () == ERROR_IO_INCOMPLETE)
+            return false;
+        log () << "Watching " << directory << " failed, polling it." << std::endl;
+        native_close ();
+        return rescan ();
+    }
+
+    // Zero bytes on success means the buffer overflowed and notifications were dropped
+    if (!n)
+    {
+        rescan ();
+        if (!issue_read (nw))
+            native_close ();
+        return !changes.empty ();
+    }
+
+    for (auto p = nw->buff.data (); ; )
+    {
+        auto fni = reinterpret_cast<FILE_NOTIFY_INFORMATION const*> (p);
+        std::wstring wname (fni->FileName, fni->FileNameLength / sizeof (wchar_t));
+        std::string name;
+        utf16_to_utf8 (wname.c_str (), name);
+        bool relevant = matches (name);
+        if (relevant)
+            name.erase (name.size () - extension.size ());
+
+        switch (fni->Action)
+        {
+            case FILE_ACTION_ADDED:
+                if (relevant && insert (name)) // Not again, as with the rescans
+                    changes.push_back (event_t { added, name, {} });
+                break;
+            case FILE_ACTION_REMOVED:
+                if (relevant && erase (name))
+                    changes.push_back (event_t { removed, name, {} });
+                break;
+            case FILE_ACTION_RENAMED_OLD_NAME:
+                nw->pending_rename.clear ();
+                if (relevant && erase (name))
+                    nw->pending_rename = name;
+                break;
+            case FILE_ACTION_RENAMED_NEW_NAME:
+            {
+                bool fresh = relevant && insert (name);
+                if (relevant && !nw->pending_rename.empty ())
+                    changes.push_back (event_t { renamed, name, nw->pending_rename });
+                else if (fresh)
+                    changes.push_back (event_t { added, name, {} });
+                else if (!nw->pending_rename.empty ())
+                    changes.push_back (event_t { removed, nw->pending_rename, {} });
+                nw->pending_rename.clear ();
+                break;
+            }
+        }
+
+        if (!fni->NextEntryOffset)
+            break;
+        p += fni->NextEntryOffset;
+    }
+
+    if (!issue_read (nw))
+    {
+        native_close ();
+        rescan ();
+    }
+    return !changes.empty ();
+}
+
+#else
+
+bool directory_watch_t::native_open () { return false; }
+void directory_watch_t::native_close () {}
+bool directory_watch_t::native_poll () { return rescan (); }
+
+#endif
+
+//--------------------------------------------------------------------------------------------------
+